@@ -0,0 +1,83 @@
+/// \author Jian Wen
+/// \date 2021/02/17
+
+#include "../src/demand_generator.hpp"
+
+#include <benchmark/benchmark.h>
+
+static void BenchmarkDemandGenerator(benchmark::State &state) {
+    // Set up the demand generator with the given number of ODs of random intensities.
+    const auto num_ods = static_cast<size_t>(state.range(0));
+
+    std::vector<Od> ods;
+    std::vector<double> trips_per_hour;
+    for (auto i = 0; i < num_ods; i++) {
+        ods.emplace_back(Od{Pos{114.1f + 0.2f * i / num_ods, 22.2f}, Pos{114.3f, 22.35f}});
+        trips_per_hour.emplace_back(1.0 + rand() % 100);
+    }
+
+    // 3.6 million trips per hour in total, aka 1 trip per millisecond.
+    const auto total_trips_per_hour = 3600000.0;
+    const auto scale = total_trips_per_hour / (50.5 * num_ods);
+    for (auto &t : trips_per_hour) {
+        t *= scale;
+    }
+
+    DemandGenerator demand_generator{std::move(ods), trips_per_hour, 0};
+
+    uint64_t system_time_ms = 0;
+    int64_t num_requests = 0;
+
+    for (auto _ : state) {
+        // Time the code
+        system_time_ms += 1000;
+        auto requests = demand_generator(system_time_ms);
+        num_requests += requests.size();
+
+        benchmark::DoNotOptimize(requests.data());
+    }
+
+    state.SetItemsProcessed(num_requests);
+}
+
+static void BenchmarkDemandGeneratorThreads(benchmark::State &state) {
+    // Set up the demand generator with 100k ODs and the given number of threads.
+    const auto num_ods = 100000;
+    const auto num_threads = static_cast<size_t>(state.range(0));
+
+    std::vector<Od> ods;
+    std::vector<double> trips_per_hour;
+    for (auto i = 0; i < num_ods; i++) {
+        ods.emplace_back(Od{Pos{114.1f + 0.2f * i / num_ods, 22.2f}, Pos{114.3f, 22.35f}});
+        trips_per_hour.emplace_back(36.0);
+    }
+
+    int64_t num_requests = 0;
+
+    for (auto _ : state) {
+        // Time the code generating two hours of demand at 3.6 million trips per hour, in 30-second
+        // cycles as the platform does.
+        DemandGenerator demand_generator{ods, trips_per_hour, 0, 0, num_threads};
+        for (auto time_ms = 30000; time_ms <= 2 * 3600 * 1000; time_ms += 30000) {
+            auto requests = demand_generator(time_ms);
+            num_requests += requests.size();
+
+            benchmark::DoNotOptimize(requests.data());
+        }
+    }
+
+    state.SetItemsProcessed(num_requests);
+}
+
+// Register the function as a benchmark, with the number of ODs growing from 10 to 1 million.
+BENCHMARK(BenchmarkDemandGenerator)->RangeMultiplier(10)->Range(10, 1000000);
+
+// Register the function as a benchmark, with the number of threads growing from 1 to 8.
+BENCHMARK(BenchmarkDemandGeneratorThreads)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Run the benchmark
+BENCHMARK_MAIN();
@@ -0,0 +1,118 @@
+/// \author Jian Wen
+/// \date 2021/02/24
+
+#include "../src/dispatch.hpp"
+#include "straight_line_router.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+namespace {
+
+/// \brief The area of Hong Kong as in the demo config.
+const AreaConfig kArea{114.10, 114.30, 22.20, 22.35};
+
+Pos get_random_pos(std::mt19937 &rng) {
+    std::uniform_real_distribution<float> lon(kArea.lon_min, kArea.lon_max);
+    std::uniform_real_distribution<float> lat(kArea.lat_min, kArea.lat_max);
+
+    return Pos{lon(rng), lat(rng)};
+}
+
+} // namespace
+
+static void BenchmarkDispatch(benchmark::State &state) {
+    // Set up 2k vehicles and 3k pending trips scattered over the area. The number of threads is
+    // given by the range, where 0 means the global insertion heuristics.
+    const auto num_threads = static_cast<size_t>(state.range(0));
+    const auto num_vehicles = 2000;
+    const auto num_trips = 3000;
+    const auto max_pickup_wait_time_ms = 120000;
+
+    std::mt19937 rng{0};
+
+    std::vector<Vehicle> initial_vehicles;
+    for (auto i = 0; i < num_vehicles; i++) {
+        initial_vehicles.emplace_back(Vehicle{static_cast<size_t>(i), get_random_pos(rng), 2, 0});
+    }
+
+    std::vector<Trip> initial_trips;
+    std::vector<size_t> pending_trip_ids;
+    for (auto i = 0; i < num_trips; i++) {
+        Trip trip{static_cast<size_t>(i), get_random_pos(rng), get_random_pos(rng)};
+        trip.status = TripStatus::REQUESTED;
+        trip.max_pickup_time_ms = max_pickup_wait_time_ms;
+
+        initial_trips.emplace_back(trip);
+        pending_trip_ids.emplace_back(i);
+    }
+
+    FleetState fleet_state;
+    sync_fleet_state(fleet_state, initial_vehicles, 0);
+
+    StraightLineRouter router;
+    const ZoneGrid zone_grid{kArea, 4, 4};
+    ThreadPool thread_pool{num_threads};
+
+    // Dispatch the same trips globally once, as the baseline of the service rate of the zones.
+    int64_t num_globally_dispatched_trips = 0;
+    {
+        auto vehicles = initial_vehicles;
+        auto trips = initial_trips;
+        assign_trips_through_insertion_heuristics(
+            pending_trip_ids, trips, vehicles, fleet_state, 0, router);
+
+        for (const auto &trip : trips) {
+            num_globally_dispatched_trips += trip.status == TripStatus::DISPATCHED;
+        }
+    }
+
+    int64_t num_dispatched_trips = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto vehicles = initial_vehicles;
+        auto trips = initial_trips;
+        state.ResumeTiming();
+
+        // Time the code
+        if (num_threads == 0) {
+            assign_trips_through_insertion_heuristics(
+                pending_trip_ids, trips, vehicles, fleet_state, 0, router);
+        } else {
+            assign_trips_through_zoned_insertion_heuristics(pending_trip_ids,
+                                                            trips,
+                                                            vehicles,
+                                                            fleet_state,
+                                                            0,
+                                                            router,
+                                                            zone_grid,
+                                                            500,
+                                                            thread_pool);
+        }
+
+        for (const auto &trip : trips) {
+            num_dispatched_trips += trip.status == TripStatus::DISPATCHED;
+        }
+    }
+
+    state.SetItemsProcessed(num_trips * state.iterations());
+    state.counters["service_rate"] =
+        static_cast<double>(num_dispatched_trips) / (num_trips * state.iterations());
+    state.counters["service_rate_delta"] =
+        state.counters["service_rate"] -
+        static_cast<double>(num_globally_dispatched_trips) / num_trips;
+}
+
+// Register the function as a benchmark, with the global insertion heuristics (0) as the baseline
+// and the 4 x 4 zones dispatched by 1 to 8 threads.
+BENCHMARK(BenchmarkDispatch)
+    ->Arg(0)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Run the benchmark
+BENCHMARK_MAIN();
@@ -0,0 +1,191 @@
+/// \author Jian Wen
+/// \date 2021/03/02
+
+#include "../src/demand_generator.hpp"
+#include "../src/platform.hpp"
+#include "../src/router.hpp"
+#include "straight_line_router.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// \brief The area of Hong Kong as in the demo config.
+const AreaConfig kArea{114.10, 114.30, 22.20, 22.35};
+
+/// \brief The number of ODs the demand is spread over.
+constexpr size_t kNumOds = 1000;
+
+/// \brief The path to the osrm map data, if the benchmarks are also run with the OSRM router.
+std::string path_to_osrm_data;
+
+Pos get_random_pos(std::mt19937 &rng) {
+    std::uniform_real_distribution<float> lon(kArea.lon_min, kArea.lon_max);
+    std::uniform_real_distribution<float> lat(kArea.lat_min, kArea.lat_max);
+
+    return Pos{lon(rng), lat(rng)};
+}
+
+/// \brief The datalog output of the scenario.
+enum class DatalogMode { OFF = 0, YAML = 1, BINARY = 2 };
+
+/// \brief Create the platform config of the scenario, whose main simulation lasts 15 minutes. The
+/// per-cycle output is turned off so that the console does not add to the timings.
+PlatformConfig create_platform_config(size_t fleet_size,
+                                      size_t veh_capacity,
+                                      double cycle_s,
+                                      DatalogMode datalog_mode) {
+    PlatformConfig platform_config;
+    platform_config.area_config = kArea;
+    platform_config.mod_system_config.fleet_config = {fleet_size, veh_capacity, 114.18, 22.30};
+    platform_config.mod_system_config.request_config.max_pickup_wait_time_s = 300;
+    platform_config.simulation_config = {cycle_s, 900, 300, 300};
+    platform_config.output_config.print_cycles = false;
+
+    auto &datalog_config = platform_config.output_config.datalog_config;
+    datalog_config.output_datalog = datalog_mode != DatalogMode::OFF;
+    datalog_config.binary = datalog_mode == DatalogMode::BINARY;
+    datalog_config.path_to_output_datalog =
+        datalog_config.binary ? "platform_benchmark.bin" : "platform_benchmark.yml";
+
+    return platform_config;
+}
+
+/// \brief Create the demand generator with the trips spread evenly over random ODs.
+DemandGenerator create_demand_generator(double trips_per_hour) {
+    std::mt19937 rng{0};
+
+    std::vector<Od> ods;
+    for (auto i = 0; i < kNumOds; i++) {
+        ods.push_back({get_random_pos(rng), get_random_pos(rng)});
+    }
+
+    const std::vector<double> trips_per_hour_of_ods(kNumOds, trips_per_hour / kNumOds);
+
+    return DemandGenerator{std::move(ods), trips_per_hour_of_ods, 0};
+}
+
+/// \brief Run the platform end-to-end on the scenario given by the range, i.e. the fleet size, the
+/// vehicle capacity, the trips per hour, the cycle in seconds and the datalog mode.
+template <typename RouterFunc>
+void run_platform_benchmark(benchmark::State &state, const RouterFunc &router_func) {
+    const auto platform_config = create_platform_config(
+        state.range(0), state.range(1), state.range(3), static_cast<DatalogMode>(state.range(4)));
+
+    SimulationReport report;
+    SimulationReport total_report;
+    double total_simulated_s = 0.0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        Platform<std::reference_wrapper<const RouterFunc>, DemandGenerator> platform{
+            platform_config, std::cref(router_func), create_demand_generator(state.range(2))};
+        state.ResumeTiming();
+
+        // Time the code
+        report = platform.run_simulation();
+
+        total_report.total_runtime_s += report.total_runtime_s;
+        total_report.advance_runtime_s += report.advance_runtime_s;
+        total_report.demand_runtime_s += report.demand_runtime_s;
+        total_report.dispatch_runtime_s += report.dispatch_runtime_s;
+        total_report.datalog_runtime_s += report.datalog_runtime_s;
+        total_simulated_s += platform.get_system_time_ms() / 1000.0;
+    }
+
+    state.counters["sim_s_per_wall_s"] = total_simulated_s / total_report.total_runtime_s;
+    state.counters["advance_s"] =
+        benchmark::Counter(total_report.advance_runtime_s, benchmark::Counter::kAvgIterations);
+    state.counters["demand_s"] =
+        benchmark::Counter(total_report.demand_runtime_s, benchmark::Counter::kAvgIterations);
+    state.counters["dispatch_s"] =
+        benchmark::Counter(total_report.dispatch_runtime_s, benchmark::Counter::kAvgIterations);
+    state.counters["datalog_s"] =
+        benchmark::Counter(total_report.datalog_runtime_s, benchmark::Counter::kAvgIterations);
+    state.counters["peak_route_bytes"] = report.peak_route_bytes;
+    state.counters["peak_datalog_bytes"] = report.peak_datalog_bytes;
+    state.counters["peak_rss_bytes"] = report.peak_rss_bytes;
+    state.counters["service_rate"] =
+        static_cast<double>(report.dispatched_trip_count) / std::max<size_t>(1, report.trip_count);
+
+    std::remove(platform_config.output_config.datalog_config.path_to_output_datalog.c_str());
+}
+
+/// \brief The scenarios as the scaling curves around the baseline of 1000 vehicles of capacity 2,
+/// 10 trips per vehicle per hour, a 30-second cycle and no datalog. Each curve varies one
+/// parameter.
+void add_scenarios(benchmark::internal::Benchmark *benchmark) {
+    const auto off = static_cast<int64_t>(DatalogMode::OFF);
+
+    for (auto fleet_size : {10, 100, 1000, 10000}) {
+        benchmark->Args({fleet_size, 2, fleet_size * 10, 30, off});
+    }
+    for (auto veh_capacity : {1, 4, 6}) {
+        benchmark->Args({1000, veh_capacity, 10000, 30, off});
+    }
+    for (auto trips_per_hour : {2500, 5000, 20000}) {
+        benchmark->Args({1000, 2, trips_per_hour, 30, off});
+    }
+    for (auto cycle_s : {10, 60, 120}) {
+        benchmark->Args({1000, 2, 10000, cycle_s, off});
+    }
+    for (auto datalog_mode : {DatalogMode::YAML, DatalogMode::BINARY}) {
+        benchmark->Args({1000, 2, 10000, 30, static_cast<int64_t>(datalog_mode)});
+    }
+
+    benchmark->ArgNames({"fleet", "capacity", "trips_per_hour", "cycle_s", "datalog"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+}
+
+} // namespace
+
+static void BenchmarkPlatformWithStraightLineRouter(benchmark::State &state) {
+    const StraightLineRouter router;
+    run_platform_benchmark(state, router);
+}
+
+static void BenchmarkPlatformWithOsrmRouter(benchmark::State &state) {
+    // Set up the router once, as loading the map takes long.
+    static const Router router{path_to_osrm_data};
+    run_platform_benchmark(state, router);
+}
+
+BENCHMARK(BenchmarkPlatformWithStraightLineRouter)->Apply(add_scenarios);
+
+int main(int argc, char **argv) {
+    // Take out our own flag before handing the rest to the benchmark library.
+    const std::string osrm_flag = "--osrm_map=";
+    auto num_args = 1;
+    for (auto i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], osrm_flag.c_str(), osrm_flag.size()) == 0) {
+            path_to_osrm_data = argv[i] + osrm_flag.size();
+        } else {
+            argv[num_args++] = argv[i];
+        }
+    }
+    argc = num_args;
+
+    // The OSRM router is only benchmarked with the map given.
+    if (!path_to_osrm_data.empty()) {
+        benchmark::RegisterBenchmark("BenchmarkPlatformWithOsrmRouter",
+                                     BenchmarkPlatformWithOsrmRouter)
+            ->Apply(add_scenarios);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+
+    return 0;
+}
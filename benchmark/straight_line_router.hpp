@@ -0,0 +1,28 @@
+/// \author Jian Wen
+/// \date 2021/03/02
+
+#pragma once
+
+#include "../src/geo.hpp"
+#include "../src/types.hpp"
+
+#include <cstdint>
+
+/// \brief The router that travels in straight lines at a constant speed, so that the benchmarks
+/// measure the simulation itself rather than the routing engine.
+struct StraightLineRouter {
+    RoutingResponse operator()(const Pos &origin, const Pos &destination, RoutingType) const {
+        const auto distance_mm =
+            static_cast<int32_t>(get_haversine_distance_m(origin, destination) * 1000);
+        const auto duration_ms = static_cast<int32_t>(distance_mm / 10);
+
+        RoutingResponse response;
+        response.status = RoutingStatus::OK;
+        response.route.distance_mm = distance_mm;
+        response.route.duration_ms = duration_ms;
+        response.route.legs.push_back(
+            Leg{distance_mm, duration_ms, {Step{distance_mm, duration_ms, {origin, destination}}}});
+
+        return response;
+    }
+};
@@ -0,0 +1,233 @@
+import numpy as np
+
+import gzip
+import io
+import mmap
+import sys
+
+
+# The layouts of the binary datalog, as defined in src/binary_datalog.hpp.
+MAGIC = b"MODDLOG\0"
+VERSION = 1
+
+HEADER_DTYPE = np.dtype([("magic", "S8"), ("version", "<u4"), ("frames_per_chunk", "<u4"),
+                         ("num_vehicles", "<u8"), ("num_frames", "<u8"), ("num_chunks", "<u8"),
+                         ("index_offset", "<u8")])
+INDEX_ENTRY_DTYPE = np.dtype([("offset", "<u8"), ("first_frame_index", "<u8"), ("num_frames", "<u8"),
+                              ("first_system_time_ms", "<u8")])
+CHUNK_HEADER_DTYPE = np.dtype([("num_frames", "<u8"), ("num_vehicles", "<u8"), ("num_waypoints", "<u8"),
+                               ("num_waypoint_poses", "<u8"), ("num_new_trips", "<u8"),
+                               ("num_trip_transitions", "<u8")])
+
+# The columns of a chunk in the order they are written, with their types and lengths.
+CHUNK_COLUMNS = [
+    ("system_time_ms", "<u8", "num_frames"),
+    ("vehicle_lon", "<f4", "num_vehicle_frames"),
+    ("vehicle_lat", "<f4", "num_vehicle_frames"),
+    ("vehicle_load", "<u4", "num_vehicle_frames"),
+    ("vehicle_waypoint_ends", "<u4", "num_vehicle_frames"),
+    ("waypoint_pose_ends", "<u4", "num_waypoints"),
+    ("waypoint_pose_lon", "<f4", "num_waypoint_poses"),
+    ("waypoint_pose_lat", "<f4", "num_waypoint_poses"),
+    ("frame_new_trip_ends", "<u4", "num_frames"),
+    ("new_trip_id", "<u8", "num_new_trips"),
+    ("new_trip_request_time_ms", "<u8", "num_new_trips"),
+    ("new_trip_max_pickup_time_ms", "<u8", "num_new_trips"),
+    ("new_trip_origin_lon", "<f4", "num_new_trips"),
+    ("new_trip_origin_lat", "<f4", "num_new_trips"),
+    ("new_trip_destination_lon", "<f4", "num_new_trips"),
+    ("new_trip_destination_lat", "<f4", "num_new_trips"),
+    ("frame_trip_transition_ends", "<u4", "num_frames"),
+    ("trip_transition_id", "<u8", "num_trip_transitions"),
+    ("trip_transition_time_ms", "<u8", "num_trip_transitions"),
+    ("trip_transition_status", "<u1", "num_trip_transitions"),
+]
+
+# The magic numbers at the beginning of the compressed yaml datalog.
+GZIP_MAGIC = b"\x1f\x8b"
+ZSTD_MAGIC = b"\x28\xb5\x2f\xfd"
+
+# The trip status, in the order of TripStatus in src/types.hpp.
+TRIP_STATUSES = ["UNDEFINED", "REQUESTED", "DISPATCHED",
+                 "PICKED_UP", "DROPPED_OFF", "WALKAWAY"]
+
+
+def open_yaml_datalog(path_to_datalog):
+    """Open the yaml datalog as a text file, decompressed on the fly if compressed with gzip or zstd."""
+
+    with open(path_to_datalog, "rb") as file:
+        magic = file.read(4)
+
+    if magic.startswith(GZIP_MAGIC):
+        return gzip.open(path_to_datalog, "rt")
+    if magic.startswith(ZSTD_MAGIC):
+        try:
+            import zstandard
+        except ImportError:
+            print("[ERROR] The datalog is compressed with zstd. Please pip install zstandard.")
+            sys.exit(1)
+        return io.TextIOWrapper(zstandard.ZstdDecompressor().stream_reader(open(path_to_datalog, "rb"),
+                                                                           closefd=True))
+    return open(path_to_datalog)
+
+
+class BinaryDatalog:
+    """The reader of the binary datalog written with binary on in the datalog config.
+
+    The file is memory mapped, and each column of a chunk is a numpy array that refers to the
+    mapped file directly without copying."""
+
+    def __init__(self, path_to_datalog):
+        self.file = open(path_to_datalog, "rb")
+        self.buffer = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        self.header = np.frombuffer(
+            self.buffer, dtype=HEADER_DTYPE, count=1).copy()[0]
+        assert self.header["magic"] == MAGIC.rstrip(b"\0"), \
+            "The file is not a binary datalog!"
+        assert self.header["version"] == VERSION, \
+            "The binary datalog has an unsupported version!"
+        assert self.header["index_offset"] > 0, \
+            "The binary datalog was not closed properly!"
+
+        self.num_vehicles = int(self.header["num_vehicles"])
+        self.num_frames = int(self.header["num_frames"])
+        self.num_chunks = int(self.header["num_chunks"])
+        self.index = np.frombuffer(self.buffer, dtype=INDEX_ENTRY_DTYPE, count=self.num_chunks,
+                                   offset=int(self.header["index_offset"]))
+
+    def get_chunk(self, chunk_index):
+        """Get the columns of the chunk as a dict of numpy arrays, together with the chunk header."""
+
+        offset = int(self.index[chunk_index]["offset"])
+        header = np.frombuffer(self.buffer, dtype=CHUNK_HEADER_DTYPE,
+                               count=1, offset=offset)[0]
+        offset += CHUNK_HEADER_DTYPE.itemsize
+
+        counts = {name: int(header[name])
+                  for name in CHUNK_HEADER_DTYPE.names}
+        counts["num_vehicle_frames"] = counts["num_frames"] * \
+            counts["num_vehicles"]
+
+        chunk = {"header": counts}
+        for name, dtype, count_name in CHUNK_COLUMNS:
+            count = counts[count_name]
+            chunk[name] = np.frombuffer(
+                self.buffer, dtype=dtype, count=count, offset=offset)
+            offset += (count * np.dtype(dtype).itemsize + 7) // 8 * 8
+
+        return chunk
+
+    def iter_frames(self):
+        """Iterate through the frames in the same structure as the yaml datalog.
+
+        The trips seen so far are kept with their latest status, so that each frame holds all
+        trips as in the yaml datalog."""
+
+        trips = {}
+
+        for chunk_index in range(self.num_chunks):
+            chunk = self.get_chunk(chunk_index)
+            num_frames = chunk["header"]["num_frames"]
+
+            waypoint_begin = 0
+            new_trip_begin = 0
+            transition_begin = 0
+            for f in range(num_frames):
+                vehicles = []
+                for v in range(self.num_vehicles):
+                    i = f * self.num_vehicles + v
+
+                    waypoints = []
+                    waypoint_end = int(chunk["vehicle_waypoint_ends"][i])
+                    for w in range(waypoint_begin, waypoint_end):
+                        pose_begin = int(
+                            chunk["waypoint_pose_ends"][w - 1]) if w > 0 else 0
+                        pose_end = int(chunk["waypoint_pose_ends"][w])
+                        waypoints.append([{"lon": float(lon), "lat": float(lat)} for lon, lat in zip(
+                            chunk["waypoint_pose_lon"][pose_begin:pose_end],
+                            chunk["waypoint_pose_lat"][pose_begin:pose_end])])
+                    waypoint_begin = waypoint_end
+
+                    vehicles.append({"pos": {"lon": float(chunk["vehicle_lon"][i]),
+                                             "lat": float(chunk["vehicle_lat"][i])},
+                                     "load": int(chunk["vehicle_load"][i]),
+                                     # An empty list loads as None from the yaml datalog.
+                                     "waypoints": waypoints if waypoints else None})
+
+                new_trip_end = int(chunk["frame_new_trip_ends"][f])
+                for t in range(new_trip_begin, new_trip_end):
+                    trips[int(chunk["new_trip_id"][t])] = {
+                        "id": int(chunk["new_trip_id"][t]),
+                        "origin": {"lon": float(chunk["new_trip_origin_lon"][t]),
+                                   "lat": float(chunk["new_trip_origin_lat"][t])},
+                        "destination": {"lon": float(chunk["new_trip_destination_lon"][t]),
+                                        "lat": float(chunk["new_trip_destination_lat"][t])},
+                        "status": "UNDEFINED",
+                        "request_time_ms": int(chunk["new_trip_request_time_ms"][t]),
+                        "max_pickup_time_ms": int(chunk["new_trip_max_pickup_time_ms"][t]),
+                        "pickup_time_ms": 0,
+                        "dropoff_time_ms": 0}
+                new_trip_begin = new_trip_end
+
+                transition_end = int(chunk["frame_trip_transition_ends"][f])
+                for r in range(transition_begin, transition_end):
+                    trip = trips[int(chunk["trip_transition_id"][r])]
+                    trip["status"] = TRIP_STATUSES[int(
+                        chunk["trip_transition_status"][r])]
+                    if trip["status"] == "PICKED_UP":
+                        trip["pickup_time_ms"] = int(
+                            chunk["trip_transition_time_ms"][r])
+                    elif trip["status"] == "DROPPED_OFF":
+                        trip["dropoff_time_ms"] = int(
+                            chunk["trip_transition_time_ms"][r])
+                transition_begin = transition_end
+
+                yield {"system_time_ms": int(chunk["system_time_ms"][f]),
+                       "vehicles": vehicles,
+                       "trips": [dict(trip) for trip in trips.values()]}
+
+    def close(self):
+        """Unmap and close the file. The arrays of the chunks must not be used afterwards."""
+
+        self.index = None
+        self.buffer.close()
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+
+def main():
+    # Check command line arguments.
+    if (len(sys.argv) != 2):
+        print("[ERROR] We need exact 1 argument aside from the program name for correct execution! \n"
+              "- Usage: python3 <prog name> <arg1>. \n"
+              "  <arg1> is the path to the binary datalog. \n"
+              "- Example: python3 {} \"./datalog/demo.bin\"\n".format(sys.argv[0]))
+        sys.exit(1)
+
+    # Print the summary of the datalog.
+    datalog = BinaryDatalog(sys.argv[1])
+    print("Loaded binary datalog from {}: {} frames of {} vehicles in {} chunks.".format(
+        sys.argv[1], datalog.num_frames, datalog.num_vehicles, datalog.num_chunks))
+
+    for chunk_index in range(datalog.num_chunks):
+        chunk = datalog.get_chunk(chunk_index)
+        print(" - Chunk {}: T = {}s to {}s, {} waypoint poses, {} new trips, {} trip transitions.".format(
+            chunk_index,
+            chunk["system_time_ms"][0] / 1000.0,
+            chunk["system_time_ms"][-1] / 1000.0,
+            chunk["header"]["num_waypoint_poses"],
+            chunk["header"]["num_new_trips"],
+            chunk["header"]["num_trip_transitions"]))
+        del chunk
+
+    datalog.close()
+
+
+if __name__ == "__main__":
+    main()
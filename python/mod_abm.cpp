@@ -0,0 +1,315 @@
+/// \author Jian Wen
+/// \date 2021/03/01
+
+#include "../src/config.hpp"
+#include "../src/demand_generator.hpp"
+#include "../src/platform.hpp"
+#include "../src/router.hpp"
+#include "../src/types.hpp"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace {
+
+/// \brief The platform of each episode, sharing the router with the other episodes.
+using EpisodePlatform = Platform<std::reference_wrapper<const Router>, DemandGenerator>;
+
+/// \brief View the vector as a read-only numpy array, without copying.
+/// \param base The owner of the vector, kept alive as long as the array.
+template <typename T> py::array_t<T> view_vector(const std::vector<T> &vector, py::handle base) {
+    py::array_t<T> array(vector.size(), vector.data(), base);
+    array.attr("setflags")(py::arg("write") = false);
+
+    return array;
+}
+
+/// \brief Copy one field of all trips into a numpy array.
+/// \param get_field The function that gets the field from a trip.
+template <typename T, typename GetField>
+py::array_t<T> copy_trip_field(const std::vector<Trip> &trips, GetField get_field) {
+    py::array_t<T> array(trips.size());
+    auto data = array.template mutable_unchecked<1>();
+
+    for (auto i = 0; i < trips.size(); i++) {
+        data(i) = get_field(trips[i]);
+    }
+
+    return array;
+}
+
+/// \brief The simulation environment stepped cycle by cycle from Python, e.g. by a reinforcement
+/// learning agent that dispatches the trips.
+/// \details The router and the demand model are loaded only once and shared by all episodes, each
+/// of which runs on a new platform. The datalog, the video and the trace are turned off.
+class Environment {
+  public:
+    /// \brief Constructor.
+    Environment(const std::string &path_to_platform_config,
+                const std::string &path_to_osrm_data,
+                const std::string &path_to_demand_config)
+        : platform_config_(load_platform_config(path_to_platform_config)),
+          router_(path_to_osrm_data, platform_config_.simulation_config.route_simplification_m),
+          demand_model_(DemandGenerator{path_to_demand_config, 0}.get_demand_model()) {
+        platform_config_.output_config.datalog_config.output_datalog = false;
+        platform_config_.output_config.video_config.render_video = false;
+        platform_config_.output_config.trace_config.output_trace = false;
+    }
+
+    /// \brief Start a new episode from the beginning of the simulation.
+    /// \param seed The seed of the demand. The same seed reproduces the same requests.
+    void reset(uint64_t seed) {
+        platform_.reset();
+        platform_ = std::make_shared<EpisodePlatform>(
+            platform_config_, std::cref(router_), DemandGenerator{demand_model_, seed});
+        cycle_started_ = false;
+    }
+
+    /// \brief Advance the simulation by one cycle, and get the ids of the pending trips.
+    py::array_t<size_t> step() {
+        check_platform();
+        if (cycle_started_) {
+            throw std::runtime_error("The pending trips must be dispatched before the next step!");
+        }
+        if (platform_->is_done()) {
+            throw std::runtime_error("The episode is done! Call reset() to start a new one.");
+        }
+
+        {
+            py::gil_scoped_release release;
+            pending_trip_ids_ = platform_->start_cycle();
+        }
+        cycle_started_ = true;
+
+        return py::array_t<size_t>(pending_trip_ids_.size(), pending_trip_ids_.data());
+    }
+
+    /// \brief Dispatch the pending trips through the built-in insertion heuristics.
+    void dispatch() {
+        check_cycle_started();
+
+        {
+            py::gil_scoped_release release;
+            platform_->dispatch_pending_trips();
+        }
+        cycle_started_ = false;
+    }
+
+    /// \brief Assign the pending trips to the vehicles. The trips not assigned walk away.
+    /// \return The number of trips inserted, i.e. those the assigned vehicles could serve.
+    size_t apply_assignments(py::array_t<int64_t, py::array::c_style | py::array::forcecast> trips,
+                             py::array_t<int64_t, py::array::c_style | py::array::forcecast>
+                                 vehicles) {
+        check_cycle_started();
+        if (trips.ndim() != 1 || vehicles.ndim() != 1 || trips.size() != vehicles.size()) {
+            throw py::value_error("The trip ids and the vehicle ids must be 1-D of the same size!");
+        }
+
+        // Validate the assignments here, as the platform only asserts them.
+        std::unordered_set<int64_t> remaining_trip_ids{pending_trip_ids_.begin(),
+                                                       pending_trip_ids_.end()};
+        const auto num_vehicles = static_cast<int64_t>(platform_->get_vehicles().size());
+
+        std::vector<size_t> trip_ids(trips.size());
+        std::vector<size_t> vehicle_ids(vehicles.size());
+        for (auto i = 0; i < trips.size(); i++) {
+            if (remaining_trip_ids.erase(trips.at(i)) == 0) {
+                throw py::value_error("Only the pending trips can be assigned, each at most once!");
+            }
+            if (vehicles.at(i) < 0 || vehicles.at(i) >= num_vehicles) {
+                throw py::value_error("The vehicle id is out of range!");
+            }
+
+            trip_ids[i] = trips.at(i);
+            vehicle_ids[i] = vehicles.at(i);
+        }
+
+        size_t num_inserted_trips = 0;
+        {
+            py::gil_scoped_release release;
+            num_inserted_trips = platform_->assign_pending_trips(trip_ids, vehicle_ids);
+        }
+        cycle_started_ = false;
+
+        return num_inserted_trips;
+    }
+
+    /// \brief True if the episode has reached the shutdown time.
+    bool is_done() const {
+        check_platform();
+        return platform_->is_done();
+    }
+
+    /// \brief Get the system time in milliseconds.
+    uint64_t get_system_time_ms() const {
+        check_platform();
+        return platform_->get_system_time_ms();
+    }
+
+    /// \brief View the hot states of the vehicles as numpy arrays, without copying.
+    /// \details The platform syncs the fleet state in place, always with one entry per vehicle, so
+    /// its vectors are never reallocated during an episode. The views thus follow the live state,
+    /// and each of them holds a reference to the platform, which keeps the memory alive after
+    /// reset() as well.
+    py::dict get_fleet_state() {
+        check_platform();
+        const auto &fleet_state = platform_->observe_fleet_state();
+
+        // The capsule owns a reference to the platform, released along with the last view.
+        auto release_platform = [](void *platform) {
+            delete static_cast<std::shared_ptr<EpisodePlatform> *>(platform);
+        };
+        const py::capsule base{new std::shared_ptr<EpisodePlatform>(platform_), release_platform};
+
+        py::dict views;
+        views["lon"] = view_vector(fleet_state.lon, base);
+        views["lat"] = view_vector(fleet_state.lat, base);
+        views["load"] = view_vector(fleet_state.load, base);
+        views["capacity"] = view_vector(fleet_state.capacity, base);
+        views["next_stop_time_ms"] = view_vector(fleet_state.next_stop_time_ms, base);
+        views["plan_end_lon"] = view_vector(fleet_state.plan_end_lon, base);
+        views["plan_end_lat"] = view_vector(fleet_state.plan_end_lat, base);
+        views["plan_end_time_ms"] = view_vector(fleet_state.plan_end_time_ms, base);
+
+        return views;
+    }
+
+    /// \brief Get a copy of the fields of all trips as numpy arrays.
+    /// \details The trips are copied rather than viewed, as the vector of trips grows, and thus
+    /// reallocates, as the new trips are requested.
+    py::dict get_trips() const {
+        check_platform();
+        const auto &trips = platform_->get_trips();
+
+        py::dict arrays;
+        arrays["id"] = copy_trip_field<size_t>(trips, [](const Trip &trip) { return trip.id; });
+        arrays["origin_lon"] =
+            copy_trip_field<float>(trips, [](const Trip &trip) { return trip.origin.lon; });
+        arrays["origin_lat"] =
+            copy_trip_field<float>(trips, [](const Trip &trip) { return trip.origin.lat; });
+        arrays["destination_lon"] =
+            copy_trip_field<float>(trips, [](const Trip &trip) { return trip.destination.lon; });
+        arrays["destination_lat"] =
+            copy_trip_field<float>(trips, [](const Trip &trip) { return trip.destination.lat; });
+        using TripStatusType = std::underlying_type_t<TripStatus>;
+        arrays["status"] = copy_trip_field<TripStatusType>(
+            trips, [](const Trip &trip) { return static_cast<TripStatusType>(trip.status); });
+        arrays["request_time_ms"] =
+            copy_trip_field<int32_t>(trips, [](const Trip &trip) { return trip.request_time_ms; });
+        arrays["max_pickup_time_ms"] = copy_trip_field<int32_t>(
+            trips, [](const Trip &trip) { return trip.max_pickup_time_ms; });
+        arrays["pickup_time_ms"] =
+            copy_trip_field<int32_t>(trips, [](const Trip &trip) { return trip.pickup_time_ms; });
+        arrays["dropoff_time_ms"] =
+            copy_trip_field<int32_t>(trips, [](const Trip &trip) { return trip.dropoff_time_ms; });
+
+        return arrays;
+    }
+
+    /// \brief Get the KPIs accumulated over the main simulation so far.
+    py::dict get_kpis() const {
+        check_platform();
+        const auto &total = platform_->get_kpi_accumulator().get_total();
+
+        py::dict kpis;
+        kpis["trip_count"] = total.trip_count;
+        kpis["dispatched_trip_count"] = total.dispatched_trip_count;
+        kpis["completed_trip_count"] = total.completed_trip_count;
+        kpis["total_wait_time_ms"] = total.total_wait_time_ms;
+        kpis["total_travel_time_ms"] = total.total_travel_time_ms;
+        kpis["dist_traveled_mm"] = total.dist_traveled_mm;
+        kpis["loaded_dist_traveled_mm"] = total.loaded_dist_traveled_mm;
+
+        return kpis;
+    }
+
+  private:
+    /// \brief Throw if no episode has been started.
+    void check_platform() const {
+        if (!platform_) {
+            throw std::runtime_error("No episode has been started! Call reset() first.");
+        }
+    }
+
+    /// \brief Throw if there are no pending trips to dispatch, i.e. step() is not called yet.
+    void check_cycle_started() const {
+        check_platform();
+        if (!cycle_started_) {
+            throw std::runtime_error("There is no cycle to dispatch! Call step() first.");
+        }
+    }
+
+    /// \brief The platform config shared by all episodes.
+    PlatformConfig platform_config_;
+
+    /// \brief The router shared by all episodes.
+    const Router router_;
+
+    /// \brief The demand model shared by all episodes.
+    std::shared_ptr<const DemandModel> demand_model_;
+
+    /// \brief The platform of the current episode, shared with the views of its fleet state.
+    std::shared_ptr<EpisodePlatform> platform_;
+
+    /// \brief The ids of the pending trips of the current cycle.
+    std::vector<size_t> pending_trip_ids_ = {};
+
+    /// \brief True if step() is called and the pending trips are yet to be dispatched.
+    bool cycle_started_ = false;
+};
+
+} // namespace
+
+PYBIND11_MODULE(mod_abm, m) {
+    m.doc() = "The step-wise Python interface to the mobility-on-demand simulation platform.";
+
+    py::enum_<TripStatus>(m, "TripStatus", py::arithmetic())
+        .value("UNDEFINED", TripStatus::UNDEFINED)
+        .value("REQUESTED", TripStatus::REQUESTED)
+        .value("DISPATCHED", TripStatus::DISPATCHED)
+        .value("PICKED_UP", TripStatus::PICKED_UP)
+        .value("DROPPED_OFF", TripStatus::DROPPED_OFF)
+        .value("WALKAWAY", TripStatus::WALKAWAY);
+
+    py::class_<Environment>(m, "Environment")
+        .def(py::init<const std::string &, const std::string &, const std::string &>(),
+             py::arg("path_to_platform_config"),
+             py::arg("path_to_osrm_data"),
+             py::arg("path_to_demand_config"))
+        .def("reset", &Environment::reset, py::arg("seed"), "Start a new episode.")
+        .def("step",
+             &Environment::step,
+             "Advance the simulation by one cycle, and return the ids of the pending trips, which "
+             "must then be dispatched through dispatch() or apply_assignments().")
+        .def("dispatch",
+             &Environment::dispatch,
+             "Dispatch the pending trips through the built-in insertion heuristics.")
+        .def("apply_assignments",
+             &Environment::apply_assignments,
+             py::arg("trip_ids"),
+             py::arg("vehicle_ids"),
+             "Assign the pending trips to the vehicles, and return the number of trips inserted. "
+             "The trips not assigned, or that the vehicles could not serve, walk away.")
+        .def_property_readonly("done", &Environment::is_done)
+        .def_property_readonly("system_time_ms", &Environment::get_system_time_ms)
+        .def("fleet_state",
+             &Environment::get_fleet_state,
+             "Return the dict of the vehicle states as read-only numpy arrays, which view the live "
+             "states of the platform without copying.")
+        .def("trips",
+             &Environment::get_trips,
+             "Return the dict of the fields of all trips as numpy arrays, copied from the "
+             "platform.")
+        .def("kpis", &Environment::get_kpis, "Return the KPIs of the main simulation so far.");
+}
@@ -0,0 +1,65 @@
+import mod_abm
+import numpy as np
+
+import sys
+
+
+def main():
+    # Check the input arugment list.
+    if (len(sys.argv) != 4):
+        print("[ERROR] We need 3 arguments aside from the program name for correct execution! \n"
+              "- Usage: python3 <prog name> <arg1> <arg2> <arg3>. \n"
+              "  <arg1> is the path to the platform config file. \n"
+              "  <arg2> is the path to the osrm map data. \n"
+              "  <arg3> is the path to the demand config file. \n"
+              "- Example: python3 {} \"./config/platform_demo.yml\" \"../osrm/map/hongkong.osrm\" "
+              "\"./config/demand_demo.yml\"\n".format(sys.argv[0]))
+        sys.exit(-1)
+
+    env = mod_abm.Environment(sys.argv[1], sys.argv[2], sys.argv[3])
+    env.reset(0)
+
+    # Step a few cycles, dispatching the trips alternately through the built-in heuristics and to
+    # vehicle 0.
+    for cycle in range(10):
+        pending_trip_ids = env.step()
+        fleet = env.fleet_state()
+        if cycle % 2 == 0:
+            env.dispatch()
+        else:
+            env.apply_assignments(pending_trip_ids, np.zeros(len(pending_trip_ids), dtype=np.int64))
+    trips = env.trips()
+
+    assert len(trips["id"]) > 0, "No trips were requested!"
+    assert np.array_equal(trips["id"], np.arange(len(trips["id"])))
+    assert len(fleet["lon"]) == len(fleet["plan_end_time_ms"]) > 0
+
+    # The trips are copies, so they stay intact after the platform moves on or is replaced.
+    saved_trips = {key: array.copy() for key, array in trips.items()}
+
+    # The fleet state is viewed without copying, so the views follow the live states.
+    assert not fleet["lon"].flags.writeable, "The fleet arrays must be read-only!"
+    env.step()
+    env.dispatch()
+    live_fleet = env.fleet_state()
+    for key, array in live_fleet.items():
+        assert np.shares_memory(fleet[key], array), "The fleet array {} is copied!".format(key)
+
+    # The views keep the platform of their episode alive after reset(), frozen at its last states.
+    saved_fleet = {key: array.copy() for key, array in fleet.items()}
+    env.reset(1)
+    env.step()
+    env.dispatch()
+    assert not np.shares_memory(fleet["lon"], env.fleet_state()["lon"])
+
+    for key, array in saved_trips.items():
+        assert np.array_equal(trips[key], array), "The trip array {} has changed!".format(key)
+    for key, array in saved_fleet.items():
+        assert np.array_equal(fleet[key], array), "The fleet array {} has changed!".format(key)
+
+    print("[INFO] Stepped the environment through {} trips on {} vehicles.".format(
+        len(trips["id"]), len(fleet["lon"])))
+
+
+if __name__ == "__main__":
+    main()
@@ -7,6 +7,8 @@ from PIL import Image
 import sys
 import yaml
 
+from datalog_reader import BinaryDatalog, open_yaml_datalog
+
 
 # Dots per inch, represents the dot density in the output video.
 DPI = 200
@@ -48,6 +50,78 @@ def convert_to_x_and_y(pos, lon_min, lon_max, lat_min, lat_max, w, h):
     return (x, y)
 
 
+def iter_yaml_frames(file):
+    """Iterate through the frames in the yaml datalog, one yaml document per frame."""
+
+    string = ""
+    for line in file:
+        if line == "---\n":
+            yield yaml.safe_load(string)
+            string = ""
+        else:
+            string += line
+
+
+def get_pos_on_route(route, cursor, elapsed_ms):
+    """Get the pos along the route given the progress, interpolated within the segment at the cursor."""
+
+    poses = route["poses"]
+    time_offsets_ms = route["time_offsets_ms"]
+
+    if cursor + 1 >= len(poses) or time_offsets_ms[cursor + 1] == time_offsets_ms[cursor]:
+        return poses[cursor]
+
+    ratio = (elapsed_ms - time_offsets_ms[cursor]) / \
+        (time_offsets_ms[cursor + 1] - time_offsets_ms[cursor])
+
+    return {"lon": poses[cursor]["lon"] + ratio * (poses[cursor + 1]["lon"] - poses[cursor]["lon"]),
+            "lat": poses[cursor]["lat"] + ratio * (poses[cursor + 1]["lat"] - poses[cursor]["lat"])}
+
+
+def reconstruct_frame(frame, routes, trips):
+    """Reconstruct the full frame from a delta-encoded frame.
+
+    The routes and the trips seen so far are kept in the given dicts, which are updated with the
+    new routes and the changed trips in this frame. The routes no longer referred to are dropped,
+    since their ids are never reused."""
+
+    for route in frame.get("routes") or []:
+        for pos in route["poses"]:
+            pos["lon"] = float(pos["lon"])
+            pos["lat"] = float(pos["lat"])
+        routes[route["id"]] = route
+
+    for trip in frame.get("trips") or []:
+        trips[trip["id"]] = trip
+
+    referred_route_ids = set()
+    for vehicle in frame["vehicles"]:
+        if vehicle["waypoints"] is None:
+            continue
+
+        waypoints = []
+        for waypoint in vehicle["waypoints"]:
+            route = routes[waypoint["route_id"]]
+            referred_route_ids.add(waypoint["route_id"])
+
+            # Only the remaining part of the polyline, starting from the current pos.
+            if len(route["poses"]) == 0:
+                waypoints.append([])
+                continue
+            cursor = waypoint["cursor"]
+            waypoints.append([get_pos_on_route(route, cursor, waypoint["elapsed_ms"])] +
+                             route["poses"][cursor + 1:])
+        vehicle["waypoints"] = waypoints
+
+    for id in [id for id in routes if id not in referred_route_ids]:
+        del routes[id]
+
+    if len(trips) > 0:
+        frame["trips"] = list(trips.values())
+
+    return frame
+
+
 def get_color(id):
     """Get color of vehicle given its id. We only color the first five vehicles."""
 
@@ -105,10 +179,16 @@ def main():
     num_vehs = config["mod_system_config"]["fleet_config"]["fleet_size"]
 
     path_to_datalog = config["output_config"]["datalog_config"]["path_to_output_datalog"]
+    delta_encoded = config["output_config"]["datalog_config"].get(
+        "delta_encoded", False)
+    binary = config["output_config"]["datalog_config"].get("binary", False)
     print("Rendering video of total {} frames using datalog from {}".format(
         num_frames, path_to_datalog))
 
-    with open(path_to_datalog) as file:
+    with BinaryDatalog(path_to_datalog) if binary else open_yaml_datalog(path_to_datalog) as datalog:
+        # The frames are read one by one as rendered.
+        frames = datalog.iter_frames() if binary else iter_yaml_frames(datalog)
+
         # Create the plot.
         fig = plt.figure(figsize=(w/DPI, h/DPI), dpi=DPI)
         ax = plt.axes(xlim=(0, w), ylim=(h, 0))
@@ -147,25 +227,27 @@ def main():
             wp2.append(ax.plot([], [], linestyle=':',
                                linewidth=2, color=color, alpha=0.6)[0])
 
+        # The routes and the trips seen so far, if the datalog is delta encoded.
+        routes = {}
+        trips = {}
+
         def init():
             return vehs, wp0, wp1, wp2, dispatched_trips, walked_away_trips, text
 
         def animate(n):
             print("Rendering Frame {} / {} of video...".format(n, num_frames))
 
-            # Load the yaml of the current frame.
-            string = ""
-            while True:
-                line = file.readline()
-                if not line:
-                    print("Reached the end of datalog file before expected! \n")
-                    sys.exit(1)
-                if line == "---\n":
-                    break
-                string += line
-            frame = yaml.safe_load(string)
+            # Load the current frame.
+            frame = next(frames, None)
+            if frame is None:
+                print("Reached the end of datalog file before expected! \n")
+                sys.exit(1)
             system_time_ms = frame["system_time_ms"]
 
+            # Reconstruct the full frame if the datalog is delta encoded.
+            if delta_encoded:
+                frame = reconstruct_frame(frame, routes, trips)
+
             # Render vehicles.
             vehicles = frame["vehicles"]
             for id, vehicle in enumerate(vehicles):
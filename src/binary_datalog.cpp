@@ -0,0 +1,290 @@
+/// \author Jian Wen
+/// \date 2021/02/27
+
+#include "binary_datalog.hpp"
+#include "memory.hpp"
+#include "serialization.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+
+namespace {
+
+/// \brief Get the size of the column in bytes, padded to a multiple of 8 bytes.
+size_t get_padded_size(size_t size) { return (size + 7) / 8 * 8; }
+
+/// \brief Write the column as is, padded to a multiple of 8 bytes.
+template <typename T> void write_column(std::ostream &out, const std::vector<T> &column) {
+    const auto size = column.size() * sizeof(T);
+    out.write(reinterpret_cast<const char *>(column.data()), size);
+
+    const char padding[8] = {};
+    out.write(padding, get_padded_size(size) - size);
+}
+
+/// \brief Point the column to the current position in the chunk, and move past it.
+template <typename T> void read_column(const char *&data, size_t size, const T *&column) {
+    column = reinterpret_cast<const T *>(data);
+    data += get_padded_size(size * sizeof(T));
+}
+
+} // namespace
+
+BinaryDatalogWriter::BinaryDatalogWriter(const std::string &_path_to_datalog)
+    : datalog_ofstream_(_path_to_datalog, std::ios::binary) {
+    assert(datalog_ofstream_ && "[ERROR] Failed to create the binary datalog file!");
+
+    // The header is completed once the datalog is closed.
+    std::memcpy(header_.magic, kBinaryDatalogMagic, sizeof(kBinaryDatalogMagic));
+    write_binary(datalog_ofstream_, header_);
+}
+
+BinaryDatalogWriter::~BinaryDatalogWriter() { close(); }
+
+void BinaryDatalogWriter::write_frame(const DatalogFrame &frame) {
+    assert(!closed_ && "[ERROR] Cannot write to a closed binary datalog!");
+    assert(!frame.delta_encoded && "[ERROR] The binary datalog needs frames captured in full!");
+
+    if (header_.num_frames == 0) {
+        header_.num_vehicles = frame.vehicle_poses.size();
+    }
+    assert(frame.vehicle_poses.size() == header_.num_vehicles &&
+           "[ERROR] The number of vehicles must not change across frames!");
+
+    system_time_ms_.push_back(frame.system_time_ms);
+
+    // The vehicles and their remaining polylines.
+    auto waypoint_begin = 0;
+    auto pose_begin = 0;
+    for (auto i = 0; i < frame.vehicle_poses.size(); i++) {
+        vehicle_lon_.push_back(frame.vehicle_poses[i].lon);
+        vehicle_lat_.push_back(frame.vehicle_poses[i].lat);
+        vehicle_load_.push_back(frame.vehicle_loads[i]);
+
+        for (; waypoint_begin < frame.waypoint_ends[i]; waypoint_begin++) {
+            for (; pose_begin < frame.waypoint_pose_ends[waypoint_begin]; pose_begin++) {
+                waypoint_pose_lon_.push_back(frame.waypoint_poses[pose_begin].lon);
+                waypoint_pose_lat_.push_back(frame.waypoint_poses[pose_begin].lat);
+            }
+            waypoint_pose_ends_.push_back(waypoint_pose_lon_.size());
+        }
+        vehicle_waypoint_ends_.push_back(waypoint_pose_ends_.size());
+    }
+
+    // The trips first seen, and the trips whose status changed.
+    for (const auto &trip : frame.trips) {
+        if (trip.id >= trip_statuses_.size()) {
+            trip_statuses_.resize(trip.id + 1, TripStatus::UNDEFINED);
+
+            new_trip_id_.push_back(trip.id);
+            new_trip_request_time_ms_.push_back(trip.request_time_ms);
+            new_trip_max_pickup_time_ms_.push_back(trip.max_pickup_time_ms);
+            new_trip_origin_lon_.push_back(trip.origin.lon);
+            new_trip_origin_lat_.push_back(trip.origin.lat);
+            new_trip_destination_lon_.push_back(trip.destination.lon);
+            new_trip_destination_lat_.push_back(trip.destination.lat);
+        }
+
+        if (trip_statuses_[trip.id] != trip.status) {
+            trip_statuses_[trip.id] = trip.status;
+
+            trip_transition_id_.push_back(trip.id);
+            trip_transition_time_ms_.push_back(
+                trip.status == TripStatus::PICKED_UP
+                    ? trip.pickup_time_ms
+                    : trip.status == TripStatus::DROPPED_OFF ? trip.dropoff_time_ms
+                                                             : frame.system_time_ms);
+            trip_transition_status_.push_back(static_cast<uint8_t>(trip.status));
+        }
+    }
+    frame_new_trip_ends_.push_back(new_trip_id_.size());
+    frame_trip_transition_ends_.push_back(trip_transition_id_.size());
+
+    header_.num_frames++;
+
+    if (system_time_ms_.size() == kBinaryDatalogFramesPerChunk) {
+        write_chunk();
+    }
+}
+
+void BinaryDatalogWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+
+    if (!system_time_ms_.empty()) {
+        write_chunk();
+    }
+
+    // Write the index, then complete the header at the beginning.
+    header_.num_chunks = index_.size();
+    header_.index_offset = datalog_ofstream_.tellp();
+    datalog_ofstream_.write(reinterpret_cast<const char *>(index_.data()),
+                            index_.size() * sizeof(BinaryDatalogIndexEntry));
+
+    datalog_ofstream_.seekp(0);
+    write_binary(datalog_ofstream_, header_);
+    datalog_ofstream_.close();
+}
+
+size_t BinaryDatalogWriter::get_buffer_bytes() const {
+    return get_heap_bytes(index_) + get_heap_bytes(trip_statuses_) +
+           get_heap_bytes(system_time_ms_) + get_heap_bytes(vehicle_lon_) +
+           get_heap_bytes(vehicle_lat_) + get_heap_bytes(vehicle_load_) +
+           get_heap_bytes(vehicle_waypoint_ends_) + get_heap_bytes(waypoint_pose_ends_) +
+           get_heap_bytes(waypoint_pose_lon_) + get_heap_bytes(waypoint_pose_lat_) +
+           get_heap_bytes(frame_new_trip_ends_) + get_heap_bytes(new_trip_id_) +
+           get_heap_bytes(new_trip_request_time_ms_) +
+           get_heap_bytes(new_trip_max_pickup_time_ms_) + get_heap_bytes(new_trip_origin_lon_) +
+           get_heap_bytes(new_trip_origin_lat_) + get_heap_bytes(new_trip_destination_lon_) +
+           get_heap_bytes(new_trip_destination_lat_) + get_heap_bytes(frame_trip_transition_ends_) +
+           get_heap_bytes(trip_transition_id_) + get_heap_bytes(trip_transition_time_ms_) +
+           get_heap_bytes(trip_transition_status_);
+}
+
+void BinaryDatalogWriter::write_chunk() {
+    BinaryDatalogIndexEntry index_entry;
+    index_entry.offset = datalog_ofstream_.tellp();
+    index_entry.first_frame_index = header_.num_frames - system_time_ms_.size();
+    index_entry.num_frames = system_time_ms_.size();
+    index_entry.first_system_time_ms = system_time_ms_.front();
+    index_.push_back(index_entry);
+
+    BinaryDatalogChunkHeader chunk_header;
+    chunk_header.num_frames = system_time_ms_.size();
+    chunk_header.num_vehicles = header_.num_vehicles;
+    chunk_header.num_waypoints = waypoint_pose_ends_.size();
+    chunk_header.num_waypoint_poses = waypoint_pose_lon_.size();
+    chunk_header.num_new_trips = new_trip_id_.size();
+    chunk_header.num_trip_transitions = trip_transition_id_.size();
+    write_binary(datalog_ofstream_, chunk_header);
+
+    write_column(datalog_ofstream_, system_time_ms_);
+    write_column(datalog_ofstream_, vehicle_lon_);
+    write_column(datalog_ofstream_, vehicle_lat_);
+    write_column(datalog_ofstream_, vehicle_load_);
+    write_column(datalog_ofstream_, vehicle_waypoint_ends_);
+    write_column(datalog_ofstream_, waypoint_pose_ends_);
+    write_column(datalog_ofstream_, waypoint_pose_lon_);
+    write_column(datalog_ofstream_, waypoint_pose_lat_);
+    write_column(datalog_ofstream_, frame_new_trip_ends_);
+    write_column(datalog_ofstream_, new_trip_id_);
+    write_column(datalog_ofstream_, new_trip_request_time_ms_);
+    write_column(datalog_ofstream_, new_trip_max_pickup_time_ms_);
+    write_column(datalog_ofstream_, new_trip_origin_lon_);
+    write_column(datalog_ofstream_, new_trip_origin_lat_);
+    write_column(datalog_ofstream_, new_trip_destination_lon_);
+    write_column(datalog_ofstream_, new_trip_destination_lat_);
+    write_column(datalog_ofstream_, frame_trip_transition_ends_);
+    write_column(datalog_ofstream_, trip_transition_id_);
+    write_column(datalog_ofstream_, trip_transition_time_ms_);
+    write_column(datalog_ofstream_, trip_transition_status_);
+
+    // The memory of the columns is reused for the next chunk.
+    system_time_ms_.clear();
+    vehicle_lon_.clear();
+    vehicle_lat_.clear();
+    vehicle_load_.clear();
+    vehicle_waypoint_ends_.clear();
+    waypoint_pose_ends_.clear();
+    waypoint_pose_lon_.clear();
+    waypoint_pose_lat_.clear();
+    frame_new_trip_ends_.clear();
+    new_trip_id_.clear();
+    new_trip_request_time_ms_.clear();
+    new_trip_max_pickup_time_ms_.clear();
+    new_trip_origin_lon_.clear();
+    new_trip_origin_lat_.clear();
+    new_trip_destination_lon_.clear();
+    new_trip_destination_lat_.clear();
+    frame_trip_transition_ends_.clear();
+    trip_transition_id_.clear();
+    trip_transition_time_ms_.clear();
+    trip_transition_status_.clear();
+}
+
+BinaryDatalogReader::BinaryDatalogReader(const std::string &_path_to_datalog) {
+    const auto fd = open(_path_to_datalog.c_str(), O_RDONLY);
+    assert(fd >= 0 && "[ERROR] Failed to open the binary datalog in BinaryDatalogReader!");
+
+    struct stat file_stat;
+    fstat(fd, &file_stat);
+    mapped_size_ = file_stat.st_size;
+    assert(mapped_size_ >= sizeof(BinaryDatalogHeader) &&
+           "[ERROR] The binary datalog is too small to contain a header in BinaryDatalogReader!");
+
+    // The mapping stays valid after the file descriptor is closed.
+    mapped_data_ = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    assert(mapped_data_ != MAP_FAILED &&
+           "[ERROR] Failed to map the binary datalog in BinaryDatalogReader!");
+
+    header_ = static_cast<const BinaryDatalogHeader *>(mapped_data_);
+    assert(std::memcmp(header_->magic, kBinaryDatalogMagic, sizeof(kBinaryDatalogMagic)) == 0 &&
+           "[ERROR] The file is not a binary datalog in BinaryDatalogReader!");
+    assert(header_->version == kBinaryDatalogVersion &&
+           "[ERROR] The binary datalog has an unsupported version in BinaryDatalogReader!");
+    assert(header_->index_offset > 0 &&
+           header_->index_offset + header_->num_chunks * sizeof(BinaryDatalogIndexEntry) ==
+               mapped_size_ &&
+           "[ERROR] The binary datalog was not closed properly in BinaryDatalogReader!");
+
+    index_ = reinterpret_cast<const BinaryDatalogIndexEntry *>(
+        static_cast<const char *>(mapped_data_) + header_->index_offset);
+}
+
+BinaryDatalogReader::~BinaryDatalogReader() {
+    if (mapped_data_ != nullptr) {
+        munmap(mapped_data_, mapped_size_);
+    }
+}
+
+const BinaryDatalogIndexEntry &BinaryDatalogReader::get_index_entry(size_t chunk_index) const {
+    assert(chunk_index < header_->num_chunks && "[ERROR] The chunk index is out of bound!");
+
+    return index_[chunk_index];
+}
+
+BinaryDatalogChunk BinaryDatalogReader::get_chunk(size_t chunk_index) const {
+    const auto data_begin = static_cast<const char *>(mapped_data_);
+    auto data = data_begin + get_index_entry(chunk_index).offset;
+
+    BinaryDatalogChunk chunk;
+    std::memcpy(&chunk.header, data, sizeof(BinaryDatalogChunkHeader));
+    data += sizeof(BinaryDatalogChunkHeader);
+
+    const auto &h = chunk.header;
+    const auto num_vehicle_frames = h.num_frames * h.num_vehicles;
+
+    read_column(data, h.num_frames, chunk.system_time_ms);
+    read_column(data, num_vehicle_frames, chunk.vehicle_lon);
+    read_column(data, num_vehicle_frames, chunk.vehicle_lat);
+    read_column(data, num_vehicle_frames, chunk.vehicle_load);
+    read_column(data, num_vehicle_frames, chunk.vehicle_waypoint_ends);
+    read_column(data, h.num_waypoints, chunk.waypoint_pose_ends);
+    read_column(data, h.num_waypoint_poses, chunk.waypoint_pose_lon);
+    read_column(data, h.num_waypoint_poses, chunk.waypoint_pose_lat);
+    read_column(data, h.num_frames, chunk.frame_new_trip_ends);
+    read_column(data, h.num_new_trips, chunk.new_trip_id);
+    read_column(data, h.num_new_trips, chunk.new_trip_request_time_ms);
+    read_column(data, h.num_new_trips, chunk.new_trip_max_pickup_time_ms);
+    read_column(data, h.num_new_trips, chunk.new_trip_origin_lon);
+    read_column(data, h.num_new_trips, chunk.new_trip_origin_lat);
+    read_column(data, h.num_new_trips, chunk.new_trip_destination_lon);
+    read_column(data, h.num_new_trips, chunk.new_trip_destination_lat);
+    read_column(data, h.num_frames, chunk.frame_trip_transition_ends);
+    read_column(data, h.num_trip_transitions, chunk.trip_transition_id);
+    read_column(data, h.num_trip_transitions, chunk.trip_transition_time_ms);
+    read_column(data, h.num_trip_transitions, chunk.trip_transition_status);
+
+    assert(data <= data_begin + header_->index_offset &&
+           "[ERROR] The chunk overruns the index in BinaryDatalogReader!");
+
+    return chunk;
+}
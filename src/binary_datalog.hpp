@@ -0,0 +1,193 @@
+/// \author Jian Wen
+/// \date 2021/02/27
+
+#pragma once
+
+#include "datalog.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// \brief The magic number at the beginning of a binary datalog.
+constexpr char kBinaryDatalogMagic[8] = {'M', 'O', 'D', 'D', 'L', 'O', 'G', '\0'};
+
+/// \brief The version of the binary datalog format.
+constexpr uint32_t kBinaryDatalogVersion = 1;
+
+/// \brief The max number of frames in each chunk of the binary datalog.
+constexpr size_t kBinaryDatalogFramesPerChunk = 64;
+
+/// \brief The header of a binary datalog, followed by the chunks and then by the index of chunks.
+/// \details The counts and the offset of the index are filled in once the datalog is closed, so a
+/// datalog with a zero index_offset was not closed properly.
+struct BinaryDatalogHeader {
+    char magic[8];
+    uint32_t version = kBinaryDatalogVersion;
+    uint32_t frames_per_chunk = kBinaryDatalogFramesPerChunk;
+    uint64_t num_vehicles = 0;
+    uint64_t num_frames = 0;
+    uint64_t num_chunks = 0;
+    uint64_t index_offset = 0;
+};
+
+/// \brief The entry of a chunk in the index at the end of the binary datalog.
+struct BinaryDatalogIndexEntry {
+    uint64_t offset = 0;               // the offset of the chunk in the file
+    uint64_t first_frame_index = 0;    // the index of the first frame in the chunk
+    uint64_t num_frames = 0;           // the number of frames in the chunk
+    uint64_t first_system_time_ms = 0; // the system time of the first frame in the chunk
+};
+
+/// \brief The header of a chunk, followed by its columns in the order of BinaryDatalogChunk.
+/// \details Each column is a plain array, padded to a multiple of 8 bytes, so that it can be mapped
+/// as is. The ends are exclusive prefix sums within the chunk, as in DatalogFrame.
+struct BinaryDatalogChunkHeader {
+    uint64_t num_frames = 0;
+    uint64_t num_vehicles = 0;
+    uint64_t num_waypoints = 0;
+    uint64_t num_waypoint_poses = 0;
+    uint64_t num_new_trips = 0;
+    uint64_t num_trip_transitions = 0;
+};
+
+static_assert(sizeof(BinaryDatalogHeader) == 48, "BinaryDatalogHeader must be packed!");
+static_assert(sizeof(BinaryDatalogIndexEntry) == 32, "BinaryDatalogIndexEntry must be packed!");
+static_assert(sizeof(BinaryDatalogChunkHeader) == 48, "BinaryDatalogChunkHeader must be packed!");
+
+/// \brief The columns of a chunk, pointing into the mapped file.
+/// \details The vehicle columns are indexed by frame * num_vehicles + vehicle. A trip appears in
+/// the new trips of the frame where it is first seen, and in the trip transitions of each frame
+/// where its status changes, with the time of the change (the pickup or dropoff time if known).
+struct BinaryDatalogChunk {
+    BinaryDatalogChunkHeader header;
+
+    const uint64_t *system_time_ms = nullptr;              // [num_frames]
+    const float *vehicle_lon = nullptr;                    // [num_frames * num_vehicles]
+    const float *vehicle_lat = nullptr;                    // [num_frames * num_vehicles]
+    const uint32_t *vehicle_load = nullptr;                // [num_frames * num_vehicles]
+    const uint32_t *vehicle_waypoint_ends = nullptr;       // [num_frames * num_vehicles]
+    const uint32_t *waypoint_pose_ends = nullptr;          // [num_waypoints]
+    const float *waypoint_pose_lon = nullptr;              // [num_waypoint_poses]
+    const float *waypoint_pose_lat = nullptr;              // [num_waypoint_poses]
+
+    const uint32_t *frame_new_trip_ends = nullptr;         // [num_frames]
+    const uint64_t *new_trip_id = nullptr;                 // [num_new_trips]
+    const uint64_t *new_trip_request_time_ms = nullptr;    // [num_new_trips]
+    const uint64_t *new_trip_max_pickup_time_ms = nullptr; // [num_new_trips]
+    const float *new_trip_origin_lon = nullptr;            // [num_new_trips]
+    const float *new_trip_origin_lat = nullptr;            // [num_new_trips]
+    const float *new_trip_destination_lon = nullptr;       // [num_new_trips]
+    const float *new_trip_destination_lat = nullptr;       // [num_new_trips]
+
+    const uint32_t *frame_trip_transition_ends = nullptr;  // [num_frames]
+    const uint64_t *trip_transition_id = nullptr;          // [num_trip_transitions]
+    const uint64_t *trip_transition_time_ms = nullptr;     // [num_trip_transitions]
+    const uint8_t *trip_transition_status = nullptr;       // [num_trip_transitions]
+};
+
+/// \brief The writer of the binary, chunked and columnar datalog.
+/// \details The frames are buffered column by column, and written as one chunk every
+/// kBinaryDatalogFramesPerChunk frames. The index of chunks is written when the datalog is closed.
+/// Only the trips created or changed since the previous frame are written.
+class BinaryDatalogWriter {
+  public:
+    /// \brief Constructor that creates the datalog file.
+    explicit BinaryDatalogWriter(const std::string &_path_to_datalog);
+
+    /// \brief Destructor that closes the datalog.
+    ~BinaryDatalogWriter();
+
+    BinaryDatalogWriter(const BinaryDatalogWriter &) = delete;
+    BinaryDatalogWriter &operator=(const BinaryDatalogWriter &) = delete;
+
+    /// \brief Append the frame, which must be captured in full (not delta encoded).
+    void write_frame(const DatalogFrame &frame);
+
+    /// \brief Write the pending chunk and the index. Nothing can be written afterwards.
+    void close();
+
+    /// \brief Get the bytes allocated by the buffered chunk, the index and the trip statuses.
+    size_t get_buffer_bytes() const;
+
+  private:
+    /// \brief Write the buffered frames as one chunk.
+    void write_chunk();
+
+    /// \brief The ofstream that outputs to the datalog.
+    std::ofstream datalog_ofstream_;
+
+    /// \brief The header, completed once closed.
+    BinaryDatalogHeader header_;
+
+    /// \brief The index of the chunks written so far.
+    std::vector<BinaryDatalogIndexEntry> index_ = {};
+
+    /// \brief The status of each trip as of the previous frame.
+    std::vector<TripStatus> trip_statuses_ = {};
+
+    /// \brief True if closed.
+    bool closed_ = false;
+
+    // The columns of the frames buffered for the next chunk.
+    std::vector<uint64_t> system_time_ms_ = {};
+    std::vector<float> vehicle_lon_ = {};
+    std::vector<float> vehicle_lat_ = {};
+    std::vector<uint32_t> vehicle_load_ = {};
+    std::vector<uint32_t> vehicle_waypoint_ends_ = {};
+    std::vector<uint32_t> waypoint_pose_ends_ = {};
+    std::vector<float> waypoint_pose_lon_ = {};
+    std::vector<float> waypoint_pose_lat_ = {};
+    std::vector<uint32_t> frame_new_trip_ends_ = {};
+    std::vector<uint64_t> new_trip_id_ = {};
+    std::vector<uint64_t> new_trip_request_time_ms_ = {};
+    std::vector<uint64_t> new_trip_max_pickup_time_ms_ = {};
+    std::vector<float> new_trip_origin_lon_ = {};
+    std::vector<float> new_trip_origin_lat_ = {};
+    std::vector<float> new_trip_destination_lon_ = {};
+    std::vector<float> new_trip_destination_lat_ = {};
+    std::vector<uint32_t> frame_trip_transition_ends_ = {};
+    std::vector<uint64_t> trip_transition_id_ = {};
+    std::vector<uint64_t> trip_transition_time_ms_ = {};
+    std::vector<uint8_t> trip_transition_status_ = {};
+};
+
+/// \brief The reader of the binary datalog, which maps the file into memory.
+/// \details The chunks are located through the index, and their columns are read in place without
+/// copying. Only the pages that are accessed are loaded.
+class BinaryDatalogReader {
+  public:
+    /// \brief Constructor that maps the datalog file.
+    explicit BinaryDatalogReader(const std::string &_path_to_datalog);
+
+    /// \brief Destructor that unmaps the file.
+    ~BinaryDatalogReader();
+
+    BinaryDatalogReader(const BinaryDatalogReader &) = delete;
+    BinaryDatalogReader &operator=(const BinaryDatalogReader &) = delete;
+
+    /// \brief Get the header of the datalog.
+    const BinaryDatalogHeader &get_header() const { return *header_; }
+
+    /// \brief Get the index entry of the chunk.
+    const BinaryDatalogIndexEntry &get_index_entry(size_t chunk_index) const;
+
+    /// \brief Get the columns of the chunk.
+    BinaryDatalogChunk get_chunk(size_t chunk_index) const;
+
+  private:
+    /// \brief The start of the mapped file.
+    void *mapped_data_ = nullptr;
+
+    /// \brief The size of the mapped file in bytes.
+    size_t mapped_size_ = 0;
+
+    /// \brief The header in the mapped file.
+    const BinaryDatalogHeader *header_ = nullptr;
+
+    /// \brief The index in the mapped file.
+    const BinaryDatalogIndexEntry *index_ = nullptr;
+};
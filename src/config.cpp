@@ -5,6 +5,8 @@
 
 #include <fmt/format.h>
 
+#include <cstdlib>
+
 PlatformConfig load_platform_config(const std::string &path_to_platform_config) {
     auto platform_config_yaml = YAML::LoadFile(path_to_platform_config);
 
@@ -32,6 +34,17 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config)
         platform_config_yaml["mod_system_config"]["request_config"]["max_pickup_wait_time_s"]
             .as<double>();
 
+    // The dispatch config is optional, which dispatches globally if missing.
+    const auto dispatch_config_yaml = platform_config_yaml["mod_system_config"]["dispatch_config"];
+    if (dispatch_config_yaml) {
+        auto &dispatch_config = platform_config.mod_system_config.dispatch_config;
+
+        dispatch_config.num_zone_cols = dispatch_config_yaml["num_zone_cols"].as<size_t>();
+        dispatch_config.num_zone_rows = dispatch_config_yaml["num_zone_rows"].as<size_t>();
+        dispatch_config.zone_border_m = dispatch_config_yaml["zone_border_m"].as<double>();
+        dispatch_config.num_threads = dispatch_config_yaml["num_threads"].as<size_t>();
+    }
+
     platform_config.simulation_config.cycle_s =
         platform_config_yaml["simulation_config"]["cycle_s"].as<double>();
     platform_config.simulation_config.simulation_duration_s =
@@ -40,12 +53,54 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config)
         platform_config_yaml["simulation_config"]["warmup_duration_s"].as<double>();
     platform_config.simulation_config.winddown_duration_s =
         platform_config_yaml["simulation_config"]["winddown_duration_s"].as<double>();
+    if (platform_config_yaml["simulation_config"]["event_driven"]) {
+        platform_config.simulation_config.event_driven =
+            platform_config_yaml["simulation_config"]["event_driven"].as<bool>();
+    }
+    if (platform_config_yaml["simulation_config"]["route_simplification_m"]) {
+        platform_config.simulation_config.route_simplification_m =
+            platform_config_yaml["simulation_config"]["route_simplification_m"].as<double>();
+    }
 
     platform_config.output_config.datalog_config.output_datalog =
         platform_config_yaml["output_config"]["datalog_config"]["output_datalog"].as<bool>();
     platform_config.output_config.datalog_config.path_to_output_datalog =
         platform_config_yaml["output_config"]["datalog_config"]["path_to_output_datalog"]
             .as<std::string>();
+    if (platform_config_yaml["output_config"]["datalog_config"]["delta_encoded"]) {
+        platform_config.output_config.datalog_config.delta_encoded =
+            platform_config_yaml["output_config"]["datalog_config"]["delta_encoded"].as<bool>();
+    }
+    if (platform_config_yaml["output_config"]["datalog_config"]["binary"]) {
+        platform_config.output_config.datalog_config.binary =
+            platform_config_yaml["output_config"]["datalog_config"]["binary"].as<bool>();
+    }
+    if (platform_config_yaml["output_config"]["datalog_config"]["compression"]) {
+        const auto compression =
+            platform_config_yaml["output_config"]["datalog_config"]["compression"]
+                .as<std::string>();
+        if (compression == "gzip") {
+            platform_config.output_config.datalog_config.compression = DatalogCompression::GZIP;
+        } else if (compression == "zstd") {
+#ifdef MODABM_WITH_ZSTD
+            platform_config.output_config.datalog_config.compression = DatalogCompression::ZSTD;
+#else
+            // Fail even if the asserts are compiled out, rather than write an uncompressed datalog.
+            fmt::print(stderr,
+                       "[ERROR] Config has compression zstd, which is not supported in this "
+                       "build! Use gzip, or rebuild with MODABM_WITH_ZSTD on (Boost 1.70 and "
+                       "later, built with zstd).\n");
+            std::exit(-1);
+#endif
+        } else {
+            assert(compression == "none" && "Config must have compression none, gzip or zstd!");
+        }
+    }
+    if (platform_config_yaml["output_config"]["datalog_config"]["compression_level"]) {
+        platform_config.output_config.datalog_config.compression_level =
+            platform_config_yaml["output_config"]["datalog_config"]["compression_level"]
+                .as<int>();
+    }
     platform_config.output_config.video_config.render_video =
         platform_config_yaml["output_config"]["video_config"]["render_video"].as<bool>();
     platform_config.output_config.video_config.path_to_output_video =
@@ -55,20 +110,46 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config)
         platform_config_yaml["output_config"]["video_config"]["frames_per_cycle"].as<size_t>();
     platform_config.output_config.video_config.replay_speed =
         platform_config_yaml["output_config"]["video_config"]["replay_speed"].as<double>();
+    if (platform_config_yaml["output_config"]["trace_config"]) {
+        platform_config.output_config.trace_config.output_trace =
+            platform_config_yaml["output_config"]["trace_config"]["output_trace"].as<bool>();
+        platform_config.output_config.trace_config.path_to_output_trace =
+            platform_config_yaml["output_config"]["trace_config"]["path_to_output_trace"]
+                .as<std::string>();
+    }
+
+    if (platform_config_yaml["output_config"]["print_cycles"]) {
+        platform_config.output_config.print_cycles =
+            platform_config_yaml["output_config"]["print_cycles"].as<bool>();
+    }
 
     fmt::print("[INFO] Loaded the platform configuration yaml file from {}.\n",
                path_to_platform_config);
 
     // Sanity check of the input config.
+    assert(platform_config.mod_system_config.dispatch_config.num_zone_cols > 0 &&
+           platform_config.mod_system_config.dispatch_config.num_zone_rows > 0 &&
+           "Config must have at least one zone along the longitude and the latitude!");
     if (platform_config.output_config.datalog_config.output_datalog) {
         assert(platform_config.output_config.datalog_config.path_to_output_datalog != "" &&
                "Config must have non-empty path_to_output_datalog if output_datalog is true!");
+        assert(!(platform_config.output_config.datalog_config.binary &&
+                 platform_config.output_config.datalog_config.delta_encoded) &&
+               "Config must not have delta_encoded on if binary is true!");
+        assert(!(platform_config.output_config.datalog_config.binary &&
+                 platform_config.output_config.datalog_config.compression !=
+                     DatalogCompression::NONE) &&
+               "Config must not have compression if binary is true!");
     }
     if (platform_config.output_config.video_config.render_video) {
         assert(platform_config.output_config.datalog_config.output_datalog &&
                "Config must have output_datalog config on if render_video is true!");
         assert(platform_config.output_config.video_config.path_to_output_video != "" &&
                "Config must have non-empty path_to_output_video if render_video is true!");
+    }
+    if (platform_config.output_config.trace_config.output_trace) {
+        assert(platform_config.output_config.trace_config.path_to_output_trace != "" &&
+               "Config must have non-empty path_to_output_trace if output_trace is true!");
         assert(platform_config.output_config.video_config.frames_per_cycle > 0 &&
                "Config must have positive frames_per_cycle if render_video is true!");
         assert(platform_config.output_config.video_config.replay_speed > 0 &&
@@ -77,3 +158,101 @@ PlatformConfig load_platform_config(const std::string &path_to_platform_config)
 
     return platform_config;
 }
+
+SweepConfig load_sweep_config(const std::string &path_to_sweep_config,
+                              const PlatformConfig &base_platform_config) {
+    auto sweep_config_yaml = YAML::LoadFile(path_to_sweep_config);
+
+    SweepConfig sweep_config;
+
+    sweep_config.fleet_sizes =
+        sweep_config_yaml["fleet_size"]
+            ? sweep_config_yaml["fleet_size"].as<std::vector<size_t>>()
+            : std::vector<size_t>{base_platform_config.mod_system_config.fleet_config.fleet_size};
+    sweep_config.veh_capacities =
+        sweep_config_yaml["veh_capacity"]
+            ? sweep_config_yaml["veh_capacity"].as<std::vector<size_t>>()
+            : std::vector<size_t>{base_platform_config.mod_system_config.fleet_config.veh_capacity};
+    sweep_config.max_pickup_wait_times_s =
+        sweep_config_yaml["max_pickup_wait_time_s"]
+            ? sweep_config_yaml["max_pickup_wait_time_s"].as<std::vector<double>>()
+            : std::vector<double>{
+                  base_platform_config.mod_system_config.request_config.max_pickup_wait_time_s};
+    sweep_config.seeds = sweep_config_yaml["seeds"].as<std::vector<uint64_t>>();
+
+    fmt::print("[INFO] Loaded the sweep configuration yaml file from {}.\n", path_to_sweep_config);
+
+    // Sanity check of the input config.
+    assert(!sweep_config.fleet_sizes.empty() && !sweep_config.veh_capacities.empty() &&
+           !sweep_config.max_pickup_wait_times_s.empty() && !sweep_config.seeds.empty() &&
+           "Config must have at least one value for each of the sweep parameters!");
+
+    return sweep_config;
+}
+
+RegressionConfig load_regression_config(const std::string &path_to_regression_config) {
+    auto regression_config_yaml = YAML::LoadFile(path_to_regression_config);
+
+    RegressionConfig regression_config;
+
+    for (const auto &scenario_yaml : regression_config_yaml["scenarios"]) {
+        RegressionScenario scenario;
+        scenario.name = scenario_yaml["name"].as<std::string>();
+        scenario.platform_config =
+            load_platform_config(scenario_yaml["path_to_platform_config"].as<std::string>());
+        scenario.path_to_demand_config = scenario_yaml["path_to_demand_config"].as<std::string>();
+        scenario.seed = scenario_yaml["seed"].as<uint64_t>();
+
+        // The overrides exercise the other code paths on the same platform config.
+        auto &dispatch_config = scenario.platform_config.mod_system_config.dispatch_config;
+        if (scenario_yaml["event_driven"]) {
+            scenario.platform_config.simulation_config.event_driven =
+                scenario_yaml["event_driven"].as<bool>();
+        }
+        if (scenario_yaml["num_zone_cols"]) {
+            dispatch_config.num_zone_cols = scenario_yaml["num_zone_cols"].as<size_t>();
+        }
+        if (scenario_yaml["num_zone_rows"]) {
+            dispatch_config.num_zone_rows = scenario_yaml["num_zone_rows"].as<size_t>();
+        }
+        if (scenario_yaml["num_threads"]) {
+            dispatch_config.num_threads = scenario_yaml["num_threads"].as<size_t>();
+        }
+
+        auto &output_config = scenario.platform_config.output_config;
+        output_config.datalog_config.output_datalog = false;
+        output_config.video_config.render_video = false;
+        output_config.trace_config.output_trace = false;
+
+        regression_config.scenarios.emplace_back(std::move(scenario));
+    }
+
+    if (regression_config_yaml["tolerances"]) {
+        const auto tolerances_yaml = regression_config_yaml["tolerances"];
+        regression_config.tolerances.runtime = tolerances_yaml["runtime"].as<double>();
+        regression_config.tolerances.router_calls = tolerances_yaml["router_calls"].as<double>();
+        regression_config.tolerances.peak_memory = tolerances_yaml["peak_memory"].as<double>();
+        if (tolerances_yaml["peak_memory_slack_bytes"]) {
+            regression_config.tolerances.peak_memory_slack_bytes =
+                tolerances_yaml["peak_memory_slack_bytes"].as<double>();
+        }
+    }
+    if (regression_config_yaml["num_repeats"]) {
+        regression_config.num_repeats = regression_config_yaml["num_repeats"].as<size_t>();
+    }
+
+    fmt::print("[INFO] Loaded the regression configuration yaml file from {}.\n",
+               path_to_regression_config);
+
+    // Sanity check of the input config.
+    assert(!regression_config.scenarios.empty() && regression_config.num_repeats > 0 &&
+           "Config must have at least one scenario and one repeat!");
+    for (auto i = 0; i < regression_config.scenarios.size(); i++) {
+        for (auto j = 0; j < i; j++) {
+            assert(regression_config.scenarios[i].name != regression_config.scenarios[j].name &&
+                   "Config must have unique scenario names!");
+        }
+    }
+
+    return regression_config;
+}
@@ -27,10 +27,20 @@ struct RequestConfig {
                                          // and the traveler is picked up
 };
 
+/// \brief Config that describes the dispatch.
+struct DispatchConfig {
+    size_t num_zone_cols = 1;    // the number of zones along the longitude, 1 x 1 = global dispatch
+    size_t num_zone_rows = 1;    // the number of zones along the latitude
+    double zone_border_m = 1000; // the trips requested within x meters of a zone border are left to
+                                 // the serial reconciliation across zones
+    size_t num_threads = 1;      // the number of threads dispatching the zones in parallel
+};
+
 /// \brief Config that describes the simulated MoD system.
 struct MoDSystemConfig {
     FleetConfig fleet_config;
     RequestConfig request_config;
+    DispatchConfig dispatch_config;
 };
 
 /// \brief Config that describes the simulation parameters.
@@ -40,12 +50,39 @@ struct SimulationConfig {
         600; // the main period during which the simulated data is used for analysis
     double warmup_duration_s = 1200;   // the period before the main sim to build up states
     double winddown_duration_s = 1200; // the period after the main sim to close trips
+    bool event_driven = false; // true if vehicles are only advanced when they reach waypoints or
+                               // when their states are needed, instead of every frame
+    double route_simplification_m = 0; // the tolerance in meters of simplifying the geometry of
+                                       // the routes, 0 to keep every pos
 };
 
+/// \brief The compression of the yaml datalog.
+enum class DatalogCompression {
+    NONE, // uncompressed
+    GZIP, // gzip
+    ZSTD  // zstd, if supported in the build
+};
+
+inline std::string to_string(const DatalogCompression &c) {
+    if (c == DatalogCompression::NONE) {
+        return "none";
+    } else if (c == DatalogCompression::GZIP) {
+        return "gzip";
+    } else if (c == DatalogCompression::ZSTD) {
+        return "zstd";
+    }
+
+    assert(false && "Bad DatalogCompression type!");
+}
+
 /// \brief Config for the output datalog.
 struct DatalogConfig {
     bool output_datalog = false;             // true if we output datalog
     std::string path_to_output_datalog = ""; // the path to the output datalog, empty if no output
+    bool delta_encoded = false; // true if each route is written once and frames only hold changes
+    bool binary = false;        // true if written in the binary columnar format instead of yaml
+    DatalogCompression compression = DatalogCompression::NONE; // the compression of the yaml
+    int compression_level = 0; // the compression level, 0 for the default of the compression
 };
 
 /// \brief Config for video rendering.
@@ -56,10 +93,18 @@ struct VideoConfig {
     double replay_speed = 60; // the speed of the video replay as compared to the actual system time
 };
 
-/// \brief Config that describes the output modes for datalog and video.
+/// \brief Config for the trace of the simulation phases.
+struct TraceConfig {
+    bool output_trace = false;             // true if we trace the phases of each cycle
+    std::string path_to_output_trace = ""; // the path to the output trace in the Chrome format
+};
+
+/// \brief Config that describes the output modes for datalog, video and trace.
 struct OutputConfig {
     DatalogConfig datalog_config;
     VideoConfig video_config;
+    TraceConfig trace_config;
+    bool print_cycles = true; // true if we print a line as each cycle starts
 };
 
 /// \brief The set of config parameters for the simulation platform.
@@ -72,3 +117,45 @@ struct PlatformConfig {
 
 /// \brief Load yaml platform config and convert into the C++ data struct.
 PlatformConfig load_platform_config(const std::string &path_to_platform_config);
+
+/// \brief The grid of config overrides for a parameter sweep. Each combination of the overrides is
+/// a variant, which is simulated once for each seed.
+struct SweepConfig {
+    std::vector<size_t> fleet_sizes = {};             // fleet sizes to sweep
+    std::vector<size_t> veh_capacities = {};          // vehicle capacities to sweep
+    std::vector<double> max_pickup_wait_times_s = {}; // max pickup wait times to sweep
+    std::vector<uint64_t> seeds = {};                 // seeds shared by all variants
+};
+
+/// \brief Load yaml sweep config and convert into the C++ data struct. The overrides missing from
+/// the yaml file take the values in the base platform config.
+SweepConfig load_sweep_config(const std::string &path_to_sweep_config,
+                              const PlatformConfig &base_platform_config);
+
+/// \brief A golden run of the regression harness, i.e. one platform config simulated on one demand
+/// with one seed. The datalog, video and trace are always off, so that only the simulation is run.
+struct RegressionScenario {
+    std::string name = "";                  // the name of the scenario, unique in the baseline
+    PlatformConfig platform_config;         // the platform config with the overrides applied
+    std::string path_to_demand_config = ""; // the path to the demand config
+    uint64_t seed = 0;                      // the seed of the demand generator
+};
+
+/// \brief The relative increase over the baseline allowed in the metrics that are not exact.
+struct RegressionTolerances {
+    double runtime = 0.25;                        // the tolerance of the total runtime
+    double router_calls = 0.0;                    // the tolerance of the number of router calls
+    double peak_memory = 0.1;                     // the tolerance of the peak memory
+    double peak_memory_slack_bytes = 1024 * 1024; // the increase in memory always allowed
+};
+
+/// \brief The scenarios of the regression harness and the tolerances to check them against.
+struct RegressionConfig {
+    std::vector<RegressionScenario> scenarios = {}; // the scenarios, run in the listed order
+    RegressionTolerances tolerances;
+    size_t num_repeats = 3; // the runs of each scenario, of which the fastest is compared
+};
+
+/// \brief Load yaml regression config and convert into the C++ data struct. The platform config of
+/// each scenario is loaded as well, with the optional overrides of the scenario applied.
+RegressionConfig load_regression_config(const std::string &path_to_regression_config);
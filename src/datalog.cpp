@@ -0,0 +1,328 @@
+/// \author Jian Wen
+/// \date 2021/02/23
+
+#include "datalog.hpp"
+#include "binary_datalog.hpp"
+#include "memory.hpp"
+#include "tracer.hpp"
+#include "vehicle.hpp"
+
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#ifdef MODABM_WITH_ZSTD
+#include <boost/iostreams/filter/zstd.hpp>
+#endif
+#include <fmt/format.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <cassert>
+
+size_t get_heap_bytes(const DatalogFrame &frame) {
+    return get_heap_bytes(frame.vehicle_poses) + get_heap_bytes(frame.vehicle_loads) +
+           get_heap_bytes(frame.waypoint_ends) + get_heap_bytes(frame.waypoint_pose_ends) +
+           get_heap_bytes(frame.waypoint_poses) + get_heap_bytes(frame.trips) +
+           get_heap_bytes(frame.waypoint_route_ids) + get_heap_bytes(frame.waypoint_cursors) +
+           get_heap_bytes(frame.waypoint_elapsed_ms) + get_heap_bytes(frame.new_route_ids) +
+           get_heap_bytes(frame.new_route_pose_ends) + get_heap_bytes(frame.new_route_poses) +
+           get_heap_bytes(frame.new_route_time_offsets_ms);
+}
+
+void capture_datalog_frame(DatalogFrame &frame,
+                           uint64_t system_time_ms,
+                           const std::vector<Vehicle> &vehicles,
+                           const std::vector<Trip> &trips) {
+    frame.system_time_ms = system_time_ms;
+    frame.delta_encoded = false;
+    frame.vehicle_poses.clear();
+    frame.vehicle_loads.clear();
+    frame.waypoint_ends.clear();
+    frame.waypoint_pose_ends.clear();
+    frame.waypoint_poses.clear();
+    frame.new_route_ids.clear();
+
+    for (const auto &vehicle : vehicles) {
+        frame.vehicle_poses.push_back(vehicle.pos);
+        frame.vehicle_loads.push_back(vehicle.load);
+
+        for (const auto &waypoint : vehicle.waypoints) {
+            const auto &route = waypoint.route;
+
+            if (!route.poses.empty()) {
+                frame.waypoint_poses.push_back(get_current_pos_on_route(route));
+                frame.waypoint_poses.insert(frame.waypoint_poses.end(),
+                                            route.poses.begin() + route.cursor + 1,
+                                            route.poses.end());
+            }
+            frame.waypoint_pose_ends.push_back(frame.waypoint_poses.size());
+        }
+        frame.waypoint_ends.push_back(frame.waypoint_pose_ends.size());
+    }
+
+    frame.trips.assign(trips.begin(), trips.end());
+}
+
+void DatalogDeltaEncoder::capture(DatalogFrame &frame,
+                                  uint64_t system_time_ms,
+                                  const std::vector<Vehicle> &vehicles,
+                                  const std::vector<Trip> &trips) {
+    frame.system_time_ms = system_time_ms;
+    frame.delta_encoded = true;
+    frame.vehicle_poses.clear();
+    frame.vehicle_loads.clear();
+    frame.waypoint_ends.clear();
+    frame.waypoint_route_ids.clear();
+    frame.waypoint_cursors.clear();
+    frame.waypoint_elapsed_ms.clear();
+    frame.new_route_ids.clear();
+    frame.new_route_pose_ends.clear();
+    frame.new_route_poses.clear();
+    frame.new_route_time_offsets_ms.clear();
+    frame.trips.clear();
+
+    planned_routes_.resize(vehicles.size());
+
+    std::vector<PlannedRoute> planned_routes;
+    for (auto i = 0; i < vehicles.size(); i++) {
+        const auto &vehicle = vehicles[i];
+        frame.vehicle_poses.push_back(vehicle.pos);
+        frame.vehicle_loads.push_back(vehicle.load);
+
+        planned_routes.clear();
+        for (const auto &waypoint : vehicle.waypoints) {
+            const auto &route = waypoint.route;
+
+            // Look for the route among the ones planned in the previous frame.
+            auto it = std::find_if(
+                planned_routes_[i].begin(), planned_routes_[i].end(), [&](const auto &planned) {
+                    return planned.time_offsets_ms == route.time_offsets_ms &&
+                           std::equal(planned.poses.begin(),
+                                      planned.poses.end(),
+                                      route.poses.begin(),
+                                      route.poses.end(),
+                                      [](const Pos &a, const Pos &b) {
+                                          return a.lon == b.lon && a.lat == b.lat;
+                                      });
+                });
+
+            if (it != planned_routes_[i].end()) {
+                planned_routes.emplace_back(std::move(*it));
+                planned_routes_[i].erase(it);
+            } else {
+                planned_routes.push_back({next_route_id_++, route.poses, route.time_offsets_ms});
+
+                frame.new_route_ids.push_back(planned_routes.back().id);
+                frame.new_route_poses.insert(
+                    frame.new_route_poses.end(), route.poses.begin(), route.poses.end());
+                frame.new_route_time_offsets_ms.insert(frame.new_route_time_offsets_ms.end(),
+                                                       route.time_offsets_ms.begin(),
+                                                       route.time_offsets_ms.end());
+                frame.new_route_pose_ends.push_back(frame.new_route_poses.size());
+            }
+
+            frame.waypoint_route_ids.push_back(planned_routes.back().id);
+            frame.waypoint_cursors.push_back(route.cursor);
+            frame.waypoint_elapsed_ms.push_back(route.elapsed_ms);
+        }
+        frame.waypoint_ends.push_back(frame.waypoint_route_ids.size());
+
+        // The routes no longer planned are forgotten, and their ids are never reused.
+        std::swap(planned_routes_[i], planned_routes);
+    }
+
+    // Only the trips created or changed since the previous frame.
+    for (const auto &trip : trips) {
+        if (trip.id >= trip_statuses_.size()) {
+            trip_statuses_.resize(trip.id + 1, TripStatus::UNDEFINED);
+        }
+        if (trip_statuses_[trip.id] != trip.status) {
+            trip_statuses_[trip.id] = trip.status;
+            frame.trips.push_back(trip);
+        }
+    }
+}
+
+size_t DatalogDeltaEncoder::get_buffer_bytes() const {
+    auto bytes = get_heap_bytes(planned_routes_) + get_heap_bytes(trip_statuses_);
+
+    for (const auto &vehicle_routes : planned_routes_) {
+        bytes += get_heap_bytes(vehicle_routes);
+
+        for (const auto &route : vehicle_routes) {
+            bytes += get_heap_bytes(route.poses) + get_heap_bytes(route.time_offsets_ms);
+        }
+    }
+
+    return bytes;
+}
+
+namespace {
+
+YAML::Node convert_pos_to_yaml(const Pos &pos) {
+    YAML::Node pos_node;
+    pos_node["lon"] = fmt::format("{:.6f}", pos.lon);
+    pos_node["lat"] = fmt::format("{:.6f}", pos.lat);
+
+    return pos_node;
+}
+
+} // namespace
+
+void write_datalog_frame(std::ostream &out, const DatalogFrame &frame) {
+    YAML::Node node;
+
+    node["system_time_ms"] = frame.system_time_ms;
+
+    // For each of the new routes, we write the geometry in yaml format (delta encoded only).
+    auto pose_begin = 0;
+    for (auto i = 0; i < frame.new_route_ids.size(); i++) {
+        YAML::Node poses_node;
+        YAML::Node time_offsets_node;
+        for (; pose_begin < frame.new_route_pose_ends[i]; pose_begin++) {
+            poses_node.push_back(convert_pos_to_yaml(frame.new_route_poses[pose_begin]));
+            time_offsets_node.push_back(frame.new_route_time_offsets_ms[pose_begin]);
+        }
+
+        YAML::Node route_node;
+        route_node["id"] = frame.new_route_ids[i];
+        route_node["poses"] = std::move(poses_node);
+        route_node["time_offsets_ms"] = std::move(time_offsets_node);
+        node["routes"].push_back(std::move(route_node));
+    }
+
+    // For each of the vehicles, we write the relavant data in yaml format.
+    auto waypoint_begin = 0;
+    pose_begin = 0;
+    for (auto i = 0; i < frame.vehicle_poses.size(); i++) {
+        YAML::Node veh_node;
+        veh_node["pos"] = convert_pos_to_yaml(frame.vehicle_poses[i]);
+
+        YAML::Node waypoints_node;
+        for (; waypoint_begin < frame.waypoint_ends[i]; waypoint_begin++) {
+            YAML::Node waypoint_node;
+            if (frame.delta_encoded) {
+                // The waypoint refers to the route by id, with the progress along it.
+                waypoint_node["route_id"] = frame.waypoint_route_ids[waypoint_begin];
+                waypoint_node["cursor"] = frame.waypoint_cursors[waypoint_begin];
+                waypoint_node["elapsed_ms"] = frame.waypoint_elapsed_ms[waypoint_begin];
+            } else {
+                for (; pose_begin < frame.waypoint_pose_ends[waypoint_begin]; pose_begin++) {
+                    waypoint_node.push_back(convert_pos_to_yaml(frame.waypoint_poses[pose_begin]));
+                }
+            }
+            waypoints_node.push_back(std::move(waypoint_node));
+        }
+        veh_node["waypoints"] = std::move(waypoints_node);
+        node["vehicles"].push_back(std::move(veh_node));
+    }
+
+    // For each of the trips, we write the relavant data in yaml format.
+    for (const auto &trip : frame.trips) {
+        YAML::Node trip_node;
+        trip_node["id"] = trip.id;
+        trip_node["origin"] = convert_pos_to_yaml(trip.origin);
+        trip_node["destination"] = convert_pos_to_yaml(trip.destination);
+        trip_node["status"] = to_string(trip.status);
+        trip_node["request_time_ms"] = trip.request_time_ms;
+        trip_node["max_pickup_time_ms"] = trip.max_pickup_time_ms;
+        trip_node["pickup_time_ms"] = trip.pickup_time_ms;
+        trip_node["dropoff_time_ms"] = trip.dropoff_time_ms;
+
+        node["trips"].push_back(std::move(trip_node));
+    }
+
+    out << node << std::endl << "---\n";
+}
+
+DatalogWriter::DatalogWriter(const std::string &_path_to_datalog,
+                             bool _binary,
+                             DatalogCompression _compression,
+                             int _compression_level) {
+    if (_binary) {
+        assert(_compression == DatalogCompression::NONE &&
+               "[ERROR] The binary datalog can not be compressed!");
+        binary_datalog_writer_ = std::make_unique<BinaryDatalogWriter>(_path_to_datalog);
+    } else {
+        if (_compression == DatalogCompression::GZIP) {
+            datalog_ostream_.push(boost::iostreams::gzip_compressor{
+                _compression_level == 0 ? boost::iostreams::gzip::default_compression
+                                        : _compression_level});
+        } else if (_compression == DatalogCompression::ZSTD) {
+#ifdef MODABM_WITH_ZSTD
+            datalog_ostream_.push(boost::iostreams::zstd_compressor{
+                _compression_level == 0 ? boost::iostreams::zstd::default_compression
+                                        : static_cast<uint32_t>(_compression_level)});
+#else
+            assert(false && "[ERROR] The datalog can not be compressed with zstd in this build!");
+#endif
+        }
+
+        boost::iostreams::file_sink file_sink{_path_to_datalog, std::ios::out | std::ios::binary};
+        assert(file_sink.is_open() && "[ERROR] Failed to create the datalog file!");
+        datalog_ostream_.push(file_sink);
+    }
+
+    writer_thread_ = std::thread{&DatalogWriter::run, this};
+}
+
+DatalogWriter::~DatalogWriter() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    condition_variable_.notify_all();
+
+    writer_thread_.join();
+
+    // Flushing the compressor writes the end of the compressed stream.
+    datalog_ostream_.reset();
+}
+
+void DatalogWriter::submit_back_frame() {
+    // Wait until the writer is done with the previous frame, which bounds the frames in flight.
+    std::unique_lock<std::mutex> lock{mutex_};
+    condition_variable_.wait(lock, [this] { return !front_frame_pending_; });
+
+    // Swapping the buffers keeps the memory of both frames for reuse.
+    std::swap(back_frame_, front_frame_);
+    front_frame_pending_ = true;
+
+    lock.unlock();
+    condition_variable_.notify_all();
+}
+
+size_t DatalogWriter::get_buffer_bytes() const {
+    return get_heap_bytes(back_frame_) + writer_buffer_bytes_.load(std::memory_order_relaxed);
+}
+
+void DatalogWriter::run() {
+    while (true) {
+        std::unique_lock<std::mutex> lock{mutex_};
+        condition_variable_.wait(lock, [this] { return front_frame_pending_ || stopping_; });
+
+        if (!front_frame_pending_) {
+            return;
+        }
+
+        // The front buffer is not touched by the simulation thread until it is released.
+        lock.unlock();
+        {
+            TraceSpan span{"write_datalog_frame"};
+
+            if (binary_datalog_writer_) {
+                binary_datalog_writer_->write_frame(front_frame_);
+            } else {
+                write_datalog_frame(datalog_ostream_, front_frame_);
+            }
+        }
+        writer_buffer_bytes_.store(
+            get_heap_bytes(front_frame_) +
+                (binary_datalog_writer_ ? binary_datalog_writer_->get_buffer_bytes() : 0),
+            std::memory_order_relaxed);
+
+        lock.lock();
+        front_frame_pending_ = false;
+        lock.unlock();
+        condition_variable_.notify_all();
+    }
+}
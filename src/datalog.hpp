@@ -0,0 +1,168 @@
+/// \author Jian Wen
+/// \date 2021/02/23
+
+#pragma once
+
+#include "config.hpp"
+#include "types.hpp"
+
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// \brief The snapshot of the simulation state to be written as one frame of the datalog.
+/// \details The waypoint polylines of all vehicles are flattened into a single array of poses, so
+/// that capturing a frame only copies plain data and reuses the memory of the previous frames.
+///
+/// If delta encoded, the waypoints refer to the routes by id instead of holding the polylines. The
+/// geometry of each route is only included in the frame where the route first appears, and only
+/// the trips created or changed since the previous frame are included.
+struct DatalogFrame {
+    uint64_t system_time_ms = 0;
+    bool delta_encoded = false;                  // true if the frame is delta encoded
+    std::vector<Pos> vehicle_poses = {};         // the pos of each vehicle
+    std::vector<size_t> vehicle_loads = {};      // the load of each vehicle
+    std::vector<size_t> waypoint_ends = {};      // the end of the waypoints of each vehicle
+    std::vector<size_t> waypoint_pose_ends = {}; // the end of the poses of each waypoint
+    std::vector<Pos> waypoint_poses = {};        // the remaining polylines of all waypoints
+    std::vector<Trip> trips = {};                // all trips, or the changed trips if delta encoded
+
+    // The following are only used if delta encoded.
+    std::vector<size_t> waypoint_route_ids = {};         // the route id of each waypoint
+    std::vector<size_t> waypoint_cursors = {};           // the route cursor of each waypoint
+    std::vector<int32_t> waypoint_elapsed_ms = {};       // the time elapsed along each route
+    std::vector<size_t> new_route_ids = {};              // the ids of the routes that first appear
+    std::vector<size_t> new_route_pose_ends = {};        // the end of the poses of each new route
+    std::vector<Pos> new_route_poses = {};               // the polylines of all new routes
+    std::vector<int32_t> new_route_time_offsets_ms = {}; // the time offsets of the poses above
+};
+
+/// \brief Get the bytes allocated by the frame, including the reserved capacity.
+size_t get_heap_bytes(const DatalogFrame &frame);
+
+/// \brief Capture the snapshot of the vehicles and the trips into the frame.
+/// \details Only the remaining part of each waypoint's polyline is captured, starting from the
+/// current pos along the route.
+void capture_datalog_frame(DatalogFrame &frame,
+                           uint64_t system_time_ms,
+                           const std::vector<Vehicle> &vehicles,
+                           const std::vector<Trip> &trips);
+
+/// \brief The delta encoder that captures frames relative to the previous ones.
+/// \details The encoder remembers the routes currently planned for each vehicle. A route is
+/// identified by its geometry, so a route that is still planned in the next frame keeps its id,
+/// while a route replanned by dispatch gets a new one. The encoder is owned by the simulation
+/// thread, and the frames must be written in the order they are captured.
+class DatalogDeltaEncoder {
+  public:
+    /// \brief Capture the delta of the vehicles and the trips since the previous frame.
+    void capture(DatalogFrame &frame,
+                 uint64_t system_time_ms,
+                 const std::vector<Vehicle> &vehicles,
+                 const std::vector<Trip> &trips);
+
+    /// \brief Get the bytes allocated by the routes and the trip statuses remembered.
+    size_t get_buffer_bytes() const;
+
+  private:
+    /// \brief A route planned for a vehicle, with its id and geometry.
+    struct PlannedRoute {
+        size_t id = 0;
+        std::vector<Pos> poses = {};
+        std::vector<int32_t> time_offsets_ms = {};
+    };
+
+    /// \brief The routes planned for each vehicle as of the previous frame.
+    std::vector<std::vector<PlannedRoute>> planned_routes_ = {};
+
+    /// \brief The id of the next new route.
+    size_t next_route_id_ = 0;
+
+    /// \brief The status of each trip as of the previous frame.
+    std::vector<TripStatus> trip_statuses_ = {};
+};
+
+/// \brief Write the frame into the stream in yaml format, as one document of the datalog.
+void write_datalog_frame(std::ostream &out, const DatalogFrame &frame);
+
+class BinaryDatalogWriter;
+
+/// \brief The datalog writer that serializes and writes frames on a dedicated thread.
+/// \details The frames are double buffered. The simulation thread captures the next frame into the
+/// back buffer while the writer thread writes the front buffer. Submitting a frame swaps the two
+/// buffers, and blocks until the writer is done with the previous frame, so that at most one frame
+/// is pending at any time. The output is identical to writing the frames synchronously. The yaml
+/// datalog can be compressed, which also runs on the writer thread.
+class DatalogWriter {
+  public:
+    /// \brief Constructor that opens the datalog file and starts the writer thread.
+    /// \param _path_to_datalog The path to the datalog file.
+    /// \param _binary True if the datalog is written in the binary columnar format instead of yaml.
+    /// \param _compression The compression of the yaml datalog.
+    /// \param _compression_level The compression level, 0 for the default of the compression.
+    explicit DatalogWriter(const std::string &_path_to_datalog,
+                           bool _binary = false,
+                           DatalogCompression _compression = DatalogCompression::NONE,
+                           int _compression_level = 0);
+
+    /// \brief Destructor that writes the pending frame and stops the writer thread.
+    ~DatalogWriter();
+
+    DatalogWriter(const DatalogWriter &) = delete;
+    DatalogWriter &operator=(const DatalogWriter &) = delete;
+
+    /// \brief Get the back buffer, to be captured by the simulation thread.
+    DatalogFrame &get_back_frame() { return back_frame_; }
+
+    /// \brief Submit the back buffer to be written, after the previous frame has been written.
+    void submit_back_frame();
+
+    /// \brief Get the bytes allocated by both frame buffers and the binary writer, as of the last
+    /// frame written. Called by the simulation thread.
+    size_t get_buffer_bytes() const;
+
+  private:
+    /// \brief The loop of the writer thread.
+    void run();
+
+    /// \brief The stream that outputs to the yaml datalog through the compressor if any, only
+    /// accessed by the writer thread.
+    boost::iostreams::filtering_ostream datalog_ostream_;
+
+    /// \brief The writer of the binary datalog if binary, only accessed by the writer thread.
+    std::unique_ptr<BinaryDatalogWriter> binary_datalog_writer_;
+
+    /// \brief The frame being captured by the simulation thread.
+    DatalogFrame back_frame_;
+
+    /// \brief The frame being written by the writer thread.
+    DatalogFrame front_frame_;
+
+    /// \brief The mutex guarding the flags below.
+    std::mutex mutex_;
+
+    /// \brief The condition variable to notify the changes of the flags below.
+    std::condition_variable condition_variable_;
+
+    /// \brief True if the front buffer holds a frame that is not yet written.
+    bool front_frame_pending_ = false;
+
+    /// \brief True if the writer thread should stop once the pending frame is written.
+    bool stopping_ = false;
+
+    /// \brief The bytes allocated by the front buffer and the binary writer, updated by the writer
+    /// thread after each frame.
+    std::atomic<size_t> writer_buffer_bytes_{0};
+
+    /// \brief The writer thread, started after all other members are initialized.
+    std::thread writer_thread_;
+};
@@ -2,44 +2,220 @@
 /// \date 2021/02/01
 
 #include "demand_generator.hpp"
+#include "serialization.hpp"
 
 #include <cstdint>
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <thread>
 
-DemandGenerator::DemandGenerator(std::string _path_to_demand_data) {
-    auto demand_yaml = YAML::LoadFile(_path_to_demand_data);
+namespace {
 
-    // Compute the total number of trips per hour.
-    for (const auto &od_yaml : demand_yaml) {
-        trips_per_hour_ += od_yaml["trips_per_hour"].as<double>();
+/// \brief Precompute the alias table and the total trip intensity of each period.
+void build_periods(const std::vector<std::vector<double>> &trips_per_hour_by_period,
+                   DemandModel &demand_model) {
+    assert(demand_model.period_ms > 0 && demand_model.period_ms % kDemandEpochMs == 0 &&
+           "The period length in DemandGenerator must be a multiple of the epoch length!");
+    assert(!trips_per_hour_by_period.empty() &&
+           "DemandGenerator must have the trip intensities of at least one period!");
+
+    demand_model.alias_tables.clear();
+    demand_model.trips_per_hour_by_period.clear();
+
+    for (const auto &trips_per_hour : trips_per_hour_by_period) {
+        assert(trips_per_hour.size() == demand_model.ods.size() &&
+               "Each OD in DemandGenerator must have its trips per hour in each period!");
+
+        const auto total_trips_per_hour =
+            std::accumulate(trips_per_hour.begin(), trips_per_hour.end(), 0.0);
+
+        // A period without trips keeps an empty alias table and generates no requests.
+        demand_model.alias_tables.emplace_back(total_trips_per_hour > 0.0
+                                                   ? build_alias_table(trips_per_hour)
+                                                   : std::vector<AliasEntry>{});
+        demand_model.trips_per_hour_by_period.emplace_back(total_trips_per_hour);
     }
+}
+
+/// \brief Load the ODs and their trip intensities from the demand config file.
+void load_demand_config(const std::string &path_to_demand_config, DemandModel &demand_model) {
+    auto demand_yaml = YAML::LoadFile(path_to_demand_config);
+
+    // The demand config is either a list of ODs with constant trip intensities, or a map with the
+    // ODs under "ods" and optionally the period length and a global time-of-day profile.
+    const auto ods_yaml = demand_yaml.IsMap() ? demand_yaml["ods"] : demand_yaml;
+    std::vector<double> profile;
+
+    if (demand_yaml.IsMap()) {
+        if (demand_yaml["period_minutes"]) {
+            demand_model.period_ms = demand_yaml["period_minutes"].as<uint64_t>() * 60 * 1000;
+        }
+        if (demand_yaml["profile"]) {
+            profile = demand_yaml["profile"].as<std::vector<double>>();
+        }
+    }
+
+    // Load the ODs and their trip intensities in one pass. The trips per hour of each OD is either
+    // a constant or a list with one value per period.
+    std::vector<std::vector<double>> trips_per_hour_by_od;
+    auto num_periods = std::max<size_t>(1, profile.size());
+
+    for (const auto &od_yaml : ods_yaml) {
+        // Look up each key once, since each lookup is a linear search over the map.
+        const auto origin_yaml = od_yaml["origin"];
+        const auto destination_yaml = od_yaml["destination"];
+        const auto trips_per_hour_yaml = od_yaml["trips_per_hour"];
 
-    // Generate the ODs with probabilities.
-    auto accumucated_trips = 0.0;
+        Od od;
 
-    for (const auto &od_yaml : demand_yaml) {
-        OdWithProb od;
+        od.origin.lon = origin_yaml["lon"].as<double>();
+        od.origin.lat = origin_yaml["lat"].as<double>();
+        od.destination.lon = destination_yaml["lon"].as<double>();
+        od.destination.lat = destination_yaml["lat"].as<double>();
 
-        od.origin.lon = od_yaml["origin"]["lon"].as<double>();
-        od.origin.lat = od_yaml["origin"]["lat"].as<double>();
-        od.destination.lon = od_yaml["destination"]["lon"].as<double>();
-        od.destination.lat = od_yaml["destination"]["lat"].as<double>();
+        demand_model.ods.emplace_back(std::move(od));
 
-        accumucated_trips += od_yaml["trips_per_hour"].as<double>();
-        od.accumulated_prob = accumucated_trips / trips_per_hour_;
+        if (trips_per_hour_yaml.IsSequence()) {
+            trips_per_hour_by_od.emplace_back(trips_per_hour_yaml.as<std::vector<double>>());
+            num_periods = std::max(num_periods, trips_per_hour_by_od.back().size());
+        } else {
+            trips_per_hour_by_od.push_back({trips_per_hour_yaml.as<double>()});
+        }
+    }
+
+    // Combine the OD profiles with the global profile into the trip intensities of each period.
+    assert((profile.empty() || profile.size() == num_periods) &&
+           "The global profile must have one value per period, as many as the trips per hour!");
+    std::vector<std::vector<double>> trips_per_hour_by_period(
+        num_periods, std::vector<double>(demand_model.ods.size()));
+
+    for (auto i = 0; i < demand_model.ods.size(); i++) {
+        const auto &trips_per_hour = trips_per_hour_by_od[i];
+        assert((trips_per_hour.size() == 1 || trips_per_hour.size() == num_periods) &&
+               "The trips per hour of each OD must be a constant or have one value per period!");
 
-        ods_.emplace_back(std::move(od));
+        for (auto period = 0; period < num_periods; period++) {
+            trips_per_hour_by_period[period][i] =
+                (trips_per_hour.size() == 1 ? trips_per_hour[0] : trips_per_hour[period]) *
+                (profile.empty() ? 1.0 : profile[period]);
+        }
     }
 
+    build_periods(trips_per_hour_by_period, demand_model);
+}
+
+/// \brief Load the ODs, the trip intensities and the alias tables from the compiled demand file.
+void load_compiled_demand(const std::string &path_to_compiled_demand, DemandModel &demand_model) {
+    std::ifstream in{path_to_compiled_demand, std::ios::binary};
+    assert(in && "[ERROR] Failed to open the compiled demand file in DemandGenerator!");
+
+    CompiledDemandHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    assert(std::memcmp(header.magic, kCompiledDemandMagic, sizeof(kCompiledDemandMagic)) == 0 &&
+           "[ERROR] The file is not a compiled demand file in DemandGenerator!");
+    assert(header.version == kCompiledDemandVersion &&
+           "[ERROR] The compiled demand file has an unsupported version in DemandGenerator!");
+
+    demand_model.period_ms = header.period_ms;
+
+    // The sections are laid out exactly as in memory, so they are read in bulk with no parsing.
+    demand_model.trips_per_hour_by_period.resize(header.num_periods);
+    in.read(reinterpret_cast<char *>(demand_model.trips_per_hour_by_period.data()),
+            header.num_periods * sizeof(double));
+
+    demand_model.ods.resize(header.num_ods);
+    in.read(reinterpret_cast<char *>(demand_model.ods.data()), header.num_ods * sizeof(Od));
+
+    demand_model.alias_tables.resize(header.num_periods);
+    for (auto period = 0; period < header.num_periods; period++) {
+        if (demand_model.trips_per_hour_by_period[period] > 0.0) {
+            demand_model.alias_tables[period].resize(header.num_ods);
+            in.read(reinterpret_cast<char *>(demand_model.alias_tables[period].data()),
+                    header.num_ods * sizeof(AliasEntry));
+        }
+    }
+
+    assert(in && "[ERROR] The compiled demand file is truncated in DemandGenerator!");
+}
+
+} // namespace
+
+DemandGenerator::DemandGenerator(std::string _path_to_demand_data,
+                                 uint64_t _seed,
+                                 uint32_t _replication,
+                                 size_t _num_threads)
+    : seed_(_seed), replication_(_replication), num_threads_(std::max<size_t>(1, _num_threads)) {
+    auto demand_model = std::make_shared<DemandModel>();
+
+    // Load the compiled demand directly if given, which skips parsing and building alias tables.
+    const std::string compiled_demand_extension = ".demand";
+
+    if (_path_to_demand_data.size() > compiled_demand_extension.size() &&
+        _path_to_demand_data.compare(_path_to_demand_data.size() -
+                                         compiled_demand_extension.size(),
+                                     compiled_demand_extension.size(),
+                                     compiled_demand_extension) == 0) {
+        load_compiled_demand(_path_to_demand_data, *demand_model);
+    } else {
+        load_demand_config(_path_to_demand_data, *demand_model);
+    }
+
+    demand_model_ = std::move(demand_model);
+
     fmt::print("[INFO] Loaded demand config from {}. Generated demand matrix with {} OD pairs and "
-               "{} total trips per hour.\n",
+               "{} total trips per hour on average over {} period(s) of {} minutes.\n",
                _path_to_demand_data,
-               ods_.size(),
-               trips_per_hour_);
+               demand_model_->ods.size(),
+               std::accumulate(demand_model_->trips_per_hour_by_period.begin(),
+                               demand_model_->trips_per_hour_by_period.end(),
+                               0.0) /
+                   demand_model_->trips_per_hour_by_period.size(),
+               demand_model_->trips_per_hour_by_period.size(),
+               demand_model_->period_ms / 60 / 1000);
 }
 
+DemandGenerator::DemandGenerator(std::vector<Od> _ods,
+                                 const std::vector<double> &_trips_per_hour,
+                                 uint64_t _seed,
+                                 uint32_t _replication,
+                                 size_t _num_threads)
+    : DemandGenerator(std::move(_ods),
+                      std::vector<std::vector<double>>{_trips_per_hour},
+                      kDemandEpochMs,
+                      _seed,
+                      _replication,
+                      _num_threads) {}
+
+DemandGenerator::DemandGenerator(std::vector<Od> _ods,
+                                 const std::vector<std::vector<double>> &_trips_per_hour_by_period,
+                                 uint64_t _period_ms,
+                                 uint64_t _seed,
+                                 uint32_t _replication,
+                                 size_t _num_threads)
+    : seed_(_seed), replication_(_replication), num_threads_(std::max<size_t>(1, _num_threads)) {
+    auto demand_model = std::make_shared<DemandModel>();
+    demand_model->ods = std::move(_ods);
+    demand_model->period_ms = _period_ms;
+    build_periods(_trips_per_hour_by_period, *demand_model);
+
+    demand_model_ = std::move(demand_model);
+}
+
+DemandGenerator::DemandGenerator(std::shared_ptr<const DemandModel> _demand_model,
+                                 uint64_t _seed,
+                                 uint32_t _replication,
+                                 size_t _num_threads)
+    : seed_(_seed), replication_(_replication), num_threads_(std::max<size_t>(1, _num_threads)),
+      demand_model_(std::move(_demand_model)) {}
+
 std::vector<Request> DemandGenerator::operator()(uint64_t target_system_time_ms) {
     assert(system_time_ms_ <= target_system_time_ms &&
            "[ERROR] The target_system_time should be no less than the current system time in "
@@ -48,43 +224,240 @@ std::vector<Request> DemandGenerator::operator()(uint64_t target_system_time_ms)
     // System time moves to the target.
     system_time_ms_ = target_system_time_ms;
 
-    std::vector<Request> requests = {};
+    // Generate all epochs up to the one containing the target time. We generate at least one epoch
+    // per thread at a time to keep all threads busy.
+    const auto target_epoch = system_time_ms_ / kDemandEpochMs;
+    if (next_epoch_ <= target_epoch) {
+        generate_epochs(next_epoch_, std::max(target_epoch + 1, next_epoch_ + num_threads_));
+    }
+
+    // Hand out the requests until the target time.
+    const auto it = std::upper_bound(pending_requests_.begin(),
+                                     pending_requests_.end(),
+                                     system_time_ms_,
+                                     [](uint64_t time_ms, const Request &request) {
+                                         return time_ms < request.request_time_ms;
+                                     });
+
+    std::vector<Request> requests(pending_requests_.begin(), it);
+    pending_requests_.erase(pending_requests_.begin(), it);
+
+    return requests;
+}
+
+void DemandGenerator::write_compiled_demand(const std::string &path_to_compiled_demand) const {
+    std::ofstream out{path_to_compiled_demand, std::ios::binary};
+    assert(out && "[ERROR] Failed to create the compiled demand file!");
+
+    const auto &demand_model = *demand_model_;
+
+    CompiledDemandHeader header;
+    std::memcpy(header.magic, kCompiledDemandMagic, sizeof(kCompiledDemandMagic));
+    header.num_periods = demand_model.trips_per_hour_by_period.size();
+    header.num_ods = demand_model.ods.size();
+    header.period_ms = demand_model.period_ms;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
 
-    // Get the last request time. 0 indicates the initial state with no request generated yet.
-    if (last_request_.request_time_ms > 0) {
-        if (last_request_.request_time_ms > system_time_ms_) {
-            return requests;
+    out.write(reinterpret_cast<const char *>(demand_model.trips_per_hour_by_period.data()),
+              demand_model.trips_per_hour_by_period.size() * sizeof(double));
+    out.write(reinterpret_cast<const char *>(demand_model.ods.data()),
+              demand_model.ods.size() * sizeof(Od));
+
+    // The alias tables of the periods without trips are empty and not written.
+    for (const auto &alias_table : demand_model.alias_tables) {
+        out.write(reinterpret_cast<const char *>(alias_table.data()),
+                  alias_table.size() * sizeof(AliasEntry));
+    }
+}
+
+void DemandGenerator::save_state(std::ostream &out) const {
+    write_binary(out, seed_);
+    write_binary(out, replication_);
+    write_binary(out, demand_model_->ods.size());
+    write_binary(out, system_time_ms_);
+    write_binary(out, next_epoch_);
+    write_binary(out, pending_requests_);
+}
+
+void DemandGenerator::load_state(std::istream &in) {
+    size_t num_ods = 0;
+
+    read_binary(in, seed_);
+    read_binary(in, replication_);
+    read_binary(in, num_ods);
+    read_binary(in, system_time_ms_);
+    read_binary(in, next_epoch_);
+    read_binary(in, pending_requests_);
+
+    assert(num_ods == demand_model_->ods.size() &&
+           "[ERROR] The saved state does not match the demand model in DemandGenerator!");
+}
+
+void DemandGenerator::generate_epochs(uint64_t first_epoch, uint64_t last_epoch) {
+    const auto num_epochs = last_epoch - first_epoch;
+    std::vector<std::vector<Request>> requests_by_epoch(num_epochs);
+
+    // Each thread takes every num_threads-th epoch. Since each epoch has its own random stream,
+    // the assignment of epochs to threads does not affect the results.
+    const auto num_threads = std::min<size_t>(num_threads_, num_epochs);
+    auto generate = [&](size_t thread_index) {
+        for (auto i = thread_index; i < num_epochs; i += num_threads) {
+            requests_by_epoch[i] = generate_requests_in_epoch(first_epoch + i);
+        }
+    };
+
+    if (num_threads <= 1) {
+        generate(0);
+    } else {
+        std::vector<std::thread> threads;
+        for (auto thread_index = 0; thread_index < num_threads; thread_index++) {
+            threads.emplace_back(generate, thread_index);
         }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
 
-        requests.emplace_back(last_request_);
+    for (const auto &requests : requests_by_epoch) {
+        pending_requests_.insert(pending_requests_.end(), requests.begin(), requests.end());
     }
 
-    // Generate new requests until we go beyond the target time.
+    next_epoch_ = last_epoch;
+}
+
+std::vector<Request> DemandGenerator::generate_requests_in_epoch(uint64_t epoch) const {
+    RandomStream random_stream{seed_, make_stream_id(replication_, epoch)};
+
+    // Each request takes three uniform variates, drawn from the stream in batches.
+    constexpr size_t kBatchSize = 3 * 256;
+    std::array<double, kBatchSize> uniforms;
+    auto num_used = kBatchSize;
+
+    std::vector<Request> requests;
+
+    // The epoch lies within a single period, where the trip intensity is constant.
+    const auto &demand_model = *demand_model_;
+    const auto period =
+        epoch * kDemandEpochMs / demand_model.period_ms % demand_model.alias_tables.size();
+    const auto &alias_table = demand_model.alias_tables[period];
+    const auto trips_per_hour = demand_model.trips_per_hour_by_period[period];
+
+    if (alias_table.empty()) {
+        return requests;
+    }
+
+    const auto epoch_end_time_ms = static_cast<double>((epoch + 1) * kDemandEpochMs);
+    const auto num_entries = alias_table.size();
+    auto time_ms = static_cast<double>(epoch * kDemandEpochMs);
+
     while (true) {
-        last_request_ = generate_request(last_request_.request_time_ms);
+        if (num_used == kBatchSize) {
+            random_stream.fill_uniform(uniforms.data(), kBatchSize);
+            num_used = 0;
+        }
+
+        const auto u_interval = uniforms[num_used++];
+        const auto u_index = uniforms[num_used++];
+        const auto u_coin = uniforms[num_used++];
 
-        if (last_request_.request_time_ms > system_time_ms_) {
+        // Calculate the interarrival time that follows the Poisson process.
+        time_ms += -std::log(1 - u_interval) / trips_per_hour * 3600000;
+
+        if (time_ms >= epoch_end_time_ms) {
             break;
         }
 
-        requests.emplace_back(last_request_);
+        // Pick an entry of the alias table uniformly, then flip the biased coin of that entry.
+        const auto index = std::min<size_t>(u_index * num_entries, num_entries - 1);
+        const auto &entry = alias_table[index];
+        const auto &od =
+            u_coin < entry.prob ? demand_model.ods[index] : demand_model.ods[entry.alias];
+
+        requests.push_back({od.origin, od.destination, static_cast<uint64_t>(time_ms)});
     }
 
     return requests;
 }
 
-Request DemandGenerator::generate_request(uint64_t last_request_time_ms) {
-    // Generate a random number in [0, 1)
-    auto rn = rand() / static_cast<double>(RAND_MAX);
+std::vector<AliasEntry> build_alias_table(const std::vector<double> &weights) {
+    const auto n = weights.size();
+    const auto total_weight = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    assert(n > 0 && total_weight > 0 && "The alias table must have positive total weight!");
+
+    // Scale the probabilities so that they average to 1, and split them into two worklists.
+    std::vector<double> scaled_probs(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+
+    for (auto i = 0; i < n; i++) {
+        scaled_probs[i] = weights[i] * n / total_weight;
+        (scaled_probs[i] < 1.0 ? small : large).emplace_back(i);
+    }
+
+    // Pair each small entry with a large one, which donates the rest of the small entry's slot.
+    std::vector<AliasEntry> alias_table(n);
 
-    // Based on the accumulated probabilities of each OD, find the corresponding trip.
-    auto od_it = std::lower_bound(ods_.begin(), ods_.end(), rn, [](OdWithProb od, double val) {
-        return od.accumulated_prob < val;
-    });
+    while (!small.empty() && !large.empty()) {
+        const auto s = small.back();
+        const auto l = large.back();
+        small.pop_back();
 
-    // Calculate thg interarrival time that follows the Poisson process
-    uint64_t interval_ms =
-        -log(1 - rand() / static_cast<double>(RAND_MAX)) / trips_per_hour_ * 3600000;
+        alias_table[s].prob = scaled_probs[s];
+        alias_table[s].alias = l;
+
+        scaled_probs[l] -= 1.0 - scaled_probs[s];
+        if (scaled_probs[l] < 1.0) {
+            large.pop_back();
+            small.emplace_back(l);
+        }
+    }
+
+    // What remains are (up to numerical errors) entries with probability 1.
+    for (auto i : small) {
+        alias_table[i] = {1.0, i};
+    }
+    for (auto i : large) {
+        alias_table[i] = {1.0, i};
+    }
+
+    return alias_table;
+}
+
+bool parse_demand_csv_line(const std::string &line, Od &od, std::vector<double> &trips_per_hour) {
+    trips_per_hour.clear();
+
+    const char *ptr = line.c_str();
+    char *end = nullptr;
+
+    // Parse the next field, which must be a number, and follows a comma unless it is the first.
+    double value = 0.0;
+    auto parse_field = [&](bool first) {
+        if (!first) {
+            if (*end != ',') {
+                return false;
+            }
+            ptr = end + 1;
+        }
+        value = std::strtod(ptr, &end);
+        return end != ptr;
+    };
+
+    for (auto coordinate :
+         {&od.origin.lon, &od.origin.lat, &od.destination.lon, &od.destination.lat}) {
+        if (!parse_field(coordinate == &od.origin.lon)) {
+            return false;
+        }
+        *coordinate = value;
+    }
+
+    // The trip intensities of all periods take the rest of the line.
+    while (*end == ',') {
+        if (!parse_field(false)) {
+            return false;
+        }
+        trips_per_hour.emplace_back(value);
+    }
 
-    return {od_it->origin, od_it->destination, last_request_time_ms + interval_ms};
+    return !trips_per_hour.empty() && (*end == '\0' || (*end == '\r' && *(end + 1) == '\0'));
 }
@@ -3,36 +3,160 @@
 
 #pragma once
 
+#include "random.hpp"
 #include "types.hpp"
 
 #include <cstdint>
+#include <istream>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <vector>
+
+/// \brief The length of an epoch in milliseconds, see DemandGenerator for details.
+constexpr uint64_t kDemandEpochMs = 60000;
+
+/// \brief The magic number at the beginning of a compiled demand file.
+constexpr char kCompiledDemandMagic[8] = {'M', 'O', 'D', 'D', 'M', 'N', 'D', '\0'};
+
+/// \brief The version of the compiled demand file format.
+constexpr uint32_t kCompiledDemandVersion = 1;
+
+/// \brief The header of a compiled demand file. It is followed by the total trips per hour of each
+/// period (num_periods doubles), the ODs (num_ods Ods), and the alias table of each period with
+/// trips (num_ods AliasEntries each), all in their in-memory layout.
+struct CompiledDemandHeader {
+    char magic[8];
+    uint32_t version = kCompiledDemandVersion;
+    uint32_t num_periods = 0;
+    uint64_t num_ods = 0;
+    uint64_t period_ms = 0;
+};
+
+static_assert(sizeof(CompiledDemandHeader) == 32, "CompiledDemandHeader must be packed!");
+static_assert(sizeof(Od) == 16, "Od must be packed to be written to the compiled demand file!");
+
+/// \brief The demand data, i.e. the ODs and their trip intensities in each period with the
+/// precomputed alias tables. It is immutable once built, and shared by the DemandGenerators of
+/// different replications and variants.
+struct DemandModel {
+    /// \brief The demand ODs.
+    std::vector<Od> ods = {};
+
+    /// \brief The length of each period.
+    uint64_t period_ms = kDemandEpochMs;
+
+    /// \brief The alias table to sample ODs in each period, aligned with ods. It is empty if there
+    /// are no trips in the period.
+    /// \see the definition of AliasEntry for detailed explaination.
+    std::vector<std::vector<AliasEntry>> alias_tables = {};
+
+    /// \brief The total trip itensity in each period represented by average number of trips per
+    /// hour.
+    std::vector<double> trips_per_hour_by_period = {};
+};
 
 /// \brief Stateful functor that generates trips based on demand data.
+/// \details The timeline is split into epochs of kDemandEpochMs. Thanks to the memorylessness of
+/// the Poisson process, the requests of each epoch can be generated on their own, restarting the
+/// process at the beginning of the epoch. Each epoch draws from its own random stream keyed by
+/// (seed, replication, epoch), so that epochs are generated in parallel with results bit-identical
+/// for a given seed regardless of the number of threads.
+///
+/// The trip intensities may vary by time of day. The day is split into periods whose length is a
+/// multiple of kDemandEpochMs, each with its own total rate and alias table, so that the rate is
+/// constant within an epoch and the arrivals are generated exactly by piecewise-exponential
+/// inversion. The periods repeat after the last one, e.g. 24 one-hour periods cover every day.
 class DemandGenerator {
   public:
     /// \brief Constructor.
-    explicit DemandGenerator(std::string _path_to_demand_data);
+    /// \param _path_to_demand_data The path to the demand config file, or to the compiled demand
+    /// file (*.demand) written by write_compiled_demand.
+    /// \param _seed The seed of the random streams. The same seed reproduces the same requests.
+    /// \param _replication The index of the replication, which selects disjoint random streams.
+    /// \param _num_threads The number of threads generating epochs in parallel.
+    DemandGenerator(std::string _path_to_demand_data,
+                    uint64_t _seed,
+                    uint32_t _replication = 0,
+                    size_t _num_threads = 1);
+
+    /// \brief Constructor with ODs and their constant trip intensities given directly.
+    DemandGenerator(std::vector<Od> _ods,
+                    const std::vector<double> &_trips_per_hour,
+                    uint64_t _seed,
+                    uint32_t _replication = 0,
+                    size_t _num_threads = 1);
+
+    /// \brief Constructor with ODs and their time-varying trip intensities given directly.
+    /// \param _trips_per_hour_by_period The trip intensities of the ODs in each period.
+    /// \param _period_ms The length of each period, a multiple of kDemandEpochMs.
+    DemandGenerator(std::vector<Od> _ods,
+                    const std::vector<std::vector<double>> &_trips_per_hour_by_period,
+                    uint64_t _period_ms,
+                    uint64_t _seed,
+                    uint32_t _replication = 0,
+                    size_t _num_threads = 1);
+
+    /// \brief Constructor with the demand model shared with other DemandGenerators.
+    DemandGenerator(std::shared_ptr<const DemandModel> _demand_model,
+                    uint64_t _seed,
+                    uint32_t _replication = 0,
+                    size_t _num_threads = 1);
 
     /// \brief Main functor that generates the requests til the target system time.
     std::vector<Request> operator()(uint64_t target_system_time_ms);
 
+    /// \brief Write the ODs, the trip intensities and the precomputed alias tables into a compiled
+    /// demand file, which loads with no parsing.
+    void write_compiled_demand(const std::string &path_to_compiled_demand) const;
+
+    /// \brief Save the state of generation into the binary stream, to be restored by load_state.
+    /// \details Since each epoch has its own random stream, the state of the random numbers is
+    /// fully captured by the next epoch to generate.
+    void save_state(std::ostream &out) const;
+
+    /// \brief Restore the state of generation from the binary stream.
+    void load_state(std::istream &in);
+
+    /// \brief Get the demand model, which can be shared with other DemandGenerators.
+    std::shared_ptr<const DemandModel> get_demand_model() const { return demand_model_; }
+
   private:
-    /// \brief Generate a request following the Poisson process.
-    /// \see the definition of OdWithProb for detailed explaination.
-    Request generate_request(uint64_t last_request_time_ms);
+    /// \brief Generate the requests of the epochs in [first_epoch, last_epoch) into the buffer.
+    void generate_epochs(uint64_t first_epoch, uint64_t last_epoch);
 
-    /// \brief The last request the system has generated.
-    Request last_request_ = {};
+    /// \brief Generate the requests within one epoch following the Poisson process.
+    /// \see the definition of AliasEntry for detailed explaination of the OD sampling.
+    std::vector<Request> generate_requests_in_epoch(uint64_t epoch) const;
+
+    /// \brief The seed of the random streams.
+    uint64_t seed_ = 0;
+
+    /// \brief The index of the replication.
+    uint32_t replication_ = 0;
+
+    /// \brief The number of threads generating epochs in parallel.
+    size_t num_threads_ = 1;
 
     /// \brief The system time starting from 0.
     uint64_t system_time_ms_ = 0;
 
-    /// \brief The demand ODs and their accumulated probabilities.
-    /// \see the definition of OdWithProb for detailed explaination.
-    std::vector<OdWithProb> ods_ = {};
+    /// \brief The first epoch that has not been generated yet.
+    uint64_t next_epoch_ = 0;
 
-    /// \brief The total trip itensity represented by average number of trips per hour.
-    double trips_per_hour_ = 0.0;
+    /// \brief The requests generated ahead of the system time, in increasing order of time.
+    std::vector<Request> pending_requests_ = {};
+
+    /// \brief The demand model.
+    std::shared_ptr<const DemandModel> demand_model_;
 };
+
+/// \brief Build the alias table from the (unnormalized) weights of each item.
+/// \see the definition of AliasEntry for detailed explaination.
+std::vector<AliasEntry> build_alias_table(const std::vector<double> &weights);
+
+/// \brief Parse an OD from a line of the demand csv file, i.e. "origin_lon,origin_lat,
+/// destination_lon,destination_lat,trips_per_hour[,...]" with one trips_per_hour per period.
+/// \return False if any of the fields is missing or is not a number, or anything but the line
+/// ending follows the last field.
+bool parse_demand_csv_line(const std::string &line, Od &od, std::vector<double> &trips_per_hour);
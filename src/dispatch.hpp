@@ -3,19 +3,26 @@
 
 #pragma once
 
+#include "features.hpp"
+#include "fleet.hpp"
+#include "thread_pool.hpp"
 #include "types.hpp"
+#include "vehicle.hpp"
+#include "zone.hpp"
 #include <cstddef>
 
 /// \brief Assign the pending trips to the vehicles using Insertion Heuristics.
 /// \param pending_trip_ids A vector holding indices to the pending trips.
 /// \param trips A vector of all trips.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The hot states of the vehicles, used to rule out vehicles that are too far.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
 void assign_trips_through_insertion_heuristics(const std::vector<size_t> &pending_trip_ids,
                                                std::vector<Trip> &trips,
                                                std::vector<Vehicle> &vehicles,
+                                               const FleetState &fleet_state,
                                                uint64_t system_time_ms,
                                                RouterFunc &router_func);
 
@@ -23,22 +30,94 @@ void assign_trips_through_insertion_heuristics(const std::vector<size_t> &pendin
 /// \param trip The trip to be inserted.
 /// \param trips A vector of all trips.
 /// \param vehicles A vector of all vehicles.
+/// \param fleet_state The hot states of the vehicles, used to rule out vehicles that are too far.
 /// \param system_time_ms The current system time.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
 void assign_trip_through_insertion_heuristics(Trip &trip,
                                               const std::vector<Trip> &trips,
                                               std::vector<Vehicle> &vehicles,
+                                              const FleetState &fleet_state,
                                               uint64_t system_time_ms,
                                               RouterFunc &router_func);
 
+/// \brief Assign the pending trips to the vehicles using Insertion Heuristics, zone by zone.
+/// \details The area is partitioned into zones, and each vehicle belongs to the zone of its current
+/// pos. The pending trips requested in the interior of each zone are dispatched against the local
+/// vehicles of that zone, with the zones processed in parallel. The trips requested near a zone
+/// border, together with the trips no local vehicle could serve, are then dispatched against all
+/// vehicles in a serial reconciliation pass in increasing order of trip id. Since each zone only
+/// modifies its own trips and vehicles, the results do not depend on the number of threads.
+/// \param pending_trip_ids A vector holding indices to the pending trips.
+/// \param trips A vector of all trips.
+/// \param vehicles A vector of all vehicles.
+/// \param fleet_state The hot states of the vehicles, used to rule out vehicles that are too far.
+/// \param system_time_ms The current system time.
+/// \param zone_grid The grid of zones.
+/// \param zone_border_m The trips requested within this distance of a zone border are reconciled.
+/// \param thread_pool The threads dispatching the zones, reused across dispatches.
+/// \tparam router_func The router func that finds path between two poses, which must be safe to
+/// invoke concurrently if the thread pool has more than one thread.
+template <typename RouterFunc>
+void assign_trips_through_zoned_insertion_heuristics(const std::vector<size_t> &pending_trip_ids,
+                                                     std::vector<Trip> &trips,
+                                                     std::vector<Vehicle> &vehicles,
+                                                     const FleetState &fleet_state,
+                                                     uint64_t system_time_ms,
+                                                     RouterFunc &router_func,
+                                                     const ZoneGrid &zone_grid,
+                                                     double zone_border_m,
+                                                     ThreadPool &thread_pool);
+
+/// \brief Insert the trip into the candidate vehicle with least additional cost.
+/// \param trip The trip to be inserted.
+/// \param trips A vector of all trips.
+/// \param vehicles A vector of all vehicles.
+/// \param candidate_vehicle_ids The ids of the vehicles to try.
+/// \param system_time_ms The current system time.
+/// \tparam router_func The router func that finds path between two poses.
+/// \return True if the trip is inserted. False if none of the candidates could serve it, in which
+/// case the trip is left untouched.
+template <typename RouterFunc>
+bool insert_trip_to_best_candidate_vehicle(Trip &trip,
+                                           const std::vector<Trip> &trips,
+                                           std::vector<Vehicle> &vehicles,
+                                           const std::vector<size_t> &candidate_vehicle_ids,
+                                           uint64_t system_time_ms,
+                                           RouterFunc &router_func);
+
+/// \brief Assign the pending trips to the vehicles ranked by a batch scorer (e.g. an ML model).
+/// \details The features of all trip-vehicle pairs are extracted into the buffer at once and
+/// scored in a single call to the scorer, so that inference runs batched. Each trip is then
+/// inserted into the best-scored vehicle that could serve it, validated through the router. Vehicle
+/// states change as trips are inserted, while the scores are computed at the start of the cycle.
+/// \param pending_trip_ids A vector holding indices to the pending trips.
+/// \param trips A vector of all trips.
+/// \param vehicles A vector of all vehicles.
+/// \param system_time_ms The current system time.
+/// \param buffer The caller-provided feature buffer, holding at least #trips * #vehicles rows.
+/// \param scores The caller-provided score array, holding at least #trips * #vehicles floats.
+/// \param max_candidates_per_trip The max number of best-scored vehicles we try for each trip.
+/// \tparam router_func The router func that finds path between two poses.
+/// \tparam scorer_func The batch scorer func, see score_by_pickup_lower_bound for the signature.
+template <typename RouterFunc, typename ScorerFunc>
+void assign_trips_through_batch_scoring(const std::vector<size_t> &pending_trip_ids,
+                                        std::vector<Trip> &trips,
+                                        std::vector<Vehicle> &vehicles,
+                                        uint64_t system_time_ms,
+                                        RouterFunc &router_func,
+                                        ScorerFunc &scorer_func,
+                                        const FeatureBuffer &buffer,
+                                        float *scores,
+                                        size_t max_candidates_per_trip = 10);
+
 /// \brief Compute the cost (time in millisecond) of serving the current waypoints.
 /// \details The cost of serving all waypoints is defined as the total time taken to drop off each
 /// of the trips based on the current ordering.
-uint64_t get_cost_of_waypoints(const std::vector<Waypoint> &waypoints);
+uint64_t get_cost_of_waypoints(const std::deque<Waypoint> &waypoints);
 
 /// \brief Validate waypoints by checking all constraints. Returns true if valid.
-bool validate_waypoints(const std::vector<Waypoint> &waypoints,
+bool validate_waypoints(const std::deque<Waypoint> &waypoints,
                         const std::vector<Trip> &trips,
                         const Vehicle &vehicle,
                         uint64_t system_time_ms);
@@ -54,7 +133,7 @@ bool validate_waypoints(const std::vector<Waypoint> &waypoints,
 /// otherwise.
 template <typename RouterFunc>
 std::pair<bool, uint64_t> get_pickup_time(Pos pos,
-                                          const std::vector<Waypoint> &waypoints,
+                                          const std::deque<Waypoint> &waypoints,
                                           Pos pickup_pos,
                                           size_t pickup_index,
                                           uint64_t system_time_ms,
@@ -128,7 +207,7 @@ void insert_trip_to_vehicle(Trip &trip,
 /// \param routing_type The type of the route.
 /// \tparam router_func The router func that finds path between two poses.
 template <typename RouterFunc>
-std::vector<Waypoint> generate_waypoints(const Trip &trip,
+std::deque<Waypoint> generate_waypoints(const Trip &trip,
                                          const Vehicle &vehicle,
                                          size_t pickup_index,
                                          size_t dropoff_index,
@@ -4,24 +4,28 @@
 #pragma once
 
 #include "dispatch.hpp"
+#include "logger.hpp"
+#include "tracer.hpp"
 
-#include <fmt/format.h>
-
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <numeric>
 
 template <typename RouterFunc>
 void assign_trips_through_insertion_heuristics(const std::vector<size_t> &pending_trip_ids,
                                                std::vector<Trip> &trips,
                                                std::vector<Vehicle> &vehicles,
+                                               const FleetState &fleet_state,
                                                uint64_t system_time_ms,
                                                RouterFunc &router_func) {
-    fmt::print("[DEBUG] Assigning trips to vehicles through insertion heuristics.\n");
+    log_event<LogLevel::DEBUG>(LogEvent::INSERTION_STARTED);
 
     // For each trip, we assign it to the best vehicle.
     for (auto trip_id : pending_trip_ids) {
         auto &trip = trips[trip_id];
         assign_trip_through_insertion_heuristics(
-            trip, trips, vehicles, system_time_ms, router_func);
+            trip, trips, vehicles, fleet_state, system_time_ms, router_func);
     }
 
     return;
@@ -31,41 +35,234 @@ template <typename RouterFunc>
 void assign_trip_through_insertion_heuristics(Trip &trip,
                                               const std::vector<Trip> &trips,
                                               std::vector<Vehicle> &vehicles,
+                                              const FleetState &fleet_state,
                                               uint64_t system_time_ms,
                                               RouterFunc &router_func) {
+    // Rule out the vehicles that could never make it to the pickup in time. Inserting the trip
+    // does not move the vehicle, so the fleet state stays valid throughout the dispatch.
+    std::vector<size_t> candidate_vehicle_ids;
+    filter_vehicles_by_pickup_deadline(
+        fleet_state, trip.origin, system_time_ms, trip.max_pickup_time_ms, candidate_vehicle_ids);
+
+    // If none of the vehicles can serve the trip, return false.
+    if (!insert_trip_to_best_candidate_vehicle(
+            trip, trips, vehicles, candidate_vehicle_ids, system_time_ms, router_func)) {
+        trip.status = TripStatus::WALKAWAY;
+        log_event<LogLevel::DEBUG>(LogEvent::TRIP_UNASSIGNED, trip.id);
+    }
+
+    return;
+}
+
+template <typename RouterFunc>
+void assign_trips_through_zoned_insertion_heuristics(const std::vector<size_t> &pending_trip_ids,
+                                                     std::vector<Trip> &trips,
+                                                     std::vector<Vehicle> &vehicles,
+                                                     const FleetState &fleet_state,
+                                                     uint64_t system_time_ms,
+                                                     RouterFunc &router_func,
+                                                     const ZoneGrid &zone_grid,
+                                                     double zone_border_m,
+                                                     ThreadPool &thread_pool) {
+    log_event<LogLevel::DEBUG>(LogEvent::ZONED_INSERTION_STARTED);
+
+    const auto num_zones = zone_grid.num_cols * zone_grid.num_rows;
+
+    // Partition the vehicles by the zones of their current poses.
+    std::vector<size_t> vehicle_zone_indices(vehicles.size());
+    for (auto i = 0; i < vehicles.size(); i++) {
+        vehicle_zone_indices[i] =
+            get_zone_index(zone_grid, Pos{fleet_state.lon[i], fleet_state.lat[i]});
+    }
+
+    // Partition the pending trips by the zones of their origins. The trips near a zone border are
+    // reconciled later, since the vehicles in the neighboring zones are as likely to serve them.
+    std::vector<std::vector<size_t>> zone_trip_ids(num_zones);
+    std::vector<std::vector<size_t>> zone_unassigned_trip_ids(num_zones);
+    std::vector<size_t> reconciled_trip_ids;
+
+    for (auto trip_id : pending_trip_ids) {
+        const auto &origin = trips[trip_id].origin;
+
+        if (get_distance_to_zone_border_m(zone_grid, origin) < zone_border_m) {
+            reconciled_trip_ids.emplace_back(trip_id);
+        } else {
+            zone_trip_ids[get_zone_index(zone_grid, origin)].emplace_back(trip_id);
+        }
+    }
+
+    const auto num_border_trips = reconciled_trip_ids.size();
+
+    // Dispatch each zone against its local vehicles. The fleet state is only read, and each zone
+    // only modifies its own trips and vehicles, so the zones can be dispatched concurrently.
+    auto dispatch_zone = [&](size_t zone_index) {
+        TraceSpan span{"dispatch_zone"};
+        std::vector<size_t> candidate_vehicle_ids;
+
+        for (auto trip_id : zone_trip_ids[zone_index]) {
+            auto &trip = trips[trip_id];
+
+            filter_vehicles_by_pickup_deadline(fleet_state,
+                                               trip.origin,
+                                               system_time_ms,
+                                               trip.max_pickup_time_ms,
+                                               candidate_vehicle_ids);
+            candidate_vehicle_ids.erase(
+                std::remove_if(candidate_vehicle_ids.begin(),
+                               candidate_vehicle_ids.end(),
+                               [&](size_t id) { return vehicle_zone_indices[id] != zone_index; }),
+                candidate_vehicle_ids.end());
+
+            if (!insert_trip_to_best_candidate_vehicle(
+                    trip, trips, vehicles, candidate_vehicle_ids, system_time_ms, router_func)) {
+                zone_unassigned_trip_ids[zone_index].emplace_back(trip_id);
+            }
+        }
+    };
+
+    // Each thread keeps taking the next zone until all zones are done.
+    std::atomic<size_t> next_zone_index{0};
+    auto dispatch_zones = [&]() {
+        for (auto i = next_zone_index++; i < num_zones; i = next_zone_index++) {
+            dispatch_zone(i);
+        }
+    };
+
+    thread_pool.run(dispatch_zones);
+
+    // Reconcile the border trips and the trips that no local vehicle could serve against all
+    // vehicles, in a fixed order so that the results are deterministic.
+    for (const auto &trip_ids : zone_unassigned_trip_ids) {
+        reconciled_trip_ids.insert(reconciled_trip_ids.end(), trip_ids.begin(), trip_ids.end());
+    }
+    std::sort(reconciled_trip_ids.begin(), reconciled_trip_ids.end());
+
+    log_event<LogLevel::DEBUG>(LogEvent::ZONES_DISPATCHED,
+                               pending_trip_ids.size() - reconciled_trip_ids.size(),
+                               num_zones,
+                               num_border_trips,
+                               reconciled_trip_ids.size() - num_border_trips);
+
+    TraceSpan span{"reconcile_zones"};
+    for (auto trip_id : reconciled_trip_ids) {
+        assign_trip_through_insertion_heuristics(
+            trips[trip_id], trips, vehicles, fleet_state, system_time_ms, router_func);
+    }
+
+    return;
+}
+
+template <typename RouterFunc>
+bool insert_trip_to_best_candidate_vehicle(Trip &trip,
+                                           const std::vector<Trip> &trips,
+                                           std::vector<Vehicle> &vehicles,
+                                           const std::vector<size_t> &candidate_vehicle_ids,
+                                           uint64_t system_time_ms,
+                                           RouterFunc &router_func) {
     InsertionResult res;
 
-    // Iterate through all vehicles and find the one with least additional cost.
-    for (const auto &vehicle : vehicles) {
-        auto res_this_vehicle = compute_cost_of_inserting_trip_to_vehicle(
-            trip, trips, vehicle, system_time_ms, router_func);
+    // Iterate through the candidate vehicles and find the one with least additional cost.
+    {
+        TraceSpan span{"evaluation"};
 
-        if (res_this_vehicle.success && res_this_vehicle.cost_ms < res.cost_ms) {
-            res = std::move(res_this_vehicle);
+        for (auto vehicle_id : candidate_vehicle_ids) {
+            const auto &vehicle = vehicles[vehicle_id];
+            auto res_this_vehicle = compute_cost_of_inserting_trip_to_vehicle(
+                trip, trips, vehicle, system_time_ms, router_func);
+
+            if (res_this_vehicle.success && res_this_vehicle.cost_ms < res.cost_ms) {
+                res = std::move(res_this_vehicle);
+            }
         }
     }
 
-    // If none of the vehicles can serve the trip, return false.
     if (!res.success) {
-        trip.status = TripStatus::WALKAWAY;
-        fmt::print("[DEBUG] Failed to assign Trip #{}.\n", trip.id);
-
-        return;
+        return false;
     }
 
     // Insert the trip to the best vehicle.
     auto &best_vehicle = vehicles[res.vehicle_id];
     insert_trip_to_vehicle(trip, best_vehicle, res.pickup_index, res.dropoff_index, router_func);
 
-    fmt::print("[DEBUG] Assigned Trip #{} to Vehicle #{}, which has {} waypoints.\n",
-               trip.id,
-               best_vehicle.id,
-               best_vehicle.waypoints.size());
+    log_event<LogLevel::DEBUG>(
+        LogEvent::TRIP_ASSIGNED, trip.id, best_vehicle.id, best_vehicle.waypoints.size());
+
+    return true;
+}
+
+template <typename RouterFunc, typename ScorerFunc>
+void assign_trips_through_batch_scoring(const std::vector<size_t> &pending_trip_ids,
+                                        std::vector<Trip> &trips,
+                                        std::vector<Vehicle> &vehicles,
+                                        uint64_t system_time_ms,
+                                        RouterFunc &router_func,
+                                        ScorerFunc &scorer_func,
+                                        const FeatureBuffer &buffer,
+                                        float *scores,
+                                        size_t max_candidates_per_trip) {
+    log_event<LogLevel::DEBUG>(LogEvent::BATCH_SCORING_STARTED);
+
+    // Extract the features of all pairs and score them in one batch.
+    std::vector<size_t> vehicle_ids(vehicles.size());
+    std::iota(vehicle_ids.begin(), vehicle_ids.end(), 0);
+
+    const auto num_rows = extract_features(
+        pending_trip_ids, trips, vehicle_ids, vehicles, system_time_ms, buffer);
+    scorer_func(buffer, num_rows, scores);
+
+    // For each trip, we try the vehicles from the best score to the worst.
+    std::vector<size_t> ranked_vehicle_ids;
+    for (auto i = 0; i < pending_trip_ids.size(); i++) {
+        auto &trip = trips[pending_trip_ids[i]];
+        const auto trip_scores = scores + i * vehicles.size();
+
+        ranked_vehicle_ids.clear();
+        for (auto vehicle_id : vehicle_ids) {
+            if (std::isfinite(trip_scores[vehicle_id])) {
+                ranked_vehicle_ids.emplace_back(vehicle_id);
+            }
+        }
+
+        const auto num_candidates = std::min(max_candidates_per_trip, ranked_vehicle_ids.size());
+        std::partial_sort(ranked_vehicle_ids.begin(),
+                          ranked_vehicle_ids.begin() + num_candidates,
+                          ranked_vehicle_ids.end(),
+                          [&](size_t a, size_t b) {
+                              return trip_scores[a] < trip_scores[b] ||
+                                     (trip_scores[a] == trip_scores[b] && a < b);
+                          });
+
+        auto assigned = false;
+        for (auto k = 0; k < num_candidates; k++) {
+            auto &vehicle = vehicles[ranked_vehicle_ids[k]];
+            auto res = compute_cost_of_inserting_trip_to_vehicle(
+                trip, trips, vehicle, system_time_ms, router_func);
+
+            if (res.success) {
+                insert_trip_to_vehicle(
+                    trip, vehicle, res.pickup_index, res.dropoff_index, router_func);
+                assigned = true;
+
+                log_event<LogLevel::DEBUG>(LogEvent::TRIP_ASSIGNED_BY_SCORE,
+                                           trip.id,
+                                           vehicle.id,
+                                           k,
+                                           trip_scores[vehicle.id]);
+
+                break;
+            }
+        }
+
+        if (!assigned) {
+            trip.status = TripStatus::WALKAWAY;
+            log_event<LogLevel::DEBUG>(LogEvent::TRIP_UNASSIGNED, trip.id);
+        }
+    }
 
     return;
 }
 
-uint64_t get_cost_of_waypoints(const std::vector<Waypoint> &waypoints) {
+inline uint64_t get_cost_of_waypoints(const std::deque<Waypoint> &waypoints) {
     auto cost_ms = 0;
     auto accumulated_time_ms = 0;
 
@@ -80,10 +277,10 @@ uint64_t get_cost_of_waypoints(const std::vector<Waypoint> &waypoints) {
     return cost_ms;
 }
 
-bool validate_waypoints(const std::vector<Waypoint> &waypoints,
-                        const std::vector<Trip> &trips,
-                        const Vehicle &vehicle,
-                        uint64_t system_time_ms) {
+inline bool validate_waypoints(const std::deque<Waypoint> &waypoints,
+                               const std::vector<Trip> &trips,
+                               const Vehicle &vehicle,
+                               uint64_t system_time_ms) {
     auto accumulated_time_ms = system_time_ms;
     auto load = vehicle.load;
 
@@ -113,7 +310,7 @@ bool validate_waypoints(const std::vector<Waypoint> &waypoints,
 
 template <typename RouterFunc>
 std::pair<bool, uint64_t> get_pickup_time(Pos pos,
-                                          const std::vector<Waypoint> &waypoints,
+                                          const std::deque<Waypoint> &waypoints,
                                           Pos pickup_pos,
                                           size_t pickup_index,
                                           uint64_t system_time_ms,
@@ -206,11 +403,18 @@ void insert_trip_to_vehicle(Trip &trip,
                             size_t pickup_index,
                             size_t dropoff_index,
                             RouterFunc &router_func) {
+    TraceSpan span{"insertion"};
+
     auto wps = generate_waypoints(
         trip, vehicle, pickup_index, dropoff_index, RoutingType::FULL_ROUTE, router_func);
 
     assert(!wps.empty() && "The generated waypoint list should be never empty!");
 
+    // Flatten the routes once so that vehicles advance along them by cursor.
+    for (auto &wp : wps) {
+        build_route_track(wp.route);
+    }
+
     trip.status = TripStatus::DISPATCHED;
     vehicle.waypoints = std::move(wps);
 
@@ -218,13 +422,13 @@ void insert_trip_to_vehicle(Trip &trip,
 }
 
 template <typename RouterFunc>
-std::vector<Waypoint> generate_waypoints(const Trip &trip,
+std::deque<Waypoint> generate_waypoints(const Trip &trip,
                                          const Vehicle &vehicle,
                                          size_t pickup_index,
                                          size_t dropoff_index,
                                          RoutingType routing_type,
                                          RouterFunc &router_func) {
-    std::vector<Waypoint> ret;
+    std::deque<Waypoint> ret;
 
     auto pos = vehicle.pos;
     auto index = 0;
@@ -0,0 +1,122 @@
+/// \author Jian Wen
+/// \date 2021/02/15
+
+#include "features.hpp"
+#include "geo.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// \brief The per-vehicle part of the features, computed once and shared by all trips.
+struct VehicleSummary {
+    Pos pos;
+    float load = 0;
+    float capacity = 0;
+    float plan_length = 0;
+    float next_stop_eta_s = 0;
+    float plan_end_eta_s = 0;
+    Pos plan_end_pos;
+};
+
+VehicleSummary summarize_vehicle(const Vehicle &vehicle) {
+    VehicleSummary summary;
+
+    summary.pos = vehicle.pos;
+    summary.load = vehicle.load;
+    summary.capacity = vehicle.capacity;
+    summary.plan_length = vehicle.waypoints.size();
+    summary.plan_end_pos = vehicle.pos;
+
+    auto accumulated_time_ms = 0;
+    for (const auto &wp : vehicle.waypoints) {
+        accumulated_time_ms += wp.route.duration_ms;
+        summary.plan_end_pos = wp.pos;
+    }
+
+    if (!vehicle.waypoints.empty()) {
+        summary.next_stop_eta_s = vehicle.waypoints.front().route.duration_ms / 1000.0;
+        summary.plan_end_eta_s = accumulated_time_ms / 1000.0;
+    }
+
+    return summary;
+}
+
+} // namespace
+
+size_t extract_features(const std::vector<size_t> &pending_trip_ids,
+                        const std::vector<Trip> &trips,
+                        const std::vector<size_t> &candidate_vehicle_ids,
+                        const std::vector<Vehicle> &vehicles,
+                        uint64_t system_time_ms,
+                        const FeatureBuffer &buffer) {
+    const auto num_rows = pending_trip_ids.size() * candidate_vehicle_ids.size();
+
+    assert(buffer.data != nullptr && "The feature buffer must not be null!");
+    assert(num_rows <= buffer.row_capacity && "The feature buffer is too small for all pairs!");
+
+    std::vector<VehicleSummary> summaries;
+    summaries.reserve(candidate_vehicle_ids.size());
+    for (auto vehicle_id : candidate_vehicle_ids) {
+        summaries.emplace_back(summarize_vehicle(vehicles[vehicle_id]));
+    }
+
+    auto trip_origin_lon = buffer.column(Feature::TRIP_ORIGIN_LON);
+    auto trip_origin_lat = buffer.column(Feature::TRIP_ORIGIN_LAT);
+    auto trip_destination_lon = buffer.column(Feature::TRIP_DESTINATION_LON);
+    auto trip_destination_lat = buffer.column(Feature::TRIP_DESTINATION_LAT);
+    auto vehicle_lon = buffer.column(Feature::VEHICLE_LON);
+    auto vehicle_lat = buffer.column(Feature::VEHICLE_LAT);
+    auto vehicle_load = buffer.column(Feature::VEHICLE_LOAD);
+    auto vehicle_capacity = buffer.column(Feature::VEHICLE_CAPACITY);
+    auto plan_length = buffer.column(Feature::PLAN_LENGTH);
+    auto next_stop_eta_s = buffer.column(Feature::NEXT_STOP_ETA_S);
+    auto plan_end_eta_s = buffer.column(Feature::PLAN_END_ETA_S);
+    auto plan_end_lon = buffer.column(Feature::PLAN_END_LON);
+    auto plan_end_lat = buffer.column(Feature::PLAN_END_LAT);
+    auto pickup_lower_bound_s = buffer.column(Feature::PICKUP_LOWER_BOUND_S);
+    auto pickup_slack_s = buffer.column(Feature::PICKUP_SLACK_S);
+
+    // Fill the columns row by row, with the vehicles varying fastest.
+    auto row = 0;
+    for (auto trip_id : pending_trip_ids) {
+        const auto &trip = trips[trip_id];
+        const auto max_wait_time_s =
+            (static_cast<double>(trip.max_pickup_time_ms) - system_time_ms) / 1000.0;
+
+        for (const auto &summary : summaries) {
+            const auto lower_bound_s = get_min_travel_time_ms(summary.pos, trip.origin) / 1000.0;
+
+            trip_origin_lon[row] = trip.origin.lon;
+            trip_origin_lat[row] = trip.origin.lat;
+            trip_destination_lon[row] = trip.destination.lon;
+            trip_destination_lat[row] = trip.destination.lat;
+            vehicle_lon[row] = summary.pos.lon;
+            vehicle_lat[row] = summary.pos.lat;
+            vehicle_load[row] = summary.load;
+            vehicle_capacity[row] = summary.capacity;
+            plan_length[row] = summary.plan_length;
+            next_stop_eta_s[row] = summary.next_stop_eta_s;
+            plan_end_eta_s[row] = summary.plan_end_eta_s;
+            plan_end_lon[row] = summary.plan_end_pos.lon;
+            plan_end_lat[row] = summary.plan_end_pos.lat;
+            pickup_lower_bound_s[row] = lower_bound_s;
+            pickup_slack_s[row] = max_wait_time_s - lower_bound_s;
+
+            row++;
+        }
+    }
+
+    return num_rows;
+}
+
+void score_by_pickup_lower_bound(const FeatureBuffer &buffer, size_t num_rows, float *scores) {
+    const auto pickup_lower_bound_s = buffer.column(Feature::PICKUP_LOWER_BOUND_S);
+    const auto pickup_slack_s = buffer.column(Feature::PICKUP_SLACK_S);
+
+    for (auto row = 0; row < num_rows; row++) {
+        scores[row] = pickup_slack_s[row] >= 0 ? pickup_lower_bound_s[row]
+                                               : std::numeric_limits<float>::infinity();
+    }
+}
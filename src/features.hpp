@@ -0,0 +1,64 @@
+/// \author Jian Wen
+/// \date 2021/02/15
+
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+
+/// \brief The features describing a trip-vehicle pair, used by ML-based dispatching.
+/// \details Poses are in degrees, times in seconds and relative to the current system time.
+enum class Feature : size_t {
+    TRIP_ORIGIN_LON,       // longitude of the trip origin
+    TRIP_ORIGIN_LAT,       // latitude of the trip origin
+    TRIP_DESTINATION_LON,  // longitude of the trip destination
+    TRIP_DESTINATION_LAT,  // latitude of the trip destination
+    VEHICLE_LON,           // longitude of the current vehicle pos
+    VEHICLE_LAT,           // latitude of the current vehicle pos
+    VEHICLE_LOAD,          // number of travelers onboard
+    VEHICLE_CAPACITY,      // capacity of the vehicle
+    PLAN_LENGTH,           // number of waypoints the vehicle is planned to serve
+    NEXT_STOP_ETA_S,       // time to reach the next waypoint, 0 if idle
+    PLAN_END_ETA_S,        // time to complete all planned waypoints, 0 if idle
+    PLAN_END_LON,          // longitude of the last planned waypoint (or the vehicle if idle)
+    PLAN_END_LAT,          // latitude of the last planned waypoint (or the vehicle if idle)
+    PICKUP_LOWER_BOUND_S,  // lower bound of the time to pick up the trip from the current pos
+    PICKUP_SLACK_S,        // max pickup time of the trip minus the pickup lower bound
+    COUNT                  // the number of features, not a feature itself
+};
+
+/// \brief A non-owning, column-major (structure-of-arrays) float buffer of features.
+/// \details The buffer holds static_cast<size_t>(Feature::COUNT) columns of row_capacity floats
+/// each. Row k describes the pair of the (k / num_vehicles)-th trip and the (k % num_vehicles)-th
+/// vehicle. The memory is provided by the caller (e.g. a numpy array of shape
+/// [Feature::COUNT, row_capacity]) so that features never need to be copied across the boundary.
+struct FeatureBuffer {
+    float *data = nullptr;   // the first element of the first column
+    size_t row_capacity = 0; // the max number of rows (aka the stride between columns)
+
+    /// \brief The pointer to the first element of the column of the given feature.
+    float *column(Feature feature) const {
+        return data + static_cast<size_t>(feature) * row_capacity;
+    }
+};
+
+/// \brief Fill the feature buffer with features of all pairs of pending trips and vehicles.
+/// \param pending_trip_ids A vector holding indices to the pending trips.
+/// \param trips A vector of all trips.
+/// \param candidate_vehicle_ids A vector holding indices to the candidate vehicles.
+/// \param vehicles A vector of all vehicles.
+/// \param system_time_ms The current system time.
+/// \param buffer The caller-provided buffer, which must hold at least #trips * #vehicles rows.
+/// \return The number of rows written.
+size_t extract_features(const std::vector<size_t> &pending_trip_ids,
+                        const std::vector<Trip> &trips,
+                        const std::vector<size_t> &candidate_vehicle_ids,
+                        const std::vector<Vehicle> &vehicles,
+                        uint64_t system_time_ms,
+                        const FeatureBuffer &buffer);
+
+/// \brief The baseline batch scorer that ranks vehicles by the lower bound of pickup time.
+/// \details A batch scorer takes the feature buffer and the number of rows, and writes one score
+/// per row. Lower scores are better. Non-finite scores mark pairs that should not be considered.
+void score_by_pickup_lower_bound(const FeatureBuffer &buffer, size_t num_rows, float *scores);
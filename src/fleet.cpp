@@ -0,0 +1,95 @@
+/// \author Jian Wen
+/// \date 2021/02/16
+
+#include "fleet.hpp"
+#include "geo.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void sync_fleet_state(FleetState &fleet_state,
+                      const std::vector<Vehicle> &vehicles,
+                      uint64_t system_time_ms) {
+    const auto num_vehicles = vehicles.size();
+
+    fleet_state.lon.resize(num_vehicles);
+    fleet_state.lat.resize(num_vehicles);
+    fleet_state.load.resize(num_vehicles);
+    fleet_state.capacity.resize(num_vehicles);
+    fleet_state.next_stop_time_ms.resize(num_vehicles);
+    fleet_state.plan_end_lon.resize(num_vehicles);
+    fleet_state.plan_end_lat.resize(num_vehicles);
+    fleet_state.plan_end_time_ms.resize(num_vehicles);
+
+    for (const auto &vehicle : vehicles) {
+        sync_vehicle_state(fleet_state, vehicle, system_time_ms);
+    }
+}
+
+void sync_vehicle_state(FleetState &fleet_state, const Vehicle &vehicle, uint64_t system_time_ms) {
+    const auto i = vehicle.id;
+
+    assert(i < fleet_state.lon.size() && "Vehicle id in sync_vehicle_state() is out of bound!");
+
+    fleet_state.lon[i] = vehicle.pos.lon;
+    fleet_state.lat[i] = vehicle.pos.lat;
+    fleet_state.load[i] = vehicle.load;
+    fleet_state.capacity[i] = vehicle.capacity;
+
+    auto plan_end_pos = vehicle.pos;
+    auto plan_end_time_ms = system_time_ms;
+    for (const auto &wp : vehicle.waypoints) {
+        plan_end_pos = wp.pos;
+        plan_end_time_ms += wp.route.duration_ms;
+    }
+
+    fleet_state.next_stop_time_ms[i] =
+        vehicle.waypoints.empty() ? system_time_ms
+                                  : system_time_ms + vehicle.waypoints.front().route.duration_ms;
+    fleet_state.plan_end_lon[i] = plan_end_pos.lon;
+    fleet_state.plan_end_lat[i] = plan_end_pos.lat;
+    fleet_state.plan_end_time_ms[i] = plan_end_time_ms;
+}
+
+void filter_vehicles_by_pickup_deadline(const FleetState &fleet_state,
+                                        const Pos &origin,
+                                        uint64_t system_time_ms,
+                                        uint64_t max_pickup_time_ms,
+                                        std::vector<size_t> &vehicle_ids) {
+    vehicle_ids.clear();
+
+    if (max_pickup_time_ms < system_time_ms) {
+        return;
+    }
+
+    // The max distance (in degrees of latitude) a vehicle could travel before the deadline, with
+    // a 1% safety margin for the approximation.
+    constexpr double kMetersPerDegree = 6371000.0 * M_PI / 180.0;
+    const auto max_dist_deg = static_cast<float>((max_pickup_time_ms - system_time_ms) / 1000.0 *
+                                                 kMaxVehicleSpeedMps / kMetersPerDegree / 0.99);
+    const auto max_dist_deg_squared = max_dist_deg * max_dist_deg;
+
+    // A degree of longitude shrinks with the cosine of latitude. Using the latitude farthest from
+    // the equator within reach keeps the distance a lower bound.
+    const auto max_abs_lat = std::min(89.0, std::abs(origin.lat) + 1.0 * max_dist_deg);
+    const auto lon_scale = static_cast<float>(std::cos(max_abs_lat * M_PI / 180.0));
+
+    const auto num_vehicles = fleet_state.lon.size();
+    const auto lon = fleet_state.lon.data();
+    const auto lat = fleet_state.lat.data();
+
+    // First pass is branch-free to allow vectorization.
+    std::vector<uint8_t> reachable(num_vehicles);
+    for (auto i = 0; i < num_vehicles; i++) {
+        const auto dlon = (lon[i] - origin.lon) * lon_scale;
+        const auto dlat = lat[i] - origin.lat;
+        reachable[i] = dlon * dlon + dlat * dlat <= max_dist_deg_squared;
+    }
+
+    // Second pass collects the ids.
+    for (auto i = 0; i < num_vehicles; i++) {
+        if (reachable[i]) {
+            vehicle_ids.emplace_back(i);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/// \author Jian Wen
+/// \date 2021/02/16
+
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/// \brief The hot states of all vehicles laid out as structure of arrays, indexed by vehicle id.
+/// \details The vehicles (together with their waypoints and statistics) remain the source of
+/// truth. The fleet state mirrors the fields that fleet-wide scans need in a few dense arrays, and
+/// is refreshed right before each dispatch, the only place that scans the whole fleet per trip.
+/// Scans over it touch contiguous memory only and are written branch-free so that the compiler can
+/// vectorize them.
+struct FleetState {
+    std::vector<float> lon;                  // longitude of the current vehicle pos
+    std::vector<float> lat;                  // latitude of the current vehicle pos
+    std::vector<int32_t> load;               // number of travelers onboard
+    std::vector<int32_t> capacity;           // capacity of the vehicle
+    std::vector<uint64_t> next_stop_time_ms; // the time to reach the next waypoint (now if idle)
+    std::vector<float> plan_end_lon;         // longitude of the last waypoint (the pos if idle)
+    std::vector<float> plan_end_lat;         // latitude of the last waypoint (the pos if idle)
+    std::vector<uint64_t> plan_end_time_ms;  // the time to complete all waypoints (now if idle)
+};
+
+/// \brief Refresh the fleet state from the vehicles.
+void sync_fleet_state(FleetState &fleet_state,
+                      const std::vector<Vehicle> &vehicles,
+                      uint64_t system_time_ms);
+
+/// \brief Refresh the fleet state of a single vehicle.
+void sync_vehicle_state(FleetState &fleet_state, const Vehicle &vehicle, uint64_t system_time_ms);
+
+/// \brief Find the vehicles that could possibly pick up at the origin before the deadline.
+/// \details A vehicle is ruled out if even traveling at kMaxVehicleSpeedMps in a straight line from
+/// its current pos, it would arrive after the deadline. The straight-line distance is approximated
+/// conservatively (equirectangular projection at the latitude farthest from the equator, with a
+/// safety margin), which is exact enough at the city scale.
+/// \param fleet_state The fleet state.
+/// \param origin The pickup pos.
+/// \param system_time_ms The current system time.
+/// \param max_pickup_time_ms The deadline to pick up.
+/// \param vehicle_ids The output vector of ids of the candidate vehicles, in increasing order.
+void filter_vehicles_by_pickup_deadline(const FleetState &fleet_state,
+                                        const Pos &origin,
+                                        uint64_t system_time_ms,
+                                        uint64_t max_pickup_time_ms,
+                                        std::vector<size_t> &vehicle_ids);
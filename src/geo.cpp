@@ -0,0 +1,100 @@
+/// \author Jian Wen
+/// \date 2021/02/15
+
+#include "geo.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+double get_haversine_distance_m(const Pos &from, const Pos &to) {
+    constexpr double kEarthRadiusM = 6371000.0;
+    constexpr double kDegToRad = M_PI / 180.0;
+
+    const auto dlat = (to.lat - from.lat) * kDegToRad;
+    const auto dlon = (to.lon - from.lon) * kDegToRad;
+
+    const auto a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+                   std::cos(from.lat * kDegToRad) * std::cos(to.lat * kDegToRad) *
+                       std::sin(dlon / 2) * std::sin(dlon / 2);
+
+    return 2 * kEarthRadiusM * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+uint64_t get_min_travel_time_ms(const Pos &from, const Pos &to) {
+    return static_cast<uint64_t>(get_haversine_distance_m(from, to) / kMaxVehicleSpeedMps * 1000);
+}
+
+std::vector<Pos> simplify_polyline(const std::vector<Pos> &poses, double tolerance_m) {
+    if (poses.size() <= 2) {
+        return poses;
+    }
+
+    // Project the poses onto a local plane in meters, around the first pos.
+    constexpr double kEarthRadiusM = 6371000.0;
+    constexpr double kDegToRad = M_PI / 180.0;
+    const auto lon_scale_m = kEarthRadiusM * kDegToRad * std::cos(poses.front().lat * kDegToRad);
+    const auto lat_scale_m = kEarthRadiusM * kDegToRad;
+
+    std::vector<double> xs(poses.size());
+    std::vector<double> ys(poses.size());
+    for (auto i = 0; i < poses.size(); i++) {
+        xs[i] = (poses[i].lon - poses.front().lon) * lon_scale_m;
+        ys[i] = (poses[i].lat - poses.front().lat) * lat_scale_m;
+    }
+
+    // Split the polyline at the pos farthest from the segment between the ends of each range,
+    // until all poses of the range are within the tolerance. The ranges are kept on a stack
+    // instead of recursing, so long polylines do not overflow the call stack.
+    std::vector<bool> kept(poses.size(), false);
+    kept.front() = true;
+    kept.back() = true;
+
+    const auto tolerance_squared_m2 = tolerance_m * tolerance_m;
+    std::vector<std::pair<size_t, size_t>> ranges{{0, poses.size() - 1}};
+
+    while (!ranges.empty()) {
+        const auto [begin, end] = ranges.back();
+        ranges.pop_back();
+
+        const auto dx = xs[end] - xs[begin];
+        const auto dy = ys[end] - ys[begin];
+        const auto length_squared_m2 = dx * dx + dy * dy;
+
+        auto max_distance_squared_m2 = 0.0;
+        auto farthest = begin;
+        for (auto i = begin + 1; i < end; i++) {
+            // The squared distance from the pos to the segment, clamped at the ends.
+            const auto t =
+                length_squared_m2 > 0
+                    ? std::clamp(((xs[i] - xs[begin]) * dx + (ys[i] - ys[begin]) * dy) /
+                                     length_squared_m2,
+                                 0.0,
+                                 1.0)
+                    : 0.0;
+            const auto ex = xs[begin] + t * dx - xs[i];
+            const auto ey = ys[begin] + t * dy - ys[i];
+            const auto distance_squared_m2 = ex * ex + ey * ey;
+
+            if (distance_squared_m2 > max_distance_squared_m2) {
+                max_distance_squared_m2 = distance_squared_m2;
+                farthest = i;
+            }
+        }
+
+        if (max_distance_squared_m2 > tolerance_squared_m2) {
+            kept[farthest] = true;
+            ranges.emplace_back(begin, farthest);
+            ranges.emplace_back(farthest, end);
+        }
+    }
+
+    std::vector<Pos> simplified_poses;
+    for (auto i = 0; i < poses.size(); i++) {
+        if (kept[i]) {
+            simplified_poses.push_back(poses[i]);
+        }
+    }
+
+    return simplified_poses;
+}
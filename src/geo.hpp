@@ -0,0 +1,28 @@
+/// \author Jian Wen
+/// \date 2021/02/15
+
+#pragma once
+
+#include "types.hpp"
+
+/// \brief The assumed max speed of any vehicle in meters per second (~126 km/h).
+/// \details Used to derive lower bounds of travel times from straight-line distances, which lets
+/// us rule out vehicles/trips without invoking the router.
+constexpr double kMaxVehicleSpeedMps = 35.0;
+
+/// \brief Compute the great-circle distance between two poses in meters.
+double get_haversine_distance_m(const Pos &from, const Pos &to);
+
+/// \brief Compute the lower bound of the travel time between two poses in milliseconds.
+/// \details The road network distance is never shorter than the great-circle distance, and no
+/// vehicle travels faster than kMaxVehicleSpeedMps.
+uint64_t get_min_travel_time_ms(const Pos &from, const Pos &to);
+
+/// \brief Simplify the polyline through the Douglas-Peucker algorithm.
+/// \details The first and the last poses are always kept. Each pos in between is dropped only if it
+/// lies within the tolerance of the simplified polyline. Distances are measured in a local
+/// equirectangular projection, which is exact enough at the city scale.
+/// \param poses The poses of the polyline.
+/// \param tolerance_m The max distance in meters between a dropped pos and the simplified polyline.
+/// \return The poses kept, in the original order.
+std::vector<Pos> simplify_polyline(const std::vector<Pos> &poses, double tolerance_m);
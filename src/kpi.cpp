@@ -0,0 +1,191 @@
+/// \author Jian Wen
+/// \date 2021/02/25
+
+#include "kpi.hpp"
+#include "serialization.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+void LatencyHistogram::record(uint64_t value_ms) {
+    count_++;
+    bucket_counts_[get_bucket_index(value_ms)]++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    count_ += other.count_;
+    for (auto i = 0; i < kNumBuckets; i++) {
+        bucket_counts_[i] += other.bucket_counts_[i];
+    }
+}
+
+double LatencyHistogram::get_percentile_ms(double quantile) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+
+    // The rank of the percentile among all values, starting from 1.
+    const auto rank = std::max<uint64_t>(1, std::ceil(quantile * count_));
+
+    uint64_t accumulated_count = 0;
+    for (auto i = 0; i < kNumBuckets; i++) {
+        accumulated_count += bucket_counts_[i];
+
+        if (accumulated_count >= rank) {
+            return get_bucket_mid_value(i);
+        }
+    }
+
+    assert(false && "Logical error! We should never reach this line of code!");
+    return 0.0;
+}
+
+size_t LatencyHistogram::get_bucket_index(uint64_t value_ms) {
+    constexpr uint64_t kMaxValueMs = (uint64_t{1} << kMaxValueBits) - 1;
+    value_ms = std::min(value_ms, kMaxValueMs);
+
+    // Small values are counted exactly.
+    if (value_ms < (uint64_t{2} << kSubBucketBits)) {
+        return value_ms;
+    }
+
+    // Otherwise keep the kSubBucketBits + 1 most significant bits.
+    auto magnitude = 0;
+    while ((value_ms >> magnitude) >= (uint64_t{2} << kSubBucketBits)) {
+        magnitude++;
+    }
+
+    return (magnitude << kSubBucketBits) + (value_ms >> magnitude);
+}
+
+double LatencyHistogram::get_bucket_mid_value(size_t bucket_index) {
+    if (bucket_index < (size_t{2} << kSubBucketBits)) {
+        return bucket_index;
+    }
+
+    const auto magnitude = (bucket_index >> kSubBucketBits) - 1;
+    const auto sub_bucket = bucket_index - (magnitude << kSubBucketBits);
+    const auto lower_value = static_cast<double>(uint64_t{sub_bucket} << magnitude);
+    const auto bucket_width = static_cast<double>(uint64_t{1} << magnitude);
+
+    return lower_value + (bucket_width - 1) / 2;
+}
+
+void KpiWindow::merge(const KpiWindow &other) {
+    trip_count += other.trip_count;
+    dispatched_trip_count += other.dispatched_trip_count;
+    completed_trip_count += other.completed_trip_count;
+    total_wait_time_ms += other.total_wait_time_ms;
+    total_travel_time_ms += other.total_travel_time_ms;
+    dist_traveled_mm += other.dist_traveled_mm;
+    loaded_dist_traveled_mm += other.loaded_dist_traveled_mm;
+}
+
+KpiAccumulator::KpiAccumulator(uint64_t _main_sim_start_time_ms,
+                               uint64_t _main_sim_end_time_ms,
+                               size_t _num_vehicles,
+                               uint64_t _window_ms)
+    : main_sim_start_time_ms_(_main_sim_start_time_ms),
+      main_sim_end_time_ms_(_main_sim_end_time_ms), num_vehicles_(_num_vehicles),
+      window_ms_(_window_ms) {
+    assert(window_ms_ > 0 && "The window of KpiAccumulator must be positive!");
+
+    const auto main_sim_duration_ms = main_sim_end_time_ms_ - main_sim_start_time_ms_;
+    windows_.resize((main_sim_duration_ms + window_ms_ - 1) / window_ms_);
+}
+
+void KpiAccumulator::record_request(const Trip &trip) {
+    if (auto window = get_window(trip.request_time_ms)) {
+        total_.trip_count++;
+        window->trip_count++;
+    }
+}
+
+void KpiAccumulator::record_dispatch(const Trip &trip) {
+    if (trip.status == TripStatus::WALKAWAY) {
+        return;
+    }
+
+    if (auto window = get_window(trip.request_time_ms)) {
+        total_.dispatched_trip_count++;
+        window->dispatched_trip_count++;
+    }
+}
+
+void KpiAccumulator::record_dropoff(const Trip &trip) {
+    if (auto window = get_window(trip.request_time_ms)) {
+        const uint64_t wait_time_ms = trip.pickup_time_ms - trip.request_time_ms;
+        const uint64_t travel_time_ms = trip.dropoff_time_ms - trip.pickup_time_ms;
+
+        total_.completed_trip_count++;
+        total_.total_wait_time_ms += wait_time_ms;
+        total_.total_travel_time_ms += travel_time_ms;
+
+        window->completed_trip_count++;
+        window->total_wait_time_ms += wait_time_ms;
+        window->total_travel_time_ms += travel_time_ms;
+
+        wait_time_histogram_.record(wait_time_ms);
+        travel_time_histogram_.record(travel_time_ms);
+    }
+}
+
+void KpiAccumulator::record_distance(uint64_t system_time_ms,
+                                     uint64_t dist_traveled_mm,
+                                     uint64_t loaded_dist_traveled_mm) {
+    total_.dist_traveled_mm += dist_traveled_mm;
+    total_.loaded_dist_traveled_mm += loaded_dist_traveled_mm;
+
+    // The distance traveled right at the end of the main simulation goes to the last window.
+    auto window = get_window(std::min(system_time_ms, main_sim_end_time_ms_ - 1));
+    if (window != nullptr) {
+        window->dist_traveled_mm += dist_traveled_mm;
+        window->loaded_dist_traveled_mm += loaded_dist_traveled_mm;
+    }
+}
+
+void KpiAccumulator::merge(const KpiAccumulator &other) {
+    assert(main_sim_end_time_ms_ - main_sim_start_time_ms_ ==
+               other.main_sim_end_time_ms_ - other.main_sim_start_time_ms_ &&
+           window_ms_ == other.window_ms_ &&
+           "Only the accumulators of the same main simulation duration and window can be merged!");
+
+    num_vehicles_ += other.num_vehicles_;
+    total_.merge(other.total_);
+    for (auto i = 0; i < windows_.size(); i++) {
+        windows_[i].merge(other.windows_[i]);
+    }
+    wait_time_histogram_.merge(other.wait_time_histogram_);
+    travel_time_histogram_.merge(other.travel_time_histogram_);
+}
+
+void KpiAccumulator::save_state(std::ostream &out) const {
+    write_binary(out, main_sim_start_time_ms_);
+    write_binary(out, main_sim_end_time_ms_);
+    write_binary(out, num_vehicles_);
+    write_binary(out, window_ms_);
+    write_binary(out, total_);
+    write_binary(out, windows_);
+    write_binary(out, wait_time_histogram_);
+    write_binary(out, travel_time_histogram_);
+}
+
+void KpiAccumulator::load_state(std::istream &in) {
+    read_binary(in, main_sim_start_time_ms_);
+    read_binary(in, main_sim_end_time_ms_);
+    read_binary(in, num_vehicles_);
+    read_binary(in, window_ms_);
+    read_binary(in, total_);
+    read_binary(in, windows_);
+    read_binary(in, wait_time_histogram_);
+    read_binary(in, travel_time_histogram_);
+}
+
+KpiWindow *KpiAccumulator::get_window(uint64_t time_ms) {
+    if (time_ms < main_sim_start_time_ms_ || time_ms >= main_sim_end_time_ms_) {
+        return nullptr;
+    }
+
+    return &windows_[(time_ms - main_sim_start_time_ms_) / window_ms_];
+}
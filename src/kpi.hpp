@@ -0,0 +1,166 @@
+/// \author Jian Wen
+/// \date 2021/02/25
+
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/// \brief The default length of the rolling windows of the key performance indicators.
+constexpr uint64_t kKpiWindowMs = 15 * 60 * 1000;
+
+/// \brief The histogram of durations in milliseconds with bounded relative error (HDR-style).
+/// \details Durations below 128 ms are counted exactly. Larger durations fall into log-linear
+/// buckets, 64 per power of two, so that any percentile is within 1% of the exact value. Durations
+/// beyond 2^32 ms (~50 days) are clamped. The memory is fixed regardless of the number of values,
+/// and histograms are merged by adding up the buckets.
+class LatencyHistogram {
+  public:
+    /// \brief Record a duration.
+    void record(uint64_t value_ms);
+
+    /// \brief Add up the counts of the other histogram.
+    void merge(const LatencyHistogram &other);
+
+    /// \brief Get the number of recorded durations.
+    uint64_t get_count() const { return count_; }
+
+    /// \brief Get the percentile in milliseconds, 0 if empty.
+    /// \param quantile The quantile in [0, 1], e.g. 0.99 for p99.
+    double get_percentile_ms(double quantile) const;
+
+  private:
+    /// \brief The number of sub-buckets per power of two is 2^kSubBucketBits.
+    static constexpr size_t kSubBucketBits = 6;
+
+    /// \brief The max duration is 2^kMaxValueBits - 1 milliseconds.
+    static constexpr size_t kMaxValueBits = 32;
+
+    /// \brief The total number of buckets.
+    static constexpr size_t kNumBuckets = (kMaxValueBits - kSubBucketBits + 1) << kSubBucketBits;
+
+    /// \brief Get the index of the bucket of the value.
+    static size_t get_bucket_index(uint64_t value_ms);
+
+    /// \brief Get the value at the middle of the bucket.
+    static double get_bucket_mid_value(size_t bucket_index);
+
+    /// \brief The number of recorded durations.
+    uint64_t count_ = 0;
+
+    /// \brief The counts of each bucket.
+    std::array<uint64_t, kNumBuckets> bucket_counts_ = {};
+};
+
+/// \brief The key performance indicators accumulated over a window of time.
+/// \details The trips are counted in the window of their request time, no matter when they are
+/// dispatched or dropped off. The distances are counted in the window they are traveled.
+struct KpiWindow {
+    uint64_t trip_count = 0;              // number of trips requested
+    uint64_t dispatched_trip_count = 0;   // number of trips dispatched
+    uint64_t completed_trip_count = 0;    // number of trips dropped off
+    uint64_t total_wait_time_ms = 0;      // total wait time of the completed trips
+    uint64_t total_travel_time_ms = 0;    // total in-vehicle time of the completed trips
+    uint64_t dist_traveled_mm = 0;        // total distance traveled by all vehicles
+    uint64_t loaded_dist_traveled_mm = 0; // total distance traveled weighted by the load
+
+    /// \brief Add up the other window.
+    void merge(const KpiWindow &other);
+};
+
+/// \brief The streaming accumulator of the key performance indicators of the main simulation.
+/// \details The accumulator is updated as trips are requested, dispatched and dropped off, and as
+/// vehicles travel, instead of scanning all trips at the end of the simulation. Only the trips
+/// requested during the main simulation are counted. The memory is independent of the number of
+/// trips. The accumulators of the replications of the same scenario can be merged into one, which
+/// yields the distributions over all replications.
+class KpiAccumulator {
+  public:
+    /// \brief Default constructor of an empty accumulator.
+    KpiAccumulator() = default;
+
+    /// \brief Constructor.
+    /// \param _main_sim_start_time_ms The main simulation start time.
+    /// \param _main_sim_end_time_ms The main simulation end time.
+    /// \param _num_vehicles The fleet size.
+    /// \param _window_ms The length of the rolling windows.
+    KpiAccumulator(uint64_t _main_sim_start_time_ms,
+                   uint64_t _main_sim_end_time_ms,
+                   size_t _num_vehicles,
+                   uint64_t _window_ms = kKpiWindowMs);
+
+    /// \brief Record the trip once requested.
+    void record_request(const Trip &trip);
+
+    /// \brief Record the trip once dispatched, or walked away if it could not be dispatched.
+    void record_dispatch(const Trip &trip);
+
+    /// \brief Record the trip once dropped off.
+    void record_dropoff(const Trip &trip);
+
+    /// \brief Record the distance traveled by a vehicle at the given time.
+    void record_distance(uint64_t system_time_ms,
+                         uint64_t dist_traveled_mm,
+                         uint64_t loaded_dist_traveled_mm);
+
+    /// \brief Merge the accumulator of another replication of the same scenario.
+    void merge(const KpiAccumulator &other);
+
+    /// \brief Get the indicators over the entire main simulation.
+    const KpiWindow &get_total() const { return total_; }
+
+    /// \brief Get the indicators over each rolling window of the main simulation.
+    const std::vector<KpiWindow> &get_windows() const { return windows_; }
+
+    /// \brief Get the histogram of the wait times of the completed trips.
+    const LatencyHistogram &get_wait_time_histogram() const { return wait_time_histogram_; }
+
+    /// \brief Get the histogram of the in-vehicle times of the completed trips.
+    const LatencyHistogram &get_travel_time_histogram() const { return travel_time_histogram_; }
+
+    /// \brief Get the number of vehicles, summed up over the merged replications.
+    size_t get_num_vehicles() const { return num_vehicles_; }
+
+    /// \brief Get the length of the rolling windows.
+    uint64_t get_window_ms() const { return window_ms_; }
+
+    /// \brief Save the state of accumulation into the binary stream, to be restored by load_state.
+    void save_state(std::ostream &out) const;
+
+    /// \brief Restore the state of accumulation from the binary stream.
+    void load_state(std::istream &in);
+
+  private:
+    /// \brief Get the window of the time, nullptr if out of the main simulation.
+    KpiWindow *get_window(uint64_t time_ms);
+
+    /// \brief The main simulation start time.
+    uint64_t main_sim_start_time_ms_ = 0;
+
+    /// \brief The main simulation end time.
+    uint64_t main_sim_end_time_ms_ = 0;
+
+    /// \brief The number of vehicles, summed up over the merged replications.
+    size_t num_vehicles_ = 0;
+
+    /// \brief The length of the rolling windows.
+    uint64_t window_ms_ = kKpiWindowMs;
+
+    /// \brief The indicators over the entire main simulation.
+    KpiWindow total_;
+
+    /// \brief The indicators over each rolling window.
+    std::vector<KpiWindow> windows_ = {};
+
+    /// \brief The histogram of the wait times of the completed trips.
+    LatencyHistogram wait_time_histogram_;
+
+    /// \brief The histogram of the in-vehicle times of the completed trips.
+    LatencyHistogram travel_time_histogram_;
+};
@@ -0,0 +1,212 @@
+/// \author Jian Wen
+/// \date 2021/02/26
+
+#include "logger.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+void write_log_record(std::FILE *file, const LogRecord &record) {
+    const auto &f = record.fields;
+
+    switch (record.event) {
+    case LogEvent::VEHICLES_ADVANCED:
+        fmt::print(file,
+                   "[DEBUG] T = {}s: Advanced vehicles by {}s.\n",
+                   f[0].u / 1000.0,
+                   f[1].u / 1000.0);
+        break;
+    case LogEvent::TRIPS_GENERATED:
+        fmt::print(file,
+                   "[DEBUG] T = {}s: Generated {} request(s) in this cycle:\n",
+                   f[0].u / 1000.0,
+                   f[1].u);
+        break;
+    case LogEvent::TRIP_REQUESTED:
+        fmt::print(file,
+                   "[DEBUG] Trip #{} requested at T = {}s, from origin ({}, {}) to destination "
+                   "({}, {}):\n",
+                   f[0].u,
+                   f[1].u / 1000.0,
+                   f[2].f,
+                   f[3].f,
+                   f[4].f,
+                   f[5].f);
+        break;
+    case LogEvent::TRIPS_DISPATCHING:
+        fmt::print(file,
+                   "[DEBUG] T = {}s: Dispatching {} pending trip(s) to vehicles.\n",
+                   f[0].u / 1000.0,
+                   f[1].u);
+        break;
+    case LogEvent::DATALOG_WRITTEN:
+        fmt::print(file, "[DEBUG] T = {}s: Wrote to datalog.\n", f[0].u / 1000.0);
+        break;
+    case LogEvent::TRIP_PICKED_UP:
+        fmt::print(file,
+                   "[DEBUG] T = {}s: Vehicle #{} picked up Trip #{}\n",
+                   f[0].u / 1000.0,
+                   f[1].u,
+                   f[2].u);
+        break;
+    case LogEvent::TRIP_DROPPED_OFF:
+        fmt::print(file,
+                   "[DEBUG] T = {}s: Vehicle #{} droped off Trip #{}\n",
+                   f[0].u / 1000.0,
+                   f[1].u,
+                   f[2].u);
+        break;
+    case LogEvent::INSERTION_STARTED:
+        fmt::print(file, "[DEBUG] Assigning trips to vehicles through insertion heuristics.\n");
+        break;
+    case LogEvent::ZONED_INSERTION_STARTED:
+        fmt::print(file,
+                   "[DEBUG] Assigning trips to vehicles through zoned insertion heuristics.\n");
+        break;
+    case LogEvent::ZONES_DISPATCHED:
+        fmt::print(file,
+                   "[DEBUG] Dispatched {} trip(s) within {} zone(s), reconciling {} border "
+                   "trip(s) and {} trip(s) unassigned locally.\n",
+                   f[0].u,
+                   f[1].u,
+                   f[2].u,
+                   f[3].u);
+        break;
+    case LogEvent::BATCH_SCORING_STARTED:
+        fmt::print(file, "[DEBUG] Assigning trips to vehicles through batch scoring.\n");
+        break;
+    case LogEvent::TRIP_ASSIGNED:
+        fmt::print(file,
+                   "[DEBUG] Assigned Trip #{} to Vehicle #{}, which has {} waypoints.\n",
+                   f[0].u,
+                   f[1].u,
+                   f[2].u);
+        break;
+    case LogEvent::TRIP_ASSIGNED_BY_SCORE:
+        fmt::print(file,
+                   "[DEBUG] Assigned Trip #{} to Vehicle #{} (ranked #{} by score {}).\n",
+                   f[0].u,
+                   f[1].u,
+                   f[2].u,
+                   f[3].f);
+        break;
+    case LogEvent::TRIP_UNASSIGNED:
+        fmt::print(file, "[DEBUG] Failed to assign Trip #{}.\n", f[0].u);
+        break;
+    }
+}
+
+Logger &Logger::get_instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    condition_variable_.notify_all();
+
+    if (sink_thread_.joinable()) {
+        sink_thread_.join();
+    }
+}
+
+void Logger::push(const LogRecord &record) {
+    // Each thread registers its ring buffer once, which is the only time a lock is taken.
+    thread_local auto ring_buffer = create_ring_buffer();
+
+    num_pending_records_.fetch_add(1);
+    while (!ring_buffer->try_push(record)) {
+        std::this_thread::yield();
+    }
+
+    // Wake up the sink if it is waiting. The sink sets the flag before checking for the pending
+    // records, and we count the record before checking the flag, so either of us sees the other.
+    if (sink_waiting_.load()) {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            sink_waiting_ = false;
+        }
+        condition_variable_.notify_one();
+    }
+}
+
+void Logger::flush() {
+    // The sink is already woken up by the pushes of the pending records.
+    while (num_pending_records_.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+
+    std::fflush(stdout);
+}
+
+std::shared_ptr<Logger::RingBuffer> Logger::create_ring_buffer() {
+    auto ring_buffer = std::make_shared<RingBuffer>();
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    ring_buffers_.push_back(ring_buffer);
+    if (!sink_thread_.joinable()) {
+        sink_thread_ = std::thread{&Logger::run, this};
+    }
+
+    return ring_buffer;
+}
+
+void Logger::run() {
+    while (true) {
+        if (drain_ring_buffers() > 0) {
+            continue;
+        }
+
+        // Nothing to write for now, so sleep until the next record. A record counted before the
+        // flag is set is seen here, and the producers of the later ones see the flag.
+        std::unique_lock<std::mutex> lock{mutex_};
+        if (stopping_) {
+            break;
+        }
+        sink_waiting_ = true;
+        if (num_pending_records_.load() > 0) {
+            sink_waiting_ = false;
+            continue;
+        }
+        condition_variable_.wait(lock, [this] { return !sink_waiting_ || stopping_; });
+        sink_waiting_ = false;
+    }
+
+    // Write what is left before the logger is gone.
+    while (drain_ring_buffers() > 0) {
+    }
+    std::fflush(stdout);
+}
+
+size_t Logger::drain_ring_buffers() {
+    std::vector<std::shared_ptr<RingBuffer>> ring_buffers;
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        // The ring buffers only referred to here belong to the threads that have exited.
+        ring_buffers_.erase(std::remove_if(ring_buffers_.begin(),
+                                           ring_buffers_.end(),
+                                           [](const auto &ring_buffer) {
+                                               return ring_buffer.use_count() == 1 &&
+                                                      ring_buffer->empty();
+                                           }),
+                            ring_buffers_.end());
+        ring_buffers = ring_buffers_;
+    }
+
+    size_t num_records = 0;
+    LogRecord record;
+    for (auto &ring_buffer : ring_buffers) {
+        while (ring_buffer->try_pop(record)) {
+            write_log_record(stdout, record);
+            num_records++;
+        }
+    }
+    num_pending_records_.fetch_sub(num_records, std::memory_order_release);
+
+    return num_records;
+}
@@ -0,0 +1,160 @@
+/// \author Jian Wen
+/// \date 2021/02/26
+
+#pragma once
+
+#include "ring_buffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// \brief The level of the log records.
+enum class LogLevel : uint8_t { DEBUG = 0, INFO = 1, WARNING = 2, ERROR = 3 };
+
+// The minimum log level compiled in. The records below it are eliminated at compile time. Unless
+// defined by the build, DEBUG is compiled in except for release builds.
+#ifndef MODABM_LOG_LEVEL
+#ifdef NDEBUG
+#define MODABM_LOG_LEVEL 1
+#else
+#define MODABM_LOG_LEVEL 0
+#endif
+#endif
+
+/// \brief The minimum log level compiled in.
+constexpr LogLevel kMinLogLevel = static_cast<LogLevel>(MODABM_LOG_LEVEL);
+
+/// \brief The events that are logged, each with its own fields.
+enum class LogEvent : uint8_t {
+    VEHICLES_ADVANCED,       // system_time_ms, time_ms
+    TRIPS_GENERATED,         // system_time_ms, num_trips
+    TRIP_REQUESTED,          // trip_id, request_time_ms, origin lon/lat, destination lon/lat
+    TRIPS_DISPATCHING,       // system_time_ms, num_trips
+    DATALOG_WRITTEN,         // system_time_ms
+    TRIP_PICKED_UP,          // system_time_ms, vehicle_id, trip_id
+    TRIP_DROPPED_OFF,        // system_time_ms, vehicle_id, trip_id
+    INSERTION_STARTED,       // (none)
+    ZONED_INSERTION_STARTED, // (none)
+    ZONES_DISPATCHED,        // num_trips, num_zones, num_border_trips, num_unassigned_trips
+    BATCH_SCORING_STARTED,   // (none)
+    TRIP_ASSIGNED,           // trip_id, vehicle_id, num_waypoints
+    TRIP_ASSIGNED_BY_SCORE,  // trip_id, vehicle_id, rank, score
+    TRIP_UNASSIGNED,         // trip_id
+};
+
+/// \brief The field of a log record, whose type is implied by the event.
+/// \details Integers are stored as uint64_t, and floating points as they are.
+union LogField {
+    LogField() : u(0) {}
+
+    template <typename T> LogField(T value) {
+        static_assert(std::is_arithmetic_v<T>, "Log fields must be arithmetic!");
+
+        if constexpr (std::is_same_v<T, float>) {
+            f = value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            d = value;
+        } else {
+            u = static_cast<uint64_t>(value);
+        }
+    }
+
+    uint64_t u;
+    double d;
+    float f;
+};
+
+/// \brief The max number of fields of a log record.
+constexpr size_t kMaxLogFields = 6;
+
+/// \brief The log record of an event with its structured fields, formatted by the sink only.
+struct LogRecord {
+    LogLevel level = LogLevel::DEBUG;
+    LogEvent event = LogEvent::VEHICLES_ADVANCED;
+    std::array<LogField, kMaxLogFields> fields = {};
+};
+
+/// \brief Format the log record and write it as one line into the file.
+void write_log_record(std::FILE *file, const LogRecord &record);
+
+/// \brief The asynchronous logger that writes the log records on a background sink thread.
+/// \details Each thread that logs pushes its records into its own SPSC ring buffer, created on its
+/// first record, which the sink thread drains into stdout. The records of each thread are written
+/// in order. If the ring buffer is full, the thread yields until the sink catches up, so that no
+/// record is dropped. The sink thread is only started by the first record, and sleeps until a
+/// producer wakes it up, so a run that logs nothing has no sink thread to pay for.
+class Logger {
+  public:
+    /// \brief Get the logger shared by all threads.
+    static Logger &get_instance();
+
+    /// \brief Destructor that writes all pending records and stops the sink thread.
+    ~Logger();
+
+    /// \brief Push the record to be written by the sink thread.
+    void push(const LogRecord &record);
+
+    /// \brief Wait until all records pushed so far are written.
+    void flush();
+
+  private:
+    /// \brief The capacity of the ring buffer of each thread.
+    static constexpr size_t kRingBufferCapacity = 1024;
+
+    using RingBuffer = SpscRingBuffer<LogRecord, kRingBufferCapacity>;
+
+    Logger() = default;
+
+    /// \brief Create the ring buffer of the calling thread and register it to the sink, which is
+    /// started along with the first ring buffer.
+    std::shared_ptr<RingBuffer> create_ring_buffer();
+
+    /// \brief The main loop of the sink thread.
+    void run();
+
+    /// \brief Write the records in all ring buffers, and drop those of the exited threads.
+    /// \return the number of records written.
+    size_t drain_ring_buffers();
+
+    /// \brief The mutex that guards the list of ring buffers and the states below.
+    std::mutex mutex_;
+
+    /// \brief The condition variable that wakes up the sink thread.
+    std::condition_variable condition_variable_;
+
+    /// \brief The ring buffers of all threads that have logged.
+    std::vector<std::shared_ptr<RingBuffer>> ring_buffers_ = {};
+
+    /// \brief The number of records pushed but not written yet.
+    std::atomic<size_t> num_pending_records_{0};
+
+    /// \brief True if the sink thread is waiting on the condition variable, or is about to.
+    /// \details The producers only take the mutex to wake the sink up when this is set.
+    std::atomic<bool> sink_waiting_{false};
+
+    /// \brief True if the logger is being destroyed.
+    bool stopping_ = false;
+
+    /// \brief The sink thread, started by the first record.
+    std::thread sink_thread_;
+};
+
+/// \brief Log the event with its fields, which costs nothing if the level is not compiled in.
+template <LogLevel level, typename... Fields> void log_event(LogEvent event, Fields... fields) {
+    if constexpr (level >= kMinLogLevel) {
+        static_assert(sizeof...(Fields) <= kMaxLogFields, "Too many fields in the log record!");
+        Logger::get_instance().push(LogRecord{level, event, {LogField{fields}...}});
+    }
+}
+
+/// \brief Wait until all log records so far are written, e.g. before printing to stdout directly.
+inline void flush_log() { Logger::get_instance().flush(); }
@@ -5,53 +5,116 @@
 #include "demand_generator.hpp"
 #include "platform.hpp"
 #include "router.hpp"
+#include "trip_replayer.hpp"
 #include "types.hpp"
 
 #include <cstddef>
 #include <cstdlib>
 #include <fmt/format.h>
+#include <string>
+#include <thread>
+#include <vector>
 #include <yaml-cpp/yaml.h>
 
+namespace {
+
+/// \brief Run the simulation with the platform config, the router and the demand source.
+/// \param path_to_checkpoint_to_load The checkpoint to resume from, start from scratch if empty.
+/// \param path_to_checkpoint_to_save The checkpoint to save once the warm-up is done, if not empty.
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void run_simulation(PlatformConfig platform_config,
+                    RouterFunc router_func,
+                    DemandGeneratorFunc demand_generator_func,
+                    const std::string &path_to_checkpoint_to_load,
+                    const std::string &path_to_checkpoint_to_save) {
+    Platform<RouterFunc, DemandGeneratorFunc> platform{
+        std::move(platform_config), std::move(router_func), std::move(demand_generator_func)};
+
+    if (!path_to_checkpoint_to_load.empty()) {
+        platform.load_checkpoint(path_to_checkpoint_to_load);
+    }
+
+    platform.run_simulation(path_to_checkpoint_to_save);
+}
+
+} // namespace
+
 int main(int argc, const char *argv[]) {
+    // Separate the optional flags from the positional arguments.
+    std::vector<std::string> args;
+    std::string path_to_checkpoint_to_load;
+    std::string path_to_checkpoint_to_save;
+
+    for (auto i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+
+        if (arg == "--load-checkpoint" && i + 1 < argc) {
+            path_to_checkpoint_to_load = argv[++i];
+        } else if (arg == "--save-checkpoint" && i + 1 < argc) {
+            path_to_checkpoint_to_save = argv[++i];
+        } else {
+            args.emplace_back(arg);
+        }
+    }
+
     // Check the input arugment list.
-    if (argc < 4 || argc > 5) {
+    if (args.size() < 3 || args.size() > 4) {
         fmt::print(stderr,
-                   "[ERROR] We need 3 or 4 arguments aside from the program name for correct "
-                   "execution! \n"
-                   "- Usage: <prog name> <arg1> <arg2> <arg3> <arg4>. \n"
+                   "[ERROR] We need 3 or 4 arguments aside from the program name and the flags for "
+                   "correct execution! \n"
+                   "- Usage: <prog name> <arg1> <arg2> <arg3> <arg4> [flags]. \n"
                    "  <arg1> is the path to the platform config file. \n"
                    "  <arg2> is the path to the orsm map data. \n"
-                   "  <arg3> is the path to the demand config file. \n"
+                   "  <arg3> is the path to the demand config file, or to a binary trip file "
+                   "(*.trips) to be replayed. \n"
                    "  <arg4> is the seed (unsigned int) to the random number generator. If not "
-                   "provided, rand() "
-                   "will use the current time as seed.\n"
+                   "provided, the current time will be used as seed.\n"
+                   "- Flags: \n"
+                   "  --save-checkpoint <path> saves the simulation state to the checkpoint once "
+                   "the warm-up is done. \n"
+                   "  --load-checkpoint <path> resumes the simulation from the checkpoint, which "
+                   "restores the seed as well. \n"
                    "- Example: {} \"./config/platform_demo.yml\" \"../osrm/map/hongkong.osrm\" "
                    "\"./config/demand_demo.yml\" 1\n",
                    argv[0]);
         return -1;
     }
 
-    // Seed the random number generator.
-    if (argc == 5) {
-        srand(std::stoi(argv[4]));
-    } else {
-        srand(time(0));
-    }
+    // Get the seed of the random number generator.
+    const uint64_t seed = args.size() == 4 ? std::stoull(args[3]) : time(0);
+
+    // Load the platform config from file.
+    auto platform_config = load_platform_config(args[0]);
 
-    // Initiate the router with the osrm data.
-    Router router{argv[2]};
+    // Initiate the router with the osrm data, simplifying the routes as configured.
+    Router router{args[1], platform_config.simulation_config.route_simplification_m};
 
-    // Create the demand generator based on the input demand file.
-    DemandGenerator demand_generator{argv[3]};
+    // Replay the recorded trips if a binary trip file is given.
+    const auto &path_to_demand = args[2];
+    const std::string trip_file_extension = ".trips";
 
-    // Create the simulation platform with the config loaded from file.
-    auto platform_config = load_platform_config(argv[1]);
+    if (path_to_demand.size() > trip_file_extension.size() &&
+        path_to_demand.compare(path_to_demand.size() - trip_file_extension.size(),
+                               trip_file_extension.size(),
+                               trip_file_extension) == 0) {
+        TripReplayer trip_replayer{path_to_demand};
+        run_simulation(std::move(platform_config),
+                       std::move(router),
+                       std::move(trip_replayer),
+                       path_to_checkpoint_to_load,
+                       path_to_checkpoint_to_save);
 
-    Platform<decltype(router), decltype(demand_generator)> platform{
-        std::move(platform_config), std::move(router), std::move(demand_generator)};
+        return 0;
+    }
 
-    // Run simulation.
-    platform.run_simulation();
+    // Otherwise create the demand generator based on the input demand file. The generated requests
+    // only depend on the seed, not on the number of threads.
+    DemandGenerator demand_generator{path_to_demand, seed, 0, std::thread::hardware_concurrency()};
+    run_simulation(std::move(platform_config),
+                   std::move(router),
+                   std::move(demand_generator),
+                   path_to_checkpoint_to_load,
+                   path_to_checkpoint_to_save);
 
     return 0;
 }
@@ -0,0 +1,105 @@
+/// \author Jian Wen
+/// \date 2021/03/04
+
+#include "memory.hpp"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+
+void update_peak_memory_usage(MemoryUsage &peak_usage, const MemoryUsage &usage) {
+    peak_usage.route_bytes = std::max(peak_usage.route_bytes, usage.route_bytes);
+    peak_usage.trip_count = std::max(peak_usage.trip_count, usage.trip_count);
+    peak_usage.trip_bytes = std::max(peak_usage.trip_bytes, usage.trip_bytes);
+    peak_usage.datalog_bytes = std::max(peak_usage.datalog_bytes, usage.datalog_bytes);
+    peak_usage.rss_bytes = std::max(peak_usage.rss_bytes, usage.rss_bytes);
+}
+
+size_t get_heap_bytes(const Route &route) {
+    auto bytes = get_heap_bytes(route.legs) + get_heap_bytes(route.poses) +
+                 get_heap_bytes(route.time_offsets_ms) + get_heap_bytes(route.distance_offsets_mm);
+
+    for (const auto &leg : route.legs) {
+        bytes += get_heap_bytes(leg.steps);
+
+        for (const auto &step : leg.steps) {
+            bytes += get_heap_bytes(step.poses);
+        }
+    }
+
+    return bytes;
+}
+
+size_t get_route_heap_bytes(const std::vector<Vehicle> &vehicles) {
+    size_t bytes = 0;
+
+    for (const auto &vehicle : vehicles) {
+        bytes += get_heap_bytes(vehicle.waypoints);
+
+        for (const auto &waypoint : vehicle.waypoints) {
+            bytes += get_heap_bytes(waypoint.route);
+        }
+    }
+
+    return bytes;
+}
+
+size_t get_resident_bytes() {
+#if defined(__linux__)
+    // The second field of statm is the number of resident pages.
+    auto file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+
+    size_t num_pages = 0;
+    size_t num_resident_pages = 0;
+    const auto num_fields = std::fscanf(file, "%zu %zu", &num_pages, &num_resident_pages);
+    std::fclose(file);
+
+    return num_fields == 2 ? num_resident_pages * sysconf(_SC_PAGESIZE) : 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(),
+                  MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info),
+                  &count) != KERN_SUCCESS) {
+        return 0;
+    }
+
+    return info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+void release_free_heap_memory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+size_t get_peak_resident_bytes() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    // The peak is in bytes on macOS, and in kilobytes elsewhere.
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024;
+#endif
+}
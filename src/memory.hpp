@@ -0,0 +1,51 @@
+/// \author Jian Wen
+/// \date 2021/03/04
+
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+/// \brief The memory held by each subsystem of the simulation, in bytes.
+struct MemoryUsage {
+    size_t route_bytes = 0;   // the geometry of the routes planned for the vehicles
+    size_t trip_count = 0;    // the number of trips held, including those no longer active
+    size_t trip_bytes = 0;    // the trips
+    size_t datalog_bytes = 0; // the frame buffers and encoder states of the datalog
+    size_t rss_bytes = 0;     // the resident set size of the whole process
+};
+
+/// \brief Raise each field of the peak usage to the usage, if higher.
+void update_peak_memory_usage(MemoryUsage &peak_usage, const MemoryUsage &usage);
+
+/// \brief Get the bytes allocated by the vector, including the reserved capacity.
+template <typename T> size_t get_heap_bytes(const std::vector<T> &vector) {
+    return vector.capacity() * sizeof(T);
+}
+
+/// \brief Get the bytes allocated by the deque, counting its blocks as a whole. The blocks follow
+/// libstdc++ (512 bytes, or one value if larger), so the bytes are an estimate elsewhere.
+template <typename T> size_t get_heap_bytes(const std::deque<T> &deque) {
+    const auto num_values_per_block = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    return (deque.size() / num_values_per_block + 1) * num_values_per_block * sizeof(T);
+}
+
+/// \brief Get the bytes allocated by the route, i.e. its legs and its flattened polyline.
+size_t get_heap_bytes(const Route &route);
+
+/// \brief Get the bytes allocated by the routes of all waypoints of the vehicles.
+size_t get_route_heap_bytes(const std::vector<Vehicle> &vehicles);
+
+/// \brief Get the current resident set size of the process, 0 if not supported on the platform.
+size_t get_resident_bytes();
+
+/// \brief Return the free heap memory kept by the allocator to the OS where supported (glibc), so
+/// that the resident set size only counts the memory in use before a measured run.
+void release_free_heap_memory();
+
+/// \brief Get the peak resident set size of the process since it started, 0 if not supported.
+/// \details The OS may update the peak lazily, so it can lag slightly behind the current size.
+size_t get_peak_resident_bytes();
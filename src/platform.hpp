@@ -4,12 +4,43 @@
 #pragma once
 
 #include "config.hpp"
+#include "datalog.hpp"
+#include "fleet.hpp"
+#include "kpi.hpp"
+#include "memory.hpp"
+#include "serialization.hpp"
+#include "thread_pool.hpp"
 #include "types.hpp"
 #include "vehicle.hpp"
 
 #include <chrono>
 #include <ctime>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+
+/// \brief The magic number at the beginning of a checkpoint file.
+constexpr char kCheckpointMagic[8] = {'M', 'O', 'D', 'C', 'K', 'P', 'T', '\0'};
+
+/// \brief The version of the checkpoint file format.
+constexpr uint32_t kCheckpointVersion = 2;
+
+/// \brief The header of a checkpoint file, followed by the simulation state.
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version = kCheckpointVersion;
+    uint32_t reserved = 0;
+    uint64_t num_vehicles = 0;
+    uint64_t cycle_ms = 0;
+};
+
+/// \brief Get the wall-clock time elapsed since the start in seconds.
+inline double get_elapsed_s(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
 /// \brief The agent-based modeling platform that simulates the mobility-on-demand system.
 template <typename RouterFunc, typename DemandGeneratorFunc> class Platform {
@@ -29,26 +60,95 @@ template <typename RouterFunc, typename DemandGeneratorFunc> class Platform {
     Platform &operator=(Platform &&other) = delete;
 
     /// \brief Run simulation. The master function that manages the entire simulation process.
-    void run_simulation();
+    /// \param path_to_checkpoint The path to save the checkpoint once the warm-up is done, so that
+    /// other runs can skip the warm-up. No checkpoint is saved if empty.
+    /// \return The report of the key performance indicators.
+    SimulationReport run_simulation(const std::string &path_to_checkpoint = "");
+
+    /// \brief Save the full simulation state into a binary checkpoint, i.e. the system time, the
+    /// trips, the vehicles with their waypoints and routes, and the state of the demand generator.
+    /// \details The DemandGeneratorFunc must provide save_state() and load_state() to checkpoint.
+    void save_checkpoint(const std::string &path_to_checkpoint) const;
+
+    /// \brief Restore the full simulation state from a binary checkpoint, which must be saved with
+    /// the same fleet size and cycle. The simulation then resumes from the time of the checkpoint.
+    void load_checkpoint(const std::string &path_to_checkpoint);
+
+    /// \brief Get the KPIs accumulated so far, e.g. to be merged with the other replications.
+    const KpiAccumulator &get_kpi_accumulator() const { return kpi_accumulator_; }
+
+    /// \brief Get the peak memory held by each subsystem, as sampled at the end of each cycle.
+    const MemoryUsage &get_peak_memory_usage() const { return peak_memory_usage_; }
+
+    /// \brief Start the next cycle, i.e. advance the vehicles and generate the trips requested
+    /// during the cycle. The cycle must then be finished by either dispatch_pending_trips() or
+    /// assign_pending_trips(). Together they step the simulation for an external dispatcher.
+    /// \return The ids of the pending trips to be dispatched in this cycle.
+    const std::vector<size_t> &start_cycle();
+
+    /// \brief Dispatch the pending trips through the insertion heuristics, and finish the cycle.
+    void dispatch_pending_trips();
+
+    /// \brief Assign the pending trips to the given vehicles, and finish the cycle.
+    /// \details Each trip is inserted into its vehicle at the positions of least additional cost,
+    /// if the vehicle could serve it. The pending trips not assigned walk away.
+    /// \param trip_ids The ids of the pending trips to assign, each at most once.
+    /// \param vehicle_ids The id of the vehicle to assign each trip to.
+    /// \return The number of trips inserted.
+    size_t assign_pending_trips(const std::vector<size_t> &trip_ids,
+                                const std::vector<size_t> &vehicle_ids);
+
+    /// \brief True if the simulation has reached the shutdown time.
+    bool is_done() const { return system_time_ms_ >= system_shutdown_time_ms_; }
+
+    /// \brief Get the system time in milliseconds.
+    uint64_t get_system_time_ms() const { return system_time_ms_; }
+
+    /// \brief Get all trips created so far, indexed by trip id.
+    const std::vector<Trip> &get_trips() const { return trips_; }
+
+    /// \brief Get the vehicles, indexed by vehicle id.
+    const std::vector<Vehicle> &get_vehicles() const { return vehicles_; }
+
+    /// \brief Bring all vehicles up to the system time, and get their hot states.
+    const FleetState &observe_fleet_state();
 
   private:
     /// \brief Run simulation for one cycle. Invoked repetetively by run_simulation().
     void run_cycle();
 
+    /// \brief Finish the cycle after the pending trips are dispatched.
+    void finish_cycle();
+
     /// \brief Advance all vehicles for the given time and move forward the system time.
     void advance_vehicles(uint64_t time_ms);
 
+    /// \brief Process the waypoint arrivals until the target time (event-driven mode only).
+    /// \details Only the vehicles that reach a waypoint by the target time are advanced, each up
+    /// to the time of its arrival. All the other vehicles are left behind until synced.
+    void process_arrival_events(uint64_t target_time_ms);
+
+    /// \brief Advance all moving vehicles to the current system time (event-driven mode only).
+    /// \details Invoked whenever the up-to-date vehicle states are needed, e.g. for dispatch.
+    void sync_vehicles();
+
+    /// \brief Schedule the next waypoint arrivals of vehicles whose plans changed.
+    void schedule_arrival_events();
+
     /// \brief Generate trips at the end of each cycle.
     std::vector<size_t> generate_trips();
 
     /// \brief Dispatch vehicles to serve pending trips.
     void dispatch(const std::vector<size_t> &pending_trip_ids);
 
-    /// \brief Write the data of the current simulation state to datalog.
+    /// \brief Capture the current simulation state and submit it to the datalog writer.
     void write_to_datalog();
 
+    /// \brief Sample the memory held by each subsystem, and raise the peaks accordingly.
+    void sample_memory_usage();
+
     /// \brief Create the report based on the statistical analysis using the simulated data.
-    void create_report(double total_runtime_s);
+    SimulationReport create_report(double total_runtime_s);
 
     /// \brief The set of config parameters for the simulation platform.
     PlatformConfig platform_config_;
@@ -80,11 +180,55 @@ template <typename RouterFunc, typename DemandGeneratorFunc> class Platform {
     /// \brief The vector of trips created during the entire simulation process.
     std::vector<Trip> trips_ = {};
 
+    /// \brief The ids of the trips generated in the current cycle and yet to be dispatched.
+    std::vector<size_t> pending_trip_ids_ = {};
+
     /// \brief The vector of vehicles.
     std::vector<Vehicle> vehicles_ = {};
 
-    /// \brief The ofstream that outputs to the datalog.
-    std::ofstream datalog_ofstream_;
+    /// \brief The hot states of the vehicles in structure of arrays, refreshed before dispatch.
+    FleetState fleet_state_;
+
+    /// \brief The time to which each vehicle has been advanced (event-driven mode only).
+    std::vector<uint64_t> vehicle_time_ms_ = {};
+
+    /// \brief The time each vehicle reaches its next waypoint, max if idle (event-driven mode).
+    std::vector<uint64_t> next_arrival_time_ms_ = {};
+
+    /// \brief The min-heap of waypoint arrival events as pairs of time and vehicle id.
+    /// \details Events outdated by dispatch are not removed but skipped when popped.
+    std::priority_queue<std::pair<uint64_t, size_t>,
+                        std::vector<std::pair<uint64_t, size_t>>,
+                        std::greater<std::pair<uint64_t, size_t>>>
+        arrival_events_;
+
+    /// \brief True if the vehicle statistics are being updated, aka. in the main simulation.
+    bool update_vehicle_stats_ = false;
+
+    /// \brief The key performance indicators accumulated as the simulation runs.
+    KpiAccumulator kpi_accumulator_;
+
+    // The wall-clock runtime of each phase of the simulation so far, in seconds. The vehicles
+    // synced by other phases in event-driven mode count towards advancing the vehicles.
+    double advance_runtime_s_ = 0.0;
+    double demand_runtime_s_ = 0.0;
+    double dispatch_runtime_s_ = 0.0;
+    double datalog_runtime_s_ = 0.0;
+
+    /// \brief The peak memory held by each subsystem so far.
+    MemoryUsage peak_memory_usage_ = {};
+
+    /// \brief The resident set size of the process when the platform was created.
+    size_t start_rss_bytes_ = 0;
+
+    /// \brief The threads dispatching the zones in parallel if the area is partitioned.
+    std::unique_ptr<ThreadPool> dispatch_thread_pool_;
+
+    /// \brief The datalog writer that outputs to the datalog on a separate thread.
+    std::unique_ptr<DatalogWriter> datalog_writer_;
+
+    /// \brief The encoder of the datalog frames if delta encoded.
+    DatalogDeltaEncoder datalog_delta_encoder_;
 };
 
 // Implementation is put in a separate file for clarity and maintainability.
@@ -4,16 +4,25 @@
 #pragma once
 
 #include "dispatch.hpp"
+#include "logger.hpp"
 #include "platform.hpp"
+#include "tracer.hpp"
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <cstring>
+
 template <typename RouterFunc, typename DemandGeneratorFunc>
 Platform<RouterFunc, DemandGeneratorFunc>::Platform(PlatformConfig _platform_config,
                                                     RouterFunc _router_func,
                                                     DemandGeneratorFunc _demand_generator_func)
     : platform_config_(std::move(_platform_config)), router_func_(std::move(_router_func)),
       demand_generator_func_(std::move(_demand_generator_func)) {
+    // Record the memory the process held before this platform, e.g. the router map or the platforms
+    // run earlier in the same process.
+    start_rss_bytes_ = get_resident_bytes();
+
     // Initialize the fleet.
     const auto &fleet_config = platform_config_.mod_system_config.fleet_config;
     Vehicle vehicle{0,
@@ -27,6 +36,9 @@ Platform<RouterFunc, DemandGeneratorFunc>::Platform(PlatformConfig _platform_con
         vehicle.id = i;
         vehicles_.emplace_back(vehicle);
     }
+    sync_fleet_state(fleet_state_, vehicles_, system_time_ms_);
+    vehicle_time_ms_.assign(vehicles_.size(), 0);
+    next_arrival_time_ms_.assign(vehicles_.size(), std::numeric_limits<uint64_t>::max());
 
     // Initialize the simulation times.
     system_time_ms_ = 0;
@@ -47,53 +59,187 @@ Platform<RouterFunc, DemandGeneratorFunc>::Platform(PlatformConfig _platform_con
         main_sim_end_time_ms_ +
         static_cast<uint64_t>(platform_config_.simulation_config.winddown_duration_s * 1000);
 
+    // Initialize the KPIs, which are accumulated over the main simulation.
+    kpi_accumulator_ =
+        KpiAccumulator{main_sim_start_time_ms_, main_sim_end_time_ms_, vehicles_.size()};
+
+    // Start the threads dispatching the zones once, to be reused by every dispatch.
+    const auto &dispatch_config = platform_config_.mod_system_config.dispatch_config;
+    if (dispatch_config.num_zone_cols * dispatch_config.num_zone_rows > 1) {
+        dispatch_thread_pool_ = std::make_unique<ThreadPool>(dispatch_config.num_threads);
+    }
+
     // Open the output datalog file.
     const auto &datalog_config = platform_config_.output_config.datalog_config;
     if (datalog_config.output_datalog) {
-        datalog_ofstream_.open(datalog_config.path_to_output_datalog);
+        datalog_writer_ = std::make_unique<DatalogWriter>(datalog_config.path_to_output_datalog,
+                                                          datalog_config.binary,
+                                                          datalog_config.compression,
+                                                          datalog_config.compression_level);
 
         fmt::print("[INFO] Opened the output datalog file at {}.\n",
                    datalog_config.path_to_output_datalog);
     }
+
+    // Start tracing the phases of the simulation. Only one platform in the process can be traced.
+    if (platform_config_.output_config.trace_config.output_trace) {
+        Tracer::get_instance().start();
+
+        fmt::print("[INFO] Started tracing the simulation phases.\n");
+    }
 }
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
 Platform<RouterFunc, DemandGeneratorFunc>::~Platform() {
-    // Close the datalog stream.
-    if (datalog_ofstream_.is_open()) {
-        datalog_ofstream_.close();
+    // Close the datalog once all frames are written.
+    if (datalog_writer_) {
+        datalog_writer_.reset();
 
         fmt::print("[INFO] Closed the datalog. Program ends.\n");
     }
+
+    // Write the trace once the datalog writer thread, which traces as well, has been joined.
+    const auto &trace_config = platform_config_.output_config.trace_config;
+    if (trace_config.output_trace) {
+        Tracer::get_instance().stop();
+        Tracer::get_instance().write_trace(trace_config.path_to_output_trace);
+
+        fmt::print("[INFO] Wrote the trace to {}.\n", trace_config.path_to_output_trace);
+    }
 }
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
-void Platform<RouterFunc, DemandGeneratorFunc>::run_simulation() {
+SimulationReport
+Platform<RouterFunc, DemandGeneratorFunc>::run_simulation(const std::string &path_to_checkpoint) {
     fmt::print("[INFO] Simulation started. Running for total {} seconds.\n",
                system_shutdown_time_ms_ / 1000.0);
     auto start = std::chrono::system_clock::now();
 
-    // Run simulation cycle by cycle.
+    // Run simulation cycle by cycle. The checkpoint is saved before the first cycle of the main
+    // simulation.
+    auto checkpoint_saved = path_to_checkpoint.empty();
+
     while (system_time_ms_ < system_shutdown_time_ms_) {
+        if (!checkpoint_saved && system_time_ms_ >= main_sim_start_time_ms_) {
+            save_checkpoint(path_to_checkpoint);
+            checkpoint_saved = true;
+        }
+
         run_cycle();
     }
+    sync_vehicles();
 
     // Create report.
     std::chrono::duration<double> runtime = std::chrono::system_clock::now() - start;
+    flush_log();
     fmt::print("[INFO] Simulation completed. Creating report.\n");
-    create_report(runtime.count());
 
-    return;
+    return create_report(runtime.count());
 };
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
-void Platform<RouterFunc, DemandGeneratorFunc>::run_cycle() {
-    fmt::print("[INFO] T = {}s: Cycle {} is running.\n",
+void Platform<RouterFunc, DemandGeneratorFunc>::save_checkpoint(
+    const std::string &path_to_checkpoint) const {
+    std::ofstream out{path_to_checkpoint, std::ios::binary};
+    assert(out && "[ERROR] Failed to create the checkpoint file!");
+
+    CheckpointHeader header;
+    std::memcpy(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+    header.num_vehicles = vehicles_.size();
+    header.cycle_ms = cycle_ms_;
+    write_binary(out, header);
+
+    // The vehicles left behind in event-driven mode are saved as is, together with their arrival
+    // times, so that the simulation resumes exactly as if it had not been interrupted.
+    write_binary(out, system_time_ms_);
+    write_binary(out, trips_);
+    write_binary(out, vehicles_);
+    write_binary(out, vehicle_time_ms_);
+    write_binary(out, next_arrival_time_ms_);
+    write_binary(out, update_vehicle_stats_);
+    kpi_accumulator_.save_state(out);
+    demand_generator_func_.save_state(out);
+
+    fmt::print("[INFO] Saved the checkpoint at T = {}s to {}.\n",
+               system_time_ms_ / 1000.0,
+               path_to_checkpoint);
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::load_checkpoint(
+    const std::string &path_to_checkpoint) {
+    std::ifstream in{path_to_checkpoint, std::ios::binary};
+    assert(in && "[ERROR] Failed to open the checkpoint file!");
+
+    CheckpointHeader header;
+    read_binary(in, header);
+    assert(std::memcmp(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) == 0 &&
+           header.version == kCheckpointVersion &&
+           "[ERROR] The file is not a checkpoint of a supported version!");
+    assert(header.num_vehicles == vehicles_.size() && header.cycle_ms == cycle_ms_ &&
+           "[ERROR] The checkpoint must be saved with the same fleet size and cycle!");
+
+    read_binary(in, system_time_ms_);
+    read_binary(in, trips_);
+    read_binary(in, vehicles_);
+    read_binary(in, vehicle_time_ms_);
+    read_binary(in, next_arrival_time_ms_);
+    read_binary(in, update_vehicle_stats_);
+    kpi_accumulator_.load_state(in);
+    demand_generator_func_.load_state(in);
+    assert(in && "[ERROR] The checkpoint file is truncated!");
+
+    // Rebuild the states derived from the vehicles.
+    arrival_events_ = {};
+    for (auto i = 0; i < vehicles_.size(); i++) {
+        if (next_arrival_time_ms_[i] != std::numeric_limits<uint64_t>::max()) {
+            arrival_events_.emplace(next_arrival_time_ms_[i], i);
+        }
+    }
+    sync_fleet_state(fleet_state_, vehicles_, system_time_ms_);
+
+    fmt::print("[INFO] Loaded the checkpoint at T = {}s from {}.\n",
                system_time_ms_ / 1000.0,
-               system_time_ms_ / cycle_ms_);
+               path_to_checkpoint);
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::run_cycle() {
+    TraceSpan span{"cycle"};
 
-    // Advance the vehicles frame by frame in main simulation.
-    if (system_time_ms_ >= main_sim_start_time_ms_ && system_time_ms_ < main_sim_end_time_ms_) {
+    start_cycle();
+    dispatch_pending_trips();
+
+    return;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+const std::vector<size_t> &Platform<RouterFunc, DemandGeneratorFunc>::start_cycle() {
+    assert(!is_done() && "[ERROR] The simulation has already reached the shutdown time!");
+
+    // Keep the logs of the previous cycle ahead of the output below.
+    flush_log();
+    if (platform_config_.output_config.print_cycles) {
+        fmt::print("[INFO] T = {}s: Cycle {} is running.\n",
+                   system_time_ms_ / 1000.0,
+                   system_time_ms_ / cycle_ms_);
+    }
+
+    const auto in_main_sim =
+        system_time_ms_ >= main_sim_start_time_ms_ && system_time_ms_ < main_sim_end_time_ms_;
+    const auto event_driven = platform_config_.simulation_config.event_driven;
+
+    // Vehicles left behind in event-driven mode are synced before the main simulation starts or
+    // ends, so that the vehicle statistics are updated for exactly the main simulation.
+    if (in_main_sim != update_vehicle_stats_) {
+        sync_vehicles();
+        update_vehicle_stats_ = in_main_sim;
+    }
+
+    // Advance the vehicles frame by frame in main simulation. Frames are only needed for the
+    // datalog in event-driven mode.
+    if (in_main_sim &&
+        (!event_driven || platform_config_.output_config.datalog_config.output_datalog)) {
         for (auto ms = 0; ms < cycle_ms_; ms += frame_ms_) {
             advance_vehicles(frame_ms_);
 
@@ -109,48 +255,209 @@ void Platform<RouterFunc, DemandGeneratorFunc>::run_cycle() {
     }
 
     // Generate trips.
-    const auto pending_trip_ids = generate_trips();
+    pending_trip_ids_ = generate_trips();
+
+    return pending_trip_ids_;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::dispatch_pending_trips() {
+    dispatch(pending_trip_ids_);
+    finish_cycle();
+
+    return;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+size_t Platform<RouterFunc, DemandGeneratorFunc>::assign_pending_trips(
+    const std::vector<size_t> &trip_ids, const std::vector<size_t> &vehicle_ids) {
+    assert(trip_ids.size() == vehicle_ids.size() &&
+           "[ERROR] Each trip must be assigned to exactly one vehicle!");
+
+    sync_vehicles();
+    const auto start = std::chrono::steady_clock::now();
+    TraceSpan span{"dispatch"};
+    TracedRouterFunc<RouterFunc> traced_router_func{router_func_};
+
+    size_t num_inserted_trips = 0;
+    for (auto i = 0; i < trip_ids.size(); i++) {
+        auto &trip = trips_[trip_ids[i]];
+        assert(trip.status == TripStatus::REQUESTED &&
+               std::find(pending_trip_ids_.begin(), pending_trip_ids_.end(), trip.id) !=
+                   pending_trip_ids_.end() &&
+               "[ERROR] Only the pending trips of this cycle can be assigned, each at most once!");
+        assert(vehicle_ids[i] < vehicles_.size() && "[ERROR] The vehicle id is out of range!");
+
+        num_inserted_trips += insert_trip_to_best_candidate_vehicle(
+            trip, trips_, vehicles_, {vehicle_ids[i]}, system_time_ms_, traced_router_func);
+    }
 
-    // Dispatch the pending trips.
-    dispatch(pending_trip_ids);
+    for (auto trip_id : pending_trip_ids_) {
+        auto &trip = trips_[trip_id];
+        if (trip.status == TripStatus::REQUESTED) {
+            trip.status = TripStatus::WALKAWAY;
+            log_event<LogLevel::DEBUG>(LogEvent::TRIP_UNASSIGNED, trip.id);
+        }
+
+        kpi_accumulator_.record_dispatch(trip);
+    }
+    schedule_arrival_events();
+    dispatch_runtime_s_ += get_elapsed_s(start);
+
+    finish_cycle();
+
+    return num_inserted_trips;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+const FleetState &Platform<RouterFunc, DemandGeneratorFunc>::observe_fleet_state() {
+    sync_vehicles();
+    sync_fleet_state(fleet_state_, vehicles_, system_time_ms_);
+
+    return fleet_state_;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::finish_cycle() {
+    pending_trip_ids_.clear();
 
     if (system_time_ms_ > main_sim_start_time_ms_ && system_time_ms_ <= main_sim_end_time_ms_ &&
         platform_config_.output_config.datalog_config.output_datalog) {
         write_to_datalog();
     }
+    sample_memory_usage();
 
     return;
 }
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
 void Platform<RouterFunc, DemandGeneratorFunc>::advance_vehicles(uint64_t time_ms) {
-    // Do it for each of the vehicles independently.
-    for (auto &vehicle : vehicles_) {
-        advance_vehicle(vehicle,
-                        trips_,
-                        system_time_ms_,
-                        time_ms,
-                        system_time_ms_ >= main_sim_start_time_ms_ &&
-                            system_time_ms_ < main_sim_end_time_ms_);
+    const auto start = std::chrono::steady_clock::now();
+    TraceSpan span{"advance_vehicles"};
+
+    if (platform_config_.simulation_config.event_driven) {
+        // Only advance the vehicles that reach their next waypoints.
+        process_arrival_events(system_time_ms_ + time_ms);
+    } else {
+        // Do it for each of the vehicles independently.
+        for (auto &vehicle : vehicles_) {
+            advance_vehicle(vehicle,
+                            trips_,
+                            system_time_ms_,
+                            time_ms,
+                            system_time_ms_ >= main_sim_start_time_ms_ &&
+                                system_time_ms_ < main_sim_end_time_ms_,
+                            &kpi_accumulator_);
+        }
     }
 
     // Increment the system time.
     system_time_ms_ += time_ms;
+    advance_runtime_s_ += get_elapsed_s(start);
 
-    fmt::print(
-        "[DEBUG] T = {}s: Advanced vehicles by {}s.\n", system_time_ms_ / 1000.0, time_ms / 1000.0);
+    log_event<LogLevel::DEBUG>(LogEvent::VEHICLES_ADVANCED, system_time_ms_, time_ms);
+
+    return;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::process_arrival_events(uint64_t target_time_ms) {
+    while (!arrival_events_.empty() && arrival_events_.top().first <= target_time_ms) {
+        const auto [arrival_time_ms, vehicle_id] = arrival_events_.top();
+        arrival_events_.pop();
+
+        // Skip the event if the vehicle has been rescheduled since.
+        if (arrival_time_ms != next_arrival_time_ms_[vehicle_id]) {
+            continue;
+        }
+
+        auto &vehicle = vehicles_[vehicle_id];
+        advance_vehicle(vehicle,
+                        trips_,
+                        vehicle_time_ms_[vehicle_id],
+                        arrival_time_ms - vehicle_time_ms_[vehicle_id],
+                        update_vehicle_stats_,
+                        &kpi_accumulator_);
+        vehicle_time_ms_[vehicle_id] = arrival_time_ms;
+
+        // Schedule the arrival at the following waypoint.
+        if (vehicle.waypoints.empty()) {
+            next_arrival_time_ms_[vehicle_id] = std::numeric_limits<uint64_t>::max();
+            continue;
+        }
+
+        assert(vehicle.waypoints.front().route.duration_ms > 0 &&
+               "Waypoints must take positive time to reach!");
+        next_arrival_time_ms_[vehicle_id] =
+            arrival_time_ms + vehicle.waypoints.front().route.duration_ms;
+        arrival_events_.emplace(next_arrival_time_ms_[vehicle_id], vehicle_id);
+    }
+
+    return;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::sync_vehicles() {
+    if (!platform_config_.simulation_config.event_driven) {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    TraceSpan span{"sync_vehicles"};
+
+    // Idle vehicles have nothing to do. Moving vehicles are interpolated along their routes.
+    for (auto &vehicle : vehicles_) {
+        auto &vehicle_time_ms = vehicle_time_ms_[vehicle.id];
+
+        if (!vehicle.waypoints.empty()) {
+            advance_vehicle(vehicle,
+                            trips_,
+                            vehicle_time_ms,
+                            system_time_ms_ - vehicle_time_ms,
+                            update_vehicle_stats_,
+                            &kpi_accumulator_);
+        }
+
+        vehicle_time_ms = system_time_ms_;
+    }
+    advance_runtime_s_ += get_elapsed_s(start);
+
+    return;
+}
+
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::schedule_arrival_events() {
+    if (!platform_config_.simulation_config.event_driven) {
+        return;
+    }
+
+    for (const auto &vehicle : vehicles_) {
+        const auto arrival_time_ms =
+            vehicle.waypoints.empty()
+                ? std::numeric_limits<uint64_t>::max()
+                : vehicle_time_ms_[vehicle.id] + vehicle.waypoints.front().route.duration_ms;
+
+        if (arrival_time_ms != next_arrival_time_ms_[vehicle.id]) {
+            next_arrival_time_ms_[vehicle.id] = arrival_time_ms;
+
+            if (!vehicle.waypoints.empty()) {
+                arrival_events_.emplace(arrival_time_ms, vehicle.id);
+            }
+        }
+    }
 
     return;
 }
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
 std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::generate_trips() {
+    const auto start = std::chrono::steady_clock::now();
+    TraceSpan span{"generate_trips"};
+
     // Get trip requests generated during the past cycle.
     auto requests = demand_generator_func_(system_time_ms_);
 
-    fmt::print("[DEBUG] T = {}s: Generated {} request(s) in this cycle:\n",
-               system_time_ms_ / 1000.0,
-               requests.size());
+    log_event<LogLevel::DEBUG>(LogEvent::TRIPS_GENERATED, system_time_ms_, requests.size());
 
     // Add the requests into the trip list as well as the pending trips.
     std::vector<size_t> pending_trip_ids;
@@ -180,18 +487,19 @@ std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::generate_trips()
             static_cast<uint64_t>(
                 platform_config_.mod_system_config.request_config.max_pickup_wait_time_s * 1000);
 
+        kpi_accumulator_.record_request(trip);
         pending_trip_ids.emplace_back(trips_.size());
         trips_.emplace_back(std::move(trip));
 
-        fmt::print("[DEBUG] Trip #{} requested at T = {}s, from origin ({}, {}) to destination "
-                   "({}, {}):\n",
-                   trip.id,
-                   trip.request_time_ms / 1000.0,
-                   trip.origin.lon,
-                   trip.origin.lat,
-                   trip.destination.lon,
-                   trip.destination.lat);
+        log_event<LogLevel::DEBUG>(LogEvent::TRIP_REQUESTED,
+                                   trip.id,
+                                   trip.request_time_ms,
+                                   trip.origin.lon,
+                                   trip.origin.lat,
+                                   trip.destination.lon,
+                                   trip.destination.lat);
     }
+    demand_runtime_s_ += get_elapsed_s(start);
 
     return pending_trip_ids;
 }
@@ -199,13 +507,48 @@ std::vector<size_t> Platform<RouterFunc, DemandGeneratorFunc>::generate_trips()
 template <typename RouterFunc, typename DemandGeneratorFunc>
 void Platform<RouterFunc, DemandGeneratorFunc>::dispatch(
     const std::vector<size_t> &pending_trip_ids) {
-    fmt::print("[DEBUG] T = {}s: Dispatching {} pending trip(s) to vehicles.\n",
-               system_time_ms_ / 1000.0,
-               pending_trip_ids.size());
+    log_event<LogLevel::DEBUG>(
+        LogEvent::TRIPS_DISPATCHING, system_time_ms_, pending_trip_ids.size());
 
-    // Assign pending trips to vehicles.
-    assign_trips_through_insertion_heuristics(
-        pending_trip_ids, trips_, vehicles_, system_time_ms_, router_func_);
+    // Nothing to dispatch in this cycle.
+    if (pending_trip_ids.empty()) {
+        return;
+    }
+
+    // Bring the vehicle states up to date.
+    sync_vehicles();
+    const auto start = std::chrono::steady_clock::now();
+    TraceSpan span{"dispatch"};
+    sync_fleet_state(fleet_state_, vehicles_, system_time_ms_);
+
+    // Route through the wrapper that tells the router time apart in the trace.
+    TracedRouterFunc<RouterFunc> traced_router_func{router_func_};
+
+    // Assign pending trips to vehicles, zone by zone if the area is partitioned.
+    const auto &dispatch_config = platform_config_.mod_system_config.dispatch_config;
+    if (dispatch_config.num_zone_cols * dispatch_config.num_zone_rows > 1) {
+        assign_trips_through_zoned_insertion_heuristics(
+            pending_trip_ids,
+            trips_,
+            vehicles_,
+            fleet_state_,
+            system_time_ms_,
+            traced_router_func,
+            ZoneGrid{platform_config_.area_config,
+                     dispatch_config.num_zone_cols,
+                     dispatch_config.num_zone_rows},
+            dispatch_config.zone_border_m,
+            *dispatch_thread_pool_);
+    } else {
+        assign_trips_through_insertion_heuristics(
+            pending_trip_ids, trips_, vehicles_, fleet_state_, system_time_ms_, traced_router_func);
+    }
+    schedule_arrival_events();
+
+    for (auto trip_id : pending_trip_ids) {
+        kpi_accumulator_.record_dispatch(trips_[trip_id]);
+    }
+    dispatch_runtime_s_ += get_elapsed_s(start);
 
     // Reoptimize the assignments for better level of service.
     // (TODO)
@@ -218,71 +561,47 @@ void Platform<RouterFunc, DemandGeneratorFunc>::dispatch(
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
 void Platform<RouterFunc, DemandGeneratorFunc>::write_to_datalog() {
-    YAML::Node node;
+    sync_vehicles();
+    const auto start = std::chrono::steady_clock::now();
+    TraceSpan span{"write_to_datalog"};
+
+    // Only the snapshot is captured here. The serialization and the output are done by the writer
+    // thread while the simulation moves on. The snapshot reads the vehicles rather than the fleet
+    // state, which is only refreshed at dispatch and does not hold the waypoint routes.
+    auto &frame = datalog_writer_->get_back_frame();
+    if (platform_config_.output_config.datalog_config.delta_encoded) {
+        datalog_delta_encoder_.capture(frame, system_time_ms_, vehicles_, trips_);
+    } else {
+        capture_datalog_frame(frame, system_time_ms_, vehicles_, trips_);
+    }
+    datalog_writer_->submit_back_frame();
+    datalog_runtime_s_ += get_elapsed_s(start);
 
-    node["system_time_ms"] = system_time_ms_;
+    log_event<LogLevel::DEBUG>(LogEvent::DATALOG_WRITTEN, system_time_ms_);
 
-    // For each of the vehicles, we write the relavant data in yaml format.
-    for (const auto &vehicle : vehicles_) {
-        YAML::Node veh_node;
-
-        YAML::Node pos_node;
-        pos_node["lon"] = fmt::format("{:.6f}", vehicle.pos.lon);
-        pos_node["lat"] = fmt::format("{:.6f}", vehicle.pos.lat);
-        veh_node["pos"] = std::move(pos_node);
-
-        YAML::Node waypoints_node;
-        for (const auto &waypoint : vehicle.waypoints) {
-            YAML::Node waypoint_node;
-            auto count = 0;
-            for (const auto &leg : waypoint.route.legs) {
-                for (const auto &step : leg.steps) {
-                    for (const auto &pose : step.poses) {
-                        YAML::Node leg_node;
-                        leg_node["lon"] = fmt::format("{:.6f}", pose.lon);
-                        leg_node["lat"] = fmt::format("{:.6f}", pose.lat);
-                        waypoint_node.push_back(std::move(leg_node));
-                    }
-                }
-            }
-            waypoints_node.push_back(std::move(waypoint_node));
-        }
-        veh_node["waypoints"] = std::move(waypoints_node);
-        node["vehicles"].push_back(std::move(veh_node));
-    }
+    return;
+}
 
-    // For each of the trips, we write the relavant data in yaml format.
-    for (const auto &trip : trips_) {
-        YAML::Node origin_pos_node;
-        origin_pos_node["lon"] = fmt::format("{:.6f}", trip.origin.lon);
-        origin_pos_node["lat"] = fmt::format("{:.6f}", trip.origin.lat);
-
-        YAML::Node destination_pos_node;
-        destination_pos_node["lon"] = fmt::format("{:.6f}", trip.destination.lon);
-        destination_pos_node["lat"] = fmt::format("{:.6f}", trip.destination.lat);
-
-        YAML::Node trip_node;
-        trip_node["id"] = trip.id;
-        trip_node["origin"] = std::move(origin_pos_node);
-        trip_node["destination"] = std::move(destination_pos_node);
-        trip_node["status"] = to_string(trip.status);
-        trip_node["request_time_ms"] = trip.request_time_ms;
-        trip_node["max_pickup_time_ms"] = trip.max_pickup_time_ms;
-        trip_node["pickup_time_ms"] = trip.pickup_time_ms;
-        trip_node["dropoff_time_ms"] = trip.dropoff_time_ms;
-
-        node["trips"].push_back(std::move(trip_node));
+template <typename RouterFunc, typename DemandGeneratorFunc>
+void Platform<RouterFunc, DemandGeneratorFunc>::sample_memory_usage() {
+    MemoryUsage memory_usage;
+    memory_usage.route_bytes = get_route_heap_bytes(vehicles_);
+    memory_usage.trip_count = trips_.size();
+    memory_usage.trip_bytes = get_heap_bytes(trips_) + get_heap_bytes(pending_trip_ids_);
+    if (datalog_writer_) {
+        memory_usage.datalog_bytes =
+            datalog_writer_->get_buffer_bytes() + datalog_delta_encoder_.get_buffer_bytes();
     }
+    memory_usage.rss_bytes = get_resident_bytes();
 
-    datalog_ofstream_ << node << std::endl << "---\n";
-
-    fmt::print("[DEBUG] T = {}s: Wrote to datalog.\n", system_time_ms_ / 1000.0);
+    update_peak_memory_usage(peak_memory_usage_, memory_usage);
 
     return;
 }
 
 template <typename RouterFunc, typename DemandGeneratorFunc>
-void Platform<RouterFunc, DemandGeneratorFunc>::create_report(double total_runtime_s) {
+SimulationReport
+Platform<RouterFunc, DemandGeneratorFunc>::create_report(double total_runtime_s) {
     fmt::print("-----------------------------------------------------------------------------------"
                "-----------------------------\n");
 
@@ -298,81 +617,143 @@ void Platform<RouterFunc, DemandGeneratorFunc>::create_report(double total_runti
                platform_config_.mod_system_config.fleet_config.veh_capacity);
     fmt::print(" - Request Config: max_wait_time = {}s.\n",
                platform_config_.mod_system_config.request_config.max_pickup_wait_time_s);
-    fmt::print(" - Output Config: output_datalog = {}, render_video = {}.\n",
+    fmt::print(" - Dispatch Config: zones = {} x {}, zone_border = {}m, num_threads = {}.\n",
+               platform_config_.mod_system_config.dispatch_config.num_zone_cols,
+               platform_config_.mod_system_config.dispatch_config.num_zone_rows,
+               platform_config_.mod_system_config.dispatch_config.zone_border_m,
+               platform_config_.mod_system_config.dispatch_config.num_threads);
+    fmt::print(" - Output Config: output_datalog = {} (delta_encoded = {}, binary = {}, "
+               "compression = {}), render_video = {}, output_trace = {}.\n",
                platform_config_.output_config.datalog_config.output_datalog,
-               platform_config_.output_config.video_config.render_video);
+               platform_config_.output_config.datalog_config.delta_encoded,
+               platform_config_.output_config.datalog_config.binary,
+               to_string(platform_config_.output_config.datalog_config.compression),
+               platform_config_.output_config.video_config.render_video,
+               platform_config_.output_config.trace_config.output_trace);
 
     // Simulation Runtime
     fmt::print("# Simulation Runtime\n");
     fmt::print(" - Runtime: total_runtime = {}s, average_runtime_per_simulated_second = {}.\n",
                total_runtime_s,
                total_runtime_s * 1000 / system_shutdown_time_ms_);
-
-    // Report trip status
-    auto trip_count = 0;
-    auto dispatched_trip_count = 0;
-    auto completed_trip_count = 0;
-    auto total_wait_time_ms = 0;
-    auto total_travel_time_ms = 0;
-
-    for (const auto &trip : trips_) {
-        if (trip.request_time_ms < main_sim_start_time_ms_) {
-            continue;
-        } else if (trip.request_time_ms >= main_sim_end_time_ms_) {
-            break;
-        }
-
-        trip_count++;
-
-        if (trip.status == TripStatus::WALKAWAY) {
-            continue;
-        }
-
-        dispatched_trip_count++;
-
-        if (trip.status == TripStatus::DROPPED_OFF) {
-            completed_trip_count++;
-            total_wait_time_ms += trip.pickup_time_ms - trip.request_time_ms;
-            total_travel_time_ms += trip.dropoff_time_ms - trip.pickup_time_ms;
-        }
-    }
+    fmt::print(" - Phases: advance = {}s, demand = {}s, dispatch = {}s, datalog = {}s.\n",
+               advance_runtime_s_,
+               demand_runtime_s_,
+               dispatch_runtime_s_,
+               datalog_runtime_s_);
+
+    SimulationReport report;
+    report.total_runtime_s = total_runtime_s;
+    report.advance_runtime_s = advance_runtime_s_;
+    report.demand_runtime_s = demand_runtime_s_;
+    report.dispatch_runtime_s = dispatch_runtime_s_;
+    report.datalog_runtime_s = datalog_runtime_s_;
+
+    // Report the peak memory held by each subsystem, as sampled at the end of each cycle. The peak
+    // of the process also covers the memory taken before the simulation, e.g. by the router map,
+    // while the growth over the start of the platform only counts this simulation.
+    report.peak_route_bytes = peak_memory_usage_.route_bytes;
+    report.peak_trip_bytes = peak_memory_usage_.trip_bytes;
+    report.peak_datalog_bytes = peak_memory_usage_.datalog_bytes;
+    report.peak_rss_bytes = std::max(peak_memory_usage_.rss_bytes, get_peak_resident_bytes());
+    report.peak_rss_growth_bytes = peak_memory_usage_.rss_bytes > start_rss_bytes_
+                                       ? peak_memory_usage_.rss_bytes - start_rss_bytes_
+                                       : 0;
+
+    fmt::print("# Memory\n");
+    fmt::print(" - Subsystems: peak_routes = {}MB, peak_trips = {}MB ({} trips), "
+               "peak_datalog = {}MB.\n",
+               report.peak_route_bytes / 1e6,
+               report.peak_trip_bytes / 1e6,
+               peak_memory_usage_.trip_count,
+               report.peak_datalog_bytes / 1e6);
+    fmt::print(" - Process: peak_rss_in_cycles = {}MB (+{}MB since the start), peak_rss = {}MB.\n",
+               peak_memory_usage_.rss_bytes / 1e6,
+               report.peak_rss_growth_bytes / 1e6,
+               report.peak_rss_bytes / 1e6);
+
+    // Report trip status, as accumulated during the simulation.
+    const auto &total = kpi_accumulator_.get_total();
+    const auto &wait_time_histogram = kpi_accumulator_.get_wait_time_histogram();
+    const auto &travel_time_histogram = kpi_accumulator_.get_travel_time_histogram();
+
+    report.trip_count = total.trip_count;
+    report.dispatched_trip_count = total.dispatched_trip_count;
+    report.completed_trip_count = total.completed_trip_count;
 
     fmt::print("# Trips\n");
     fmt::print(
         " - Total Trips: requested = {} (of which {} dispatched [{}%] + {} walked away [{}%]).\n",
-        trip_count,
-        dispatched_trip_count,
-        100.0 * dispatched_trip_count / trip_count,
-        trip_count - dispatched_trip_count,
-        100.0 - 100.0 * dispatched_trip_count / trip_count);
-    fmt::print(" - Travel Time: completed = {}.", completed_trip_count);
-    if (completed_trip_count > 0) {
+        report.trip_count,
+        report.dispatched_trip_count,
+        100.0 * report.dispatched_trip_count / report.trip_count,
+        report.trip_count - report.dispatched_trip_count,
+        100.0 - 100.0 * report.dispatched_trip_count / report.trip_count);
+    fmt::print(" - Travel Time: completed = {}.", report.completed_trip_count);
+    if (report.completed_trip_count > 0) {
+        report.average_wait_time_s =
+            total.total_wait_time_ms / 1000.0 / report.completed_trip_count;
+        report.average_travel_time_s =
+            total.total_travel_time_ms / 1000.0 / report.completed_trip_count;
+        report.p50_wait_time_s = wait_time_histogram.get_percentile_ms(0.5) / 1000.0;
+        report.p90_wait_time_s = wait_time_histogram.get_percentile_ms(0.9) / 1000.0;
+        report.p99_wait_time_s = wait_time_histogram.get_percentile_ms(0.99) / 1000.0;
+        report.p50_travel_time_s = travel_time_histogram.get_percentile_ms(0.5) / 1000.0;
+        report.p90_travel_time_s = travel_time_histogram.get_percentile_ms(0.9) / 1000.0;
+        report.p99_travel_time_s = travel_time_histogram.get_percentile_ms(0.99) / 1000.0;
         fmt::print(" average_wait_time = {}s, average_travel_time = {}s.\n",
-                   total_wait_time_ms / 1000.0 / completed_trip_count,
-                   total_travel_time_ms / 1000.0 / completed_trip_count);
+                   report.average_wait_time_s,
+                   report.average_travel_time_s);
+        fmt::print(" - Wait Time Percentiles: p50 = {}s, p90 = {}s, p99 = {}s.\n",
+                   report.p50_wait_time_s,
+                   report.p90_wait_time_s,
+                   report.p99_wait_time_s);
+        fmt::print(" - Travel Time Percentiles: p50 = {}s, p90 = {}s, p99 = {}s.\n",
+                   report.p50_travel_time_s,
+                   report.p90_travel_time_s,
+                   report.p99_travel_time_s);
     } else {
         fmt::print(" PLEASE USE LONGER SIMULATION DURATION TO BE ABLE TO COMPLETE TRIPS!\n");
     }
 
     // Report vehicle status
-    auto total_dist_traveled_mm = 0;
-    auto total_loaded_dist_traveled_mm = 0;
+    const auto num_vehicles = kpi_accumulator_.get_num_vehicles();
 
-    for (const auto &vehicle : vehicles_) {
-        total_dist_traveled_mm += vehicle.dist_traveled_mm;
-        total_loaded_dist_traveled_mm += vehicle.loaded_dist_traveled_mm;
-    }
+    report.average_distance_traveled_m = total.dist_traveled_mm / 1000.0 / num_vehicles;
+    report.average_distance_traveled_per_hour_m =
+        total.dist_traveled_mm / num_vehicles * 3600.0 /
+        (main_sim_end_time_ms_ - main_sim_start_time_ms_);
+    report.average_load = total.loaded_dist_traveled_mm * 1.0 / total.dist_traveled_mm;
 
     fmt::print("# Vehicles\n");
     fmt::print(
         " - Distance: average_distance_traveled = {}m. average_distance_traveled_per_hour = {}m.\n",
-        total_dist_traveled_mm / 1000.0 / vehicles_.size(),
-        total_dist_traveled_mm / vehicles_.size() * 3600.0 /
-            (main_sim_end_time_ms_ - main_sim_start_time_ms_));
-    fmt::print(" - Load: average_load = {}.\n",
-               total_loaded_dist_traveled_mm * 1.0 / total_dist_traveled_mm);
+        report.average_distance_traveled_m,
+        report.average_distance_traveled_per_hour_m);
+    fmt::print(" - Load: average_load = {}.\n", report.average_load);
+
+    // Report the KPIs over each window of the main simulation.
+    const auto &windows = kpi_accumulator_.get_windows();
+    fmt::print("# Windows\n");
+    for (auto i = 0; i < windows.size(); i++) {
+        const auto &window = windows[i];
+        const auto window_start_time_ms =
+            main_sim_start_time_ms_ + i * kpi_accumulator_.get_window_ms();
+
+        fmt::print(" - T = {}s: requested = {}, dispatched = {}, completed = {}, "
+                   "average_wait_time = {}s, average_distance_traveled = {}m.\n",
+                   window_start_time_ms / 1000.0,
+                   window.trip_count,
+                   window.dispatched_trip_count,
+                   window.completed_trip_count,
+                   window.completed_trip_count > 0
+                       ? window.total_wait_time_ms / 1000.0 / window.completed_trip_count
+                       : 0.0,
+                   window.dist_traveled_mm / 1000.0 / num_vehicles);
+    }
 
     fmt::print("-----------------------------------------------------------------------------------"
                "-----------------------------\n");
-    return;
+
+    return report;
 }
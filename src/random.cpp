@@ -0,0 +1,110 @@
+/// \author Jian Wen
+/// \date 2021/02/18
+
+#include "random.hpp"
+
+namespace {
+
+/// \brief The multipliers and the key increments (Weyl sequence) of Philox4x32.
+constexpr uint32_t kPhiloxM0 = 0xD2511F53;
+constexpr uint32_t kPhiloxM1 = 0xCD9E8D57;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9;
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85;
+
+/// \brief Convert two random 32-bit integers into a double in [0, 1) with 53 random bits.
+inline double to_uniform(uint32_t a, uint32_t b) {
+    return ((a >> 5) * 67108864.0 + (b >> 6)) * (1.0 / 9007199254740992.0);
+}
+
+} // namespace
+
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+    for (auto round = 0; round < 10; round++) {
+        if (round > 0) {
+            key[0] += kPhiloxW0;
+            key[1] += kPhiloxW1;
+        }
+
+        const auto product0 = static_cast<uint64_t>(kPhiloxM0) * counter[0];
+        const auto product1 = static_cast<uint64_t>(kPhiloxM1) * counter[2];
+
+        counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                   static_cast<uint32_t>(product1),
+                   static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                   static_cast<uint32_t>(product0)};
+    }
+
+    return counter;
+}
+
+RandomStream::RandomStream(uint64_t _seed, uint64_t _stream_id)
+    : key_{static_cast<uint32_t>(_seed), static_cast<uint32_t>(_seed >> 32)},
+      counter_{0, 0, static_cast<uint32_t>(_stream_id), static_cast<uint32_t>(_stream_id >> 32)} {}
+
+uint32_t RandomStream::next_uint32() {
+    if (index_in_block_ == 4) {
+        generate_block();
+        index_in_block_ = 0;
+    }
+
+    return block_[index_in_block_++];
+}
+
+double RandomStream::next_uniform() {
+    const auto a = next_uint32();
+    const auto b = next_uint32();
+
+    return to_uniform(a, b);
+}
+
+void RandomStream::fill_uniform(double *out, size_t n) {
+    auto i = 0;
+
+    // Consume what is left in the current block first.
+    while (i < n && index_in_block_ != 4) {
+        out[i++] = next_uniform();
+    }
+
+    // Then each new block gives exactly two doubles.
+    for (; i + 1 < n; i += 2) {
+        generate_block();
+        index_in_block_ = 4;
+
+        out[i] = to_uniform(block_[0], block_[1]);
+        out[i + 1] = to_uniform(block_[2], block_[3]);
+    }
+
+    if (i < n) {
+        out[i] = next_uniform();
+    }
+}
+
+uint64_t RandomStream::get_position() const {
+    const auto block_index = (static_cast<uint64_t>(counter_[1]) << 32) | counter_[0];
+
+    // The counter always points to the block after block_.
+    return block_index * 4 - (4 - index_in_block_);
+}
+
+void RandomStream::set_position(uint64_t position) {
+    const auto block_index = position / 4;
+
+    counter_[0] = static_cast<uint32_t>(block_index);
+    counter_[1] = static_cast<uint32_t>(block_index >> 32);
+    index_in_block_ = 4;
+
+    // Regenerate the partially consumed block.
+    if (position % 4 != 0) {
+        generate_block();
+        index_in_block_ = position % 4;
+    }
+}
+
+void RandomStream::generate_block() {
+    block_ = philox4x32(counter_, key_);
+
+    // Increment the 64-bit block index.
+    if (++counter_[0] == 0) {
+        counter_[1]++;
+    }
+}
@@ -0,0 +1,64 @@
+/// \author Jian Wen
+/// \date 2021/02/18
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// \brief A stream of random numbers generated by the counter-based Philox4x32-10 generator.
+/// \details Philox (Salmon et al., 2011) computes the n-th block of 4 random 32-bit integers as a
+/// pure function of the key and the counter n. There is no hidden state to share or to lock: a
+/// stream is fully described by (seed, stream_id, position), and different stream ids give
+/// independent streams under the same seed. Work can therefore be split across any number of
+/// threads, each drawing from the streams of its own work items, with results bit-identical to a
+/// serial run.
+class RandomStream {
+  public:
+    /// \brief Constructor.
+    /// \param _seed The seed shared by all streams of a simulation (used as the Philox key).
+    /// \param _stream_id The id that tells this stream apart from the others under the same seed.
+    RandomStream(uint64_t _seed, uint64_t _stream_id);
+
+    /// \brief Get the next random 32-bit integer.
+    uint32_t next_uint32();
+
+    /// \brief Get the next random double uniformly distributed in [0, 1), with 53 random bits.
+    double next_uniform();
+
+    /// \brief Fill the array with random doubles uniformly distributed in [0, 1).
+    /// \details Equivalent to calling next_uniform() n times, but generates whole blocks at once.
+    void fill_uniform(double *out, size_t n);
+
+    /// \brief The number of 32-bit integers drawn from the stream so far.
+    uint64_t get_position() const;
+
+    /// \brief Move the stream to the given position, e.g. to restore it from a checkpoint.
+    void set_position(uint64_t position);
+
+  private:
+    /// \brief Generate the block at the current counter and move the counter forward.
+    void generate_block();
+
+    /// \brief The Philox key derived from the seed.
+    std::array<uint32_t, 2> key_;
+
+    /// \brief The Philox counter. The lower half is the block index, the upper half the stream id.
+    std::array<uint32_t, 4> counter_;
+
+    /// \brief The most recently generated block.
+    std::array<uint32_t, 4> block_ = {};
+
+    /// \brief The number of integers in block_ that have been consumed. 4 means none left.
+    size_t index_in_block_ = 4;
+};
+
+/// \brief Compute the Philox4x32-10 block of the given counter and key.
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+/// \brief Combine the replication and a sub-stream index into one stream id.
+/// \details Different replications of a simulation use disjoint sets of streams under one seed.
+inline uint64_t make_stream_id(uint32_t replication, uint32_t substream) {
+    return (static_cast<uint64_t>(replication) << 32) | substream;
+}
@@ -0,0 +1,360 @@
+/// \author Jian Wen
+/// \date 2021/02/28
+
+#include "rasterizer.hpp"
+
+#include <png.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/// \brief A glyph of the 5 x 7 pixel font, where '#' is lit.
+struct Glyph {
+    char character;
+    const char *rows[7];
+};
+
+/// \brief The font, which only holds the characters used in the video overlay.
+const Glyph kGlyphs[] = {
+    {'0', {".###.", "#...#", "#..##", "#.#.#", "##..#", "#...#", ".###."}},
+    {'1', {"..#..", ".##..", "..#..", "..#..", "..#..", "..#..", ".###."}},
+    {'2', {".###.", "#...#", "....#", "...#.", "..#..", ".#...", "#####"}},
+    {'3', {"#####", "...#.", "..#..", "...#.", "....#", "#...#", ".###."}},
+    {'4', {"...#.", "..##.", ".#.#.", "#..#.", "#####", "...#.", "...#."}},
+    {'5', {"#####", "#....", "####.", "....#", "....#", "#...#", ".###."}},
+    {'6', {"..##.", ".#...", "#....", "####.", "#...#", "#...#", ".###."}},
+    {'7', {"#####", "....#", "...#.", "..#..", ".#...", ".#...", ".#..."}},
+    {'8', {".###.", "#...#", "#...#", ".###.", "#...#", "#...#", ".###."}},
+    {'9', {".###.", "#...#", "#...#", ".####", "....#", "...#.", ".##.."}},
+    {'T', {"#####", "..#..", "..#..", "..#..", "..#..", "..#..", "..#.."}},
+    {'=', {".....", ".....", "#####", ".....", "#####", ".....", "....."}},
+    {'.', {".....", ".....", ".....", ".....", ".....", ".##..", ".##.."}},
+    {',', {".....", ".....", ".....", ".....", ".##..", "..#..", ".#..."}},
+    {'(', {"...#.", "..#..", ".#...", ".#...", ".#...", "..#..", "...#."}},
+    {')', {".#...", "..#..", "...#.", "...#.", "...#.", "..#..", ".#..."}},
+    {'a', {".....", ".....", ".###.", "....#", ".####", "#...#", ".####"}},
+    {'c', {".....", ".....", ".###.", "#....", "#....", "#...#", ".###."}},
+    {'d', {"....#", "....#", ".##.#", "#..##", "#...#", "#...#", ".####"}},
+    {'e', {".....", ".....", ".###.", "#...#", "#####", "#....", ".###."}},
+    {'i', {"..#..", ".....", ".##..", "..#..", "..#..", "..#..", ".###."}},
+    {'l', {".##..", "..#..", "..#..", "..#..", "..#..", "..#..", ".###."}},
+    {'m', {".....", ".....", "##.#.", "#.#.#", "#.#.#", "#...#", "#...#"}},
+    {'o', {".....", ".....", ".###.", "#...#", "#...#", "#...#", ".###."}},
+    {'p', {".....", ".....", "####.", "#...#", "####.", "#....", "#...."}},
+    {'q', {".....", ".....", ".##.#", "#..##", ".####", "....#", "....#"}},
+    {'r', {".....", ".....", "#.##.", "##..#", "#....", "#....", "#...."}},
+    {'s', {".....", ".....", ".###.", "#....", ".###.", "....#", "####."}},
+    {'t', {".#...", ".#...", "###..", ".#...", ".#...", ".#..#", "..##."}},
+    {'u', {".....", ".....", "#...#", "#...#", "#...#", "#..##", ".##.#"}},
+};
+
+/// \brief The size of a glyph and the spacing between glyphs and lines, in pixels before scaling.
+constexpr size_t kGlyphWidth = 5;
+constexpr size_t kGlyphHeight = 7;
+constexpr size_t kGlyphAdvance = 6;
+constexpr size_t kLineAdvance = 9;
+
+/// \brief Find the glyph of the character, nullptr if not in the font.
+const Glyph *find_glyph(char character) {
+    for (const auto &glyph : kGlyphs) {
+        if (glyph.character == character) {
+            return &glyph;
+        }
+    }
+
+    return nullptr;
+}
+
+/// \brief Get the distance from the point to the segment.
+float get_distance_to_segment(Point p, Point p0, Point p1) {
+    const auto dx = p1.x - p0.x;
+    const auto dy = p1.y - p0.y;
+    const auto length_squared = dx * dx + dy * dy;
+
+    auto t = 0.0f;
+    if (length_squared > 0) {
+        t = std::clamp(((p.x - p0.x) * dx + (p.y - p0.y) * dy) / length_squared, 0.0f, 1.0f);
+    }
+
+    return std::hypot(p.x - (p0.x + t * dx), p.y - (p0.y + t * dy));
+}
+
+} // namespace
+
+Image load_png_image(const std::string &path_to_image) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    auto success = png_image_begin_read_from_file(&png, path_to_image.c_str());
+    assert(success && "[ERROR] Failed to open the png image!");
+
+    png.format = PNG_FORMAT_RGB;
+    Image image;
+    image.width = png.width;
+    image.height = png.height;
+    image.pixels.resize(PNG_IMAGE_SIZE(png));
+
+    success = png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr);
+    assert(success && "[ERROR] Failed to read the png image!");
+
+    return image;
+}
+
+void save_png_image(const std::string &path_to_image, const Image &image) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = image.width;
+    png.height = image.height;
+    png.format = PNG_FORMAT_RGB;
+
+    const auto success = png_image_write_to_file(
+        &png, path_to_image.c_str(), 0, image.pixels.data(), 0, nullptr);
+    assert(success && "[ERROR] Failed to write the png image!");
+}
+
+Rasterizer::Rasterizer(Image &_image)
+    : image_(_image),
+      coverage_(_image.width * _image.height, 0),
+      span_begins_(_image.height, _image.width),
+      span_ends_(_image.height, 0),
+      row_begin_(_image.height) {}
+
+void Rasterizer::draw_background(const Image &background) {
+    assert(background.width == image_.width && background.height == image_.height &&
+           "[ERROR] The background must be as large as the image!");
+
+    std::copy(background.pixels.begin(), background.pixels.end(), image_.pixels.begin());
+}
+
+void Rasterizer::draw_rectangle(Point top_left, Point bottom_right, Color color) {
+    add_rectangle(top_left, bottom_right);
+    blend_coverage(color);
+}
+
+void Rasterizer::draw_disc(Point center, float radius, Color color) {
+    add_segment(center, center, radius);
+    blend_coverage(color);
+}
+
+void Rasterizer::draw_polyline(const Point *points,
+                               size_t num_points,
+                               float line_width,
+                               LineStyle line_style,
+                               Color color) {
+    if (num_points == 0) {
+        return;
+    }
+
+    const auto half_width = line_width / 2;
+
+    if (line_style == LineStyle::SOLID) {
+        if (num_points == 1) {
+            add_segment(points[0], points[0], half_width);
+        }
+        for (auto i = 0; i + 1 < num_points; i++) {
+            add_segment(points[i], points[i + 1], half_width);
+        }
+        blend_coverage(color);
+        return;
+    }
+
+    // The lengths of the dashes and the gaps between the centers of the round caps, so that the
+    // dashes look as long as 3.7 times the line width and the gaps 1.6 times (or 1 and 1.65 times
+    // for dots), as in matplotlib.
+    const auto dash_length = line_style == LineStyle::DASHED ? 2.7f * line_width : 0.0f;
+    const auto gap_length =
+        line_style == LineStyle::DASHED ? 2.6f * line_width : 2.65f * line_width;
+
+    // Walk along the polyline, carrying the state of the dash pattern across the segments.
+    auto in_dash = true;
+    auto remaining_length = dash_length;
+    for (auto i = 0; i + 1 < num_points; i++) {
+        const auto p0 = points[i];
+        const auto p1 = points[i + 1];
+        const auto segment_length = std::hypot(p1.x - p0.x, p1.y - p0.y);
+
+        auto position = 0.0f;
+        while (position < segment_length) {
+            const auto step = std::min(remaining_length, segment_length - position);
+
+            if (in_dash) {
+                const auto t0 = position / segment_length;
+                const auto t1 = (position + step) / segment_length;
+                add_segment({p0.x + t0 * (p1.x - p0.x), p0.y + t0 * (p1.y - p0.y)},
+                            {p0.x + t1 * (p1.x - p0.x), p0.y + t1 * (p1.y - p0.y)},
+                            half_width);
+            }
+
+            position += step;
+            remaining_length -= step;
+            if (remaining_length <= 0) {
+                in_dash = !in_dash;
+                remaining_length = in_dash ? dash_length : gap_length;
+            }
+        }
+    }
+    blend_coverage(color);
+}
+
+void Rasterizer::draw_marker(Point center, float size, MarkerShape shape, Color color) {
+    const auto half_size = size / 2;
+    const auto half_thickness = size / 6;
+
+    if (shape == MarkerShape::PLUS) {
+        add_rectangle({center.x - half_size, center.y - half_thickness},
+                      {center.x + half_size, center.y + half_thickness});
+        add_rectangle({center.x - half_thickness, center.y - half_size},
+                      {center.x + half_thickness, center.y + half_size});
+    } else {
+        // The round caps of the diagonals stay within the bounding box.
+        const auto offset = (half_size - half_thickness) / std::sqrt(2.0f);
+        add_segment({center.x - offset, center.y - offset},
+                    {center.x + offset, center.y + offset},
+                    half_thickness);
+        add_segment({center.x - offset, center.y + offset},
+                    {center.x + offset, center.y - offset},
+                    half_thickness);
+    }
+    blend_coverage(color);
+}
+
+void Rasterizer::draw_text(Point top_left, const std::string &text, size_t scale, Color color) {
+    auto x = top_left.x;
+    auto y = top_left.y;
+
+    for (const auto character : text) {
+        if (character == '\n') {
+            x = top_left.x;
+            y += kLineAdvance * scale;
+            continue;
+        }
+
+        const auto glyph = find_glyph(character);
+        if (glyph != nullptr) {
+            for (auto row = 0; row < kGlyphHeight; row++) {
+                for (auto col = 0; col < kGlyphWidth; col++) {
+                    if (glyph->rows[row][col] == '#') {
+                        add_rectangle({x + col * scale, y + row * scale},
+                                      {x + (col + 1) * scale, y + (row + 1) * scale});
+                    }
+                }
+            }
+        }
+        x += kGlyphAdvance * scale;
+    }
+    blend_coverage(color);
+}
+
+Point Rasterizer::get_text_size(const std::string &text, size_t scale) {
+    size_t max_line_length = 0;
+    size_t line_length = 0;
+    size_t num_lines = 1;
+
+    for (const auto character : text) {
+        if (character == '\n') {
+            line_length = 0;
+            num_lines++;
+        } else {
+            line_length++;
+            max_line_length = std::max(max_line_length, line_length);
+        }
+    }
+
+    return {static_cast<float>((max_line_length * kGlyphAdvance - 1) * scale),
+            static_cast<float>((num_lines * kLineAdvance - 2) * scale)};
+}
+
+void Rasterizer::add_segment(Point p0, Point p1, float half_width) {
+    // The pixels within half a pixel beyond the edge are partially covered.
+    const auto reach = half_width + 0.5f;
+
+    const auto y_min = std::max(0.0f, std::floor(std::min(p0.y, p1.y) - reach));
+    const auto y_max = std::min<float>(image_.height, std::ceil(std::max(p0.y, p1.y) + reach));
+
+    for (auto y = static_cast<size_t>(y_min); y < y_max; y++) {
+        const auto center_y = y + 0.5f;
+
+        // Only the part of the segment within reach of this row is relevant.
+        auto t0 = 0.0f;
+        auto t1 = 1.0f;
+        if (p1.y != p0.y) {
+            t0 = std::clamp((center_y - reach - p0.y) / (p1.y - p0.y), 0.0f, 1.0f);
+            t1 = std::clamp((center_y + reach - p0.y) / (p1.y - p0.y), 0.0f, 1.0f);
+        }
+        const auto x0 = p0.x + t0 * (p1.x - p0.x);
+        const auto x1 = p0.x + t1 * (p1.x - p0.x);
+
+        const auto x_min = std::max(0.0f, std::floor(std::min(x0, x1) - reach));
+        const auto x_max = std::min<float>(image_.width, std::ceil(std::max(x0, x1) + reach));
+
+        for (auto x = static_cast<size_t>(x_min); x < x_max; x++) {
+            const auto distance = get_distance_to_segment({x + 0.5f, center_y}, p0, p1);
+            add_coverage(x, y, reach - distance);
+        }
+    }
+}
+
+void Rasterizer::add_rectangle(Point top_left, Point bottom_right) {
+    const auto y_min = std::max(0.0f, std::floor(top_left.y));
+    const auto y_max = std::min<float>(image_.height, std::ceil(bottom_right.y));
+    const auto x_min = std::max(0.0f, std::floor(top_left.x));
+    const auto x_max = std::min<float>(image_.width, std::ceil(bottom_right.x));
+
+    // Each pixel is covered by the area of its overlap with the rectangle.
+    for (auto y = static_cast<size_t>(y_min); y < y_max; y++) {
+        const auto overlap_y = std::min(y + 1.0f, bottom_right.y) - std::max(y + 0.0f, top_left.y);
+        for (auto x = static_cast<size_t>(x_min); x < x_max; x++) {
+            const auto overlap_x =
+                std::min(x + 1.0f, bottom_right.x) - std::max(x + 0.0f, top_left.x);
+            add_coverage(x, y, overlap_x * overlap_y);
+        }
+    }
+}
+
+void Rasterizer::add_coverage(size_t x, size_t y, float coverage) {
+    if (coverage <= 0) {
+        return;
+    }
+
+    auto &pixel_coverage = coverage_[y * image_.width + x];
+    pixel_coverage =
+        std::max<uint8_t>(pixel_coverage, std::lround(std::min(coverage, 1.0f) * 255));
+
+    span_begins_[y] = std::min(span_begins_[y], x);
+    span_ends_[y] = std::max(span_ends_[y], x + 1);
+    row_begin_ = std::min(row_begin_, y);
+    row_end_ = std::max(row_end_, y + 1);
+}
+
+void Rasterizer::blend_coverage(Color color) {
+    const auto opacity = static_cast<uint32_t>(std::lround(color.alpha * 255));
+
+    for (auto y = row_begin_; y < row_end_; y++) {
+        for (auto x = span_begins_[y]; x < span_ends_[y]; x++) {
+            auto &pixel_coverage = coverage_[y * image_.width + x];
+            if (pixel_coverage == 0) {
+                continue;
+            }
+
+            const auto alpha = (opacity * pixel_coverage + 127) / 255;
+            auto pixel = &image_.pixels[(y * image_.width + x) * 3];
+            pixel[0] = (pixel[0] * (255 - alpha) + color.r * alpha + 127) / 255;
+            pixel[1] = (pixel[1] * (255 - alpha) + color.g * alpha + 127) / 255;
+            pixel[2] = (pixel[2] * (255 - alpha) + color.b * alpha + 127) / 255;
+
+            pixel_coverage = 0;
+        }
+
+        span_begins_[y] = image_.width;
+        span_ends_[y] = 0;
+    }
+
+    row_begin_ = image_.height;
+    row_end_ = 0;
+}
@@ -0,0 +1,114 @@
+/// \author Jian Wen
+/// \date 2021/02/28
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// \brief An RGB image with 8 bits per channel, stored row by row.
+struct Image {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint8_t> pixels = {}; // [height * width * 3]
+};
+
+/// \brief Load the image from a png file, converted to RGB.
+Image load_png_image(const std::string &path_to_image);
+
+/// \brief Save the image to a png file.
+void save_png_image(const std::string &path_to_image, const Image &image);
+
+/// \brief A point in pixels, where (0, 0) is the top left corner of the image.
+struct Point {
+    float x = 0.0;
+    float y = 0.0;
+};
+
+/// \brief A color with an opacity.
+struct Color {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    float alpha = 1.0; // the opacity, 0 for transparent and 1 for opaque
+};
+
+/// \brief The style of a line.
+enum class LineStyle {
+    SOLID,  // continuous
+    DASHED, // dashes of 3 times the line width
+    DOTTED  // dots of the line width
+};
+
+/// \brief The shape of a marker.
+enum class MarkerShape {
+    PLUS, // a filled plus
+    CROSS // a filled cross
+};
+
+/// \brief The rasterizer that draws anti-aliased shapes onto an image.
+/// \details Each shape is first rasterized into a coverage mask, which is then blended onto the
+/// image with the color. Overlapping parts of the same shape (e.g. the joints of a polyline) are
+/// only blended once, so that translucent shapes look uniform. The rows and columns touched by
+/// the shape are tracked, so the cost scales with the size of the shape rather than the image.
+class Rasterizer {
+  public:
+    /// \brief Constructor.
+    /// \param _image The image to draw onto, which must outlive the rasterizer.
+    explicit Rasterizer(Image &_image);
+
+    /// \brief Fill the whole image with the background.
+    void draw_background(const Image &background);
+
+    /// \brief Draw a filled rectangle.
+    void draw_rectangle(Point top_left, Point bottom_right, Color color);
+
+    /// \brief Draw a filled disc.
+    void draw_disc(Point center, float radius, Color color);
+
+    /// \brief Draw a polyline through the points, with round joints and caps.
+    void draw_polyline(const Point *points,
+                       size_t num_points,
+                       float line_width,
+                       LineStyle line_style,
+                       Color color);
+
+    /// \brief Draw a marker of the given size (the width of its bounding box).
+    void draw_marker(Point center, float size, MarkerShape shape, Color color);
+
+    /// \brief Draw the text in a 5 x 7 pixel font scaled by the given factor, starting from the
+    /// top left. Lines are separated by "\n". Characters not in the font are left blank.
+    void draw_text(Point top_left, const std::string &text, size_t scale, Color color);
+
+    /// \brief Get the size of the text as drawn by draw_text.
+    static Point get_text_size(const std::string &text, size_t scale);
+
+  private:
+    /// \brief Add a segment of the given half width, with round caps, to the coverage mask.
+    void add_segment(Point p0, Point p1, float half_width);
+
+    /// \brief Add an axis-aligned rectangle to the coverage mask.
+    void add_rectangle(Point top_left, Point bottom_right);
+
+    /// \brief Add the coverage of one pixel, and extend the span of its row.
+    void add_coverage(size_t x, size_t y, float coverage);
+
+    /// \brief Blend the coverage mask onto the image with the color, and clear the mask.
+    void blend_coverage(Color color);
+
+    /// \brief The image to draw onto.
+    Image &image_;
+
+    /// \brief The coverage of each pixel by the current shape, from 0 to 255.
+    std::vector<uint8_t> coverage_;
+
+    /// \brief The span [begin, end) of the columns covered in each row.
+    std::vector<size_t> span_begins_;
+    std::vector<size_t> span_ends_;
+
+    /// \brief The span [begin, end) of the rows covered.
+    size_t row_begin_;
+    size_t row_end_ = 0;
+};
@@ -0,0 +1,259 @@
+/// \author Jian Wen
+/// \date 2021/03/05
+
+#include "regression.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// \brief True if the doubles are identical, treating NaN as equal to itself.
+bool is_identical(double value, double other_value) {
+    return value == other_value || (std::isnan(value) && std::isnan(other_value));
+}
+
+/// \brief Get the name of the check in the json diff.
+const char *to_string(MetricCheck check) {
+    switch (check) {
+    case MetricCheck::EXACT:
+        return "exact";
+    case MetricCheck::RUNTIME:
+        return "runtime";
+    case MetricCheck::ROUTER_CALLS:
+        return "router_calls";
+    case MetricCheck::MEMORY:
+        return "memory";
+    }
+
+    return "";
+}
+
+/// \brief Get the name of the status in the json diff.
+const char *to_string(MetricStatus status) {
+    switch (status) {
+    case MetricStatus::OK:
+        return "ok";
+    case MetricStatus::IMPROVED:
+        return "improved";
+    case MetricStatus::REGRESSED:
+        return "regressed";
+    case MetricStatus::CHANGED:
+        return "changed";
+    case MetricStatus::MISSING:
+        return "missing";
+    }
+
+    return "";
+}
+
+/// \brief Format the double with 17 significant digits, which always reads back to the same double.
+/// \details The default format of older fmt versions only keeps 6 significant digits.
+std::string to_exact_string(double value) { return fmt::format("{:.17g}", value); }
+
+/// \brief Format the double as a json number, or null if not finite.
+std::string to_json_number(double value) {
+    return std::isfinite(value) ? to_exact_string(value) : "null";
+}
+
+} // namespace
+
+std::vector<RegressionMetric> get_regression_metrics(const SimulationReport &report,
+                                                     size_t num_router_calls) {
+    // The walkaways are the trips requested but never dispatched.
+    return {
+        {"trip_count", MetricCheck::EXACT, static_cast<double>(report.trip_count)},
+        {"dispatched_trip_count",
+         MetricCheck::EXACT,
+         static_cast<double>(report.dispatched_trip_count)},
+        {"walkaway_trip_count",
+         MetricCheck::EXACT,
+         static_cast<double>(report.trip_count - report.dispatched_trip_count)},
+        {"completed_trip_count",
+         MetricCheck::EXACT,
+         static_cast<double>(report.completed_trip_count)},
+        {"average_wait_time_s", MetricCheck::EXACT, report.average_wait_time_s},
+        {"average_travel_time_s", MetricCheck::EXACT, report.average_travel_time_s},
+        {"p50_wait_time_s", MetricCheck::EXACT, report.p50_wait_time_s},
+        {"p90_wait_time_s", MetricCheck::EXACT, report.p90_wait_time_s},
+        {"p99_wait_time_s", MetricCheck::EXACT, report.p99_wait_time_s},
+        {"p50_travel_time_s", MetricCheck::EXACT, report.p50_travel_time_s},
+        {"p90_travel_time_s", MetricCheck::EXACT, report.p90_travel_time_s},
+        {"p99_travel_time_s", MetricCheck::EXACT, report.p99_travel_time_s},
+        {"average_distance_traveled_m", MetricCheck::EXACT, report.average_distance_traveled_m},
+        {"average_load", MetricCheck::EXACT, report.average_load},
+        {"total_runtime_s", MetricCheck::RUNTIME, report.total_runtime_s},
+        {"router_calls", MetricCheck::ROUTER_CALLS, static_cast<double>(num_router_calls)},
+        {"peak_route_bytes", MetricCheck::MEMORY, static_cast<double>(report.peak_route_bytes)},
+        {"peak_trip_bytes", MetricCheck::MEMORY, static_cast<double>(report.peak_trip_bytes)},
+        {"peak_rss_growth_bytes",
+         MetricCheck::MEMORY,
+         static_cast<double>(report.peak_rss_growth_bytes)},
+    };
+}
+
+std::vector<RegressionMetric>
+merge_repeated_metrics(const std::vector<std::vector<RegressionMetric>> &runs) {
+    assert(!runs.empty() && "[ERROR] There must be at least one run to merge!");
+
+    auto metrics = runs[0];
+    auto deterministic = true;
+
+    for (auto i = 1; i < runs.size(); i++) {
+        assert(runs[i].size() == metrics.size() &&
+               "[ERROR] The runs to merge must have the same metrics!");
+
+        for (auto j = 0; j < metrics.size(); j++) {
+            if (metrics[j].check == MetricCheck::EXACT) {
+                deterministic = deterministic && is_identical(metrics[j].value, runs[i][j].value);
+            } else {
+                metrics[j].value = std::min(metrics[j].value, runs[i][j].value);
+            }
+        }
+    }
+
+    metrics.push_back({"deterministic", MetricCheck::EXACT, deterministic ? 1.0 : 0.0});
+
+    return metrics;
+}
+
+std::vector<MetricDiff> compare_regression_metrics(const std::string &scenario,
+                                                   const std::vector<RegressionMetric> &metrics,
+                                                   const RegressionBaseline &baseline,
+                                                   const RegressionTolerances &tolerances) {
+    const auto scenario_baseline = baseline.find(scenario);
+
+    std::vector<MetricDiff> diffs;
+    for (const auto &metric : metrics) {
+        MetricDiff diff;
+        diff.scenario = scenario;
+        diff.metric = metric.name;
+        diff.check = metric.check;
+        diff.current = metric.value;
+
+        switch (metric.check) {
+        case MetricCheck::EXACT:
+            diff.tolerance = 0.0;
+            break;
+        case MetricCheck::RUNTIME:
+            diff.tolerance = tolerances.runtime;
+            break;
+        case MetricCheck::ROUTER_CALLS:
+            diff.tolerance = tolerances.router_calls;
+            break;
+        case MetricCheck::MEMORY:
+            diff.tolerance = tolerances.peak_memory;
+            break;
+        }
+
+        if (scenario_baseline == baseline.end() ||
+            scenario_baseline->second.count(metric.name) == 0) {
+            diff.baseline = std::numeric_limits<double>::quiet_NaN();
+            diff.status = MetricStatus::MISSING;
+        } else {
+            diff.baseline = scenario_baseline->second.at(metric.name);
+
+            if (metric.check == MetricCheck::EXACT) {
+                diff.status = is_identical(diff.current, diff.baseline) ? MetricStatus::OK
+                                                                        : MetricStatus::CHANGED;
+            } else {
+                // The memory may also change by the absolute slack, as the growth of a small
+                // scenario is within a few pages of 0.
+                auto margin = diff.baseline * diff.tolerance;
+                if (metric.check == MetricCheck::MEMORY) {
+                    margin = std::max(margin, tolerances.peak_memory_slack_bytes);
+                }
+
+                if (diff.current > diff.baseline + margin) {
+                    diff.status = MetricStatus::REGRESSED;
+                } else if (diff.current < diff.baseline - margin) {
+                    diff.status = MetricStatus::IMPROVED;
+                } else {
+                    diff.status = MetricStatus::OK;
+                }
+            }
+        }
+
+        diffs.emplace_back(std::move(diff));
+    }
+
+    return diffs;
+}
+
+bool is_failed(const MetricDiff &diff) {
+    return diff.status == MetricStatus::REGRESSED || diff.status == MetricStatus::CHANGED ||
+           diff.status == MetricStatus::MISSING;
+}
+
+RegressionBaseline load_regression_baseline(const std::string &path_to_baseline) {
+    const auto baseline_yaml = YAML::LoadFile(path_to_baseline);
+
+    RegressionBaseline baseline;
+    for (const auto &scenario_yaml : baseline_yaml) {
+        auto &scenario_baseline = baseline[scenario_yaml.first.as<std::string>()];
+
+        for (const auto &metric_yaml : scenario_yaml.second) {
+            scenario_baseline[metric_yaml.first.as<std::string>()] =
+                metric_yaml.second.as<double>();
+        }
+    }
+
+    fmt::print("[INFO] Loaded the regression baseline of {} scenarios from {}.\n",
+               baseline.size(),
+               path_to_baseline);
+
+    return baseline;
+}
+
+void save_regression_baseline(const std::string &path_to_baseline,
+                              const RegressionBaseline &baseline) {
+    auto file = std::fopen(path_to_baseline.c_str(), "w");
+    assert(file != nullptr && "[ERROR] Failed to create the regression baseline file!");
+
+    fmt::print(file, "# The regression baseline written by the regression harness.\n");
+    for (const auto &[scenario, scenario_baseline] : baseline) {
+        fmt::print(file, "{}:\n", scenario);
+
+        for (const auto &[metric, value] : scenario_baseline) {
+            const auto value_string = std::isnan(value) ? ".nan" : to_exact_string(value);
+            fmt::print(file, "  {}: {}\n", metric, value_string);
+        }
+    }
+
+    std::fclose(file);
+
+    fmt::print("[INFO] Saved the regression baseline of {} scenarios into {}.\n",
+               baseline.size(),
+               path_to_baseline);
+}
+
+void write_regression_diff(std::FILE *file, const std::vector<MetricDiff> &diffs) {
+    const auto num_failures = std::count_if(diffs.begin(), diffs.end(), is_failed);
+
+    fmt::print(file,
+               "{{\"passed\": {}, \"num_metrics\": {}, \"num_failures\": {}, \"diffs\": [",
+               num_failures == 0 ? "true" : "false",
+               diffs.size(),
+               num_failures);
+
+    for (auto i = 0; i < diffs.size(); i++) {
+        const auto &diff = diffs[i];
+        fmt::print(file,
+                   "{}\n{{\"scenario\": \"{}\", \"metric\": \"{}\", \"check\": \"{}\", "
+                   "\"baseline\": {}, \"current\": {}, \"tolerance\": {}, \"status\": \"{}\"}}",
+                   i == 0 ? "" : ",",
+                   diff.scenario,
+                   diff.metric,
+                   to_string(diff.check),
+                   to_json_number(diff.baseline),
+                   to_json_number(diff.current),
+                   diff.tolerance,
+                   to_string(diff.status));
+    }
+
+    fmt::print(file, "\n]}}\n");
+}
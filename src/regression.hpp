@@ -0,0 +1,134 @@
+/// \author Jian Wen
+/// \date 2021/03/05
+
+#pragma once
+
+#include "config.hpp"
+#include "demand_generator.hpp"
+#include "memory.hpp"
+#include "platform.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+/// \brief How a metric of a scenario is checked against its baseline.
+enum class MetricCheck {
+    EXACT,        // must match the baseline exactly, e.g. the KPIs of the seeded simulation
+    RUNTIME,      // may exceed the baseline by the tolerance of the runtime
+    ROUTER_CALLS, // may exceed the baseline by the tolerance of the router calls
+    MEMORY,       // may exceed the baseline by the tolerance of the peak memory
+};
+
+/// \brief A metric of a scenario run by the regression harness.
+struct RegressionMetric {
+    std::string name = "";                  // the name of the metric, unique in the scenario
+    MetricCheck check = MetricCheck::EXACT; // how the metric is checked
+    double value = 0.0;                     // the value of the metric
+};
+
+/// \brief The status of a metric as compared against its baseline.
+enum class MetricStatus {
+    OK,        // within the tolerance, or identical if exact
+    IMPROVED,  // below the baseline by more than the tolerance, which may refresh the baseline
+    REGRESSED, // above the baseline by more than the tolerance
+    CHANGED,   // different from the baseline, which must be exact
+    MISSING,   // not in the baseline
+};
+
+/// \brief The comparison of a metric of a scenario against its baseline.
+struct MetricDiff {
+    std::string scenario = "";              // the name of the scenario
+    std::string metric = "";                // the name of the metric
+    MetricCheck check = MetricCheck::EXACT; // how the metric is checked
+    double baseline = 0.0;                  // the value in the baseline, NaN if missing
+    double current = 0.0;                   // the value of the current run
+    double tolerance = 0.0;                 // the relative tolerance, 0 if exact
+    MetricStatus status = MetricStatus::OK; // the result of the comparison
+};
+
+/// \brief The baseline metrics of each scenario, keyed by the scenario and then by the metric.
+using RegressionBaseline = std::map<std::string, std::map<std::string, double>>;
+
+/// \brief The router func that counts the queries, which may come from several dispatch threads.
+template <typename RouterFunc> class CountingRouterFunc {
+  public:
+    /// \brief Constructor.
+    CountingRouterFunc(const RouterFunc &_router_func, std::atomic<size_t> &_num_calls)
+        : router_func_(_router_func), num_calls_(_num_calls) {}
+
+    /// \brief Route through the wrapped router func.
+    template <typename... Args> auto operator()(Args &&...args) const {
+        num_calls_.fetch_add(1, std::memory_order_relaxed);
+        return router_func_(std::forward<Args>(args)...);
+    }
+
+  private:
+    /// \brief The wrapped router func.
+    const RouterFunc &router_func_;
+
+    /// \brief The number of queries so far.
+    std::atomic<size_t> &num_calls_;
+};
+
+/// \brief Get the metrics of a run from its report and its number of router calls.
+std::vector<RegressionMetric> get_regression_metrics(const SimulationReport &report,
+                                                     size_t num_router_calls);
+
+/// \brief Merge the metrics of the repeated runs of a scenario. The exact metrics are taken from
+/// the first run, and the others are the lowest over all runs, which is the least noisy.
+/// \details The metric "deterministic" is 1 if the exact metrics are identical in all runs, and 0
+/// otherwise. It is exact as well, so a nondeterministic scenario fails the check.
+std::vector<RegressionMetric>
+merge_repeated_metrics(const std::vector<std::vector<RegressionMetric>> &runs);
+
+/// \brief Run a scenario a number of times and merge the metrics of the runs.
+template <typename RouterFunc>
+std::vector<RegressionMetric> run_regression_scenario(const RegressionScenario &scenario,
+                                                      const RouterFunc &router_func,
+                                                      size_t num_repeats) {
+    // The demand is loaded once and shared by all runs, each of which sees the same requests.
+    const auto demand_model = DemandGenerator{scenario.path_to_demand_config, 0}.get_demand_model();
+
+    std::vector<std::vector<RegressionMetric>> runs;
+    for (auto i = 0; i < num_repeats; i++) {
+        // Free the heap memory left by the earlier runs, so that this run has to grow its own.
+        release_free_heap_memory();
+
+        std::atomic<size_t> num_router_calls{0};
+        Platform<CountingRouterFunc<RouterFunc>, DemandGenerator> platform{
+            scenario.platform_config,
+            CountingRouterFunc<RouterFunc>{router_func, num_router_calls},
+            DemandGenerator{demand_model, scenario.seed}};
+        const auto report = platform.run_simulation();
+
+        runs.emplace_back(get_regression_metrics(report, num_router_calls.load()));
+    }
+
+    return merge_repeated_metrics(runs);
+}
+
+/// \brief Compare the metrics of a scenario against its baseline.
+std::vector<MetricDiff> compare_regression_metrics(const std::string &scenario,
+                                                   const std::vector<RegressionMetric> &metrics,
+                                                   const RegressionBaseline &baseline,
+                                                   const RegressionTolerances &tolerances);
+
+/// \brief True if the diff fails the check, i.e. it is regressed, changed or missing.
+bool is_failed(const MetricDiff &diff);
+
+/// \brief Load the baseline from a yaml file written by save_regression_baseline().
+RegressionBaseline load_regression_baseline(const std::string &path_to_baseline);
+
+/// \brief Save the baseline into a yaml file, with the doubles in full precision so that the exact
+/// metrics are loaded back bit by bit.
+void save_regression_baseline(const std::string &path_to_baseline,
+                              const RegressionBaseline &baseline);
+
+/// \brief Write the diffs of all metrics as json, with the overall result and the number of
+/// failures at the top.
+void write_regression_diff(std::FILE *file, const std::vector<MetricDiff> &diffs);
@@ -0,0 +1,41 @@
+/// \author Jian Wen
+/// \date 2021/02/26
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/// \brief The lock-free ring buffer with a single producer thread and a single consumer thread.
+/// \details The producer only writes the tail and the consumer only writes the head, each on its
+/// own cache line, so neither ever waits for the other. The capacity must be a power of two.
+template <typename T, size_t kCapacity> class SpscRingBuffer {
+    static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0,
+                  "The capacity of SpscRingBuffer must be a power of two!");
+
+  public:
+    /// \brief Push the item at the tail (producer thread only).
+    /// \return false if the buffer is full, in which case nothing is pushed.
+    bool try_push(const T &item);
+
+    /// \brief Pop the item at the head (consumer thread only).
+    /// \return false if the buffer is empty, in which case the item is not touched.
+    bool try_pop(T &item);
+
+    /// \brief Check if the buffer is empty, as seen by the consumer thread.
+    bool empty() const;
+
+  private:
+    /// \brief The number of items ever popped, written by the consumer only.
+    alignas(64) std::atomic<size_t> head_{0};
+
+    /// \brief The number of items ever pushed, written by the producer only.
+    alignas(64) std::atomic<size_t> tail_{0};
+
+    /// \brief The storage of the items, indexed by the counts modulo the capacity.
+    alignas(64) std::array<T, kCapacity> items_;
+};
+
+// Implementation is put in a separate file for clarity and maintainability.
+#include "ring_buffer_impl.hpp"
@@ -0,0 +1,37 @@
+/// \author Jian Wen
+/// \date 2021/02/26
+
+#pragma once
+
+#include "ring_buffer.hpp"
+
+template <typename T, size_t kCapacity>
+bool SpscRingBuffer<T, kCapacity>::try_push(const T &item) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+        return false;
+    }
+
+    // The item is written before the tail is published to the consumer.
+    items_[tail & (kCapacity - 1)] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <typename T, size_t kCapacity> bool SpscRingBuffer<T, kCapacity>::try_pop(T &item) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // The item is read before the slot is released to the producer.
+    item = items_[head & (kCapacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <typename T, size_t kCapacity> bool SpscRingBuffer<T, kCapacity>::empty() const {
+    return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+}
@@ -2,6 +2,7 @@
 /// \date 2021/01/29
 
 #include "router.hpp"
+#include "vehicle.hpp"
 
 #include <osrm/engine_config.hpp>
 #include <osrm/json_container.hpp>
@@ -9,7 +10,8 @@
 
 #include <fmt/format.h>
 
-Router::Router(std::string _path_to_osrm_data) {
+Router::Router(std::string _path_to_osrm_data, double _simplification_tolerance_m)
+    : simplification_tolerance_m_(_simplification_tolerance_m) {
     // Set up the OSRM backend routing engine.
     osrm::EngineConfig config;
 
@@ -30,7 +32,8 @@ Router::Router(std::string _path_to_osrm_data) {
                _path_to_osrm_data);
 }
 
-RoutingResponse Router::operator()(const Pos &origin, const Pos &destination, RoutingType type) {
+RoutingResponse
+Router::operator()(const Pos &origin, const Pos &destination, RoutingType type) const {
     // Convert to the osrm route request params.
     osrm::RouteParameters params;
 
@@ -98,6 +101,10 @@ RoutingResponse Router::operator()(const Pos &origin, const Pos &destination, Ro
             response.route.duration_ms = duration_ms;
         } else if (type == RoutingType::FULL_ROUTE) {
             response.route = convert_json_to_route(std::move(route));
+
+            if (simplification_tolerance_m_ > 0) {
+                simplify_route(response.route, simplification_tolerance_m_);
+            }
         }
 
         return response;
@@ -10,17 +10,24 @@
 #include "types.hpp"
 
 /// \brief Stateful functor that finds the shortest route for an O/D pair on request.
+/// \details The routing engine is thread-safe once initiated, so that one Router can be shared by
+/// platforms running concurrently (e.g. through std::reference_wrapper).
 class Router {
   public:
     /// \brief Constructor.
-    explicit Router(std::string _path_to_osrm_data);
+    /// \param _simplification_tolerance_m The tolerance in meters of simplifying the geometry of
+    /// the full routes (see simplify_route()), 0 to keep every pos.
+    explicit Router(std::string _path_to_osrm_data, double _simplification_tolerance_m = 0);
 
     /// \brief Main functor that finds the shortest route for an O/D pair on request.
-    RoutingResponse operator()(const Pos &origin, const Pos &destination, RoutingType type);
+    RoutingResponse operator()(const Pos &origin, const Pos &destination, RoutingType type) const;
 
   private:
     /// \brief The unique pointer to the osrm routing engine instance.
     std::unique_ptr<osrm::OSRM> osrm_ptr_;
+
+    /// \brief The tolerance in meters of simplifying the geometry of the full routes.
+    double simplification_tolerance_m_ = 0;
 };
 
 /// \brief Convert the json route data into the c++ data struct.
@@ -0,0 +1,106 @@
+/// \author Jian Wen
+/// \date 2021/03/05
+
+#include "config.hpp"
+#include "regression.hpp"
+#include "router.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <fmt/format.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+int main(int argc, const char *argv[]) {
+    // Check the input arugment list.
+    const auto update_baseline = argc == 6 && std::string{argv[5]} == "--update-baseline";
+    if (argc != 5 && !update_baseline) {
+        fmt::print(stderr,
+                   "[ERROR] We need 4 arguments aside from the program name for correct "
+                   "execution! \n"
+                   "- Usage: <prog name> <arg1> <arg2> <arg3> <arg4> [--update-baseline]. \n"
+                   "  <arg1> is the path to the regression config file. \n"
+                   "  <arg2> is the path to the orsm map data. \n"
+                   "  <arg3> is the path to the baseline file. \n"
+                   "  <arg4> is the path to the output json diff. \n"
+                   "  --update-baseline saves the current results as the baseline instead of "
+                   "checking against it. \n"
+                   "- Example: {} \"./config/regression.yml\" \"../osrm/map/hongkong.osrm\" "
+                   "\"./regression_baseline.yml\" \"./regression_diff.json\"\n",
+                   argv[0]);
+        return -1;
+    }
+
+    // A missing baseline would otherwise abort in the yaml parser with no hint of the cause.
+    if (!update_baseline && !std::ifstream{argv[3]}) {
+        fmt::print(stderr,
+                   "[ERROR] Failed to open the baseline file {}! Save the baseline on the "
+                   "reference build first, by running with --update-baseline.\n",
+                   argv[3]);
+        return -1;
+    }
+
+    const auto regression_config = load_regression_config(argv[1]);
+    const auto baseline =
+        update_baseline ? RegressionBaseline{} : load_regression_baseline(argv[3]);
+
+    // Initiate the router once, to be shared by all scenarios.
+    const auto route_simplification_m =
+        regression_config.scenarios[0].platform_config.simulation_config.route_simplification_m;
+    const Router router{argv[2], route_simplification_m};
+
+    RegressionBaseline current_baseline;
+    std::vector<MetricDiff> diffs;
+    for (const auto &scenario : regression_config.scenarios) {
+        fmt::print("[INFO] Running the regression scenario {} for {} times.\n",
+                   scenario.name,
+                   regression_config.num_repeats);
+        assert(scenario.platform_config.simulation_config.route_simplification_m ==
+                   route_simplification_m &&
+               "[ERROR] All scenarios must simplify the routes with the same tolerance!");
+
+        const auto metrics =
+            run_regression_scenario(scenario, router, regression_config.num_repeats);
+        for (const auto &metric : metrics) {
+            current_baseline[scenario.name][metric.name] = metric.value;
+        }
+
+        auto scenario_diffs = compare_regression_metrics(
+            scenario.name, metrics, baseline, regression_config.tolerances);
+        diffs.insert(diffs.end(), scenario_diffs.begin(), scenario_diffs.end());
+    }
+
+    if (update_baseline) {
+        save_regression_baseline(argv[3], current_baseline);
+        return 0;
+    }
+
+    // Output the diffs of all metrics, and print the failed ones.
+    auto output_file = std::fopen(argv[4], "w");
+    assert(output_file != nullptr && "[ERROR] Failed to create the output json diff!");
+    write_regression_diff(output_file, diffs);
+    std::fclose(output_file);
+
+    auto num_failures = 0;
+    for (const auto &diff : diffs) {
+        if (is_failed(diff)) {
+            fmt::print("[ERROR] {}/{}: baseline = {}, current = {}, tolerance = {}.\n",
+                       diff.scenario,
+                       diff.metric,
+                       diff.baseline,
+                       diff.current,
+                       diff.tolerance);
+            num_failures++;
+        }
+    }
+
+    fmt::print("[INFO] Regression check {} with {} of {} metrics failed. The diff is written to "
+               "{}.\n",
+               num_failures == 0 ? "passed" : "failed",
+               num_failures,
+               diffs.size(),
+               argv[4]);
+
+    return num_failures == 0 ? 0 : 1;
+}
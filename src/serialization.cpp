@@ -0,0 +1,96 @@
+/// \author Jian Wen
+/// \date 2021/02/22
+
+#include "serialization.hpp"
+
+void write_binary(std::ostream &out, const std::string &value) {
+    write_binary(out, static_cast<uint64_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+void read_binary(std::istream &in, std::string &value) {
+    uint64_t size = 0;
+    read_binary(in, size);
+    value.resize(in ? size : 0);
+    in.read(&value[0], value.size());
+}
+
+void write_binary(std::ostream &out, const Step &step) {
+    write_binary(out, step.distance_mm);
+    write_binary(out, step.duration_ms);
+    write_binary(out, step.poses);
+}
+
+void read_binary(std::istream &in, Step &step) {
+    read_binary(in, step.distance_mm);
+    read_binary(in, step.duration_ms);
+    read_binary(in, step.poses);
+}
+
+void write_binary(std::ostream &out, const Leg &leg) {
+    write_binary(out, leg.distance_mm);
+    write_binary(out, leg.duration_ms);
+    write_binary(out, leg.steps);
+}
+
+void read_binary(std::istream &in, Leg &leg) {
+    read_binary(in, leg.distance_mm);
+    read_binary(in, leg.duration_ms);
+    read_binary(in, leg.steps);
+}
+
+void write_binary(std::ostream &out, const Route &route) {
+    write_binary(out, route.distance_mm);
+    write_binary(out, route.duration_ms);
+    write_binary(out, route.legs);
+    write_binary(out, route.poses);
+    write_binary(out, route.time_offsets_ms);
+    write_binary(out, route.distance_offsets_mm);
+    write_binary(out, route.cursor);
+    write_binary(out, route.elapsed_ms);
+}
+
+void read_binary(std::istream &in, Route &route) {
+    read_binary(in, route.distance_mm);
+    read_binary(in, route.duration_ms);
+    read_binary(in, route.legs);
+    read_binary(in, route.poses);
+    read_binary(in, route.time_offsets_ms);
+    read_binary(in, route.distance_offsets_mm);
+    read_binary(in, route.cursor);
+    read_binary(in, route.elapsed_ms);
+}
+
+void write_binary(std::ostream &out, const Waypoint &waypoint) {
+    write_binary(out, waypoint.pos);
+    write_binary(out, waypoint.op);
+    write_binary(out, waypoint.trip_id);
+    write_binary(out, waypoint.route);
+}
+
+void read_binary(std::istream &in, Waypoint &waypoint) {
+    read_binary(in, waypoint.pos);
+    read_binary(in, waypoint.op);
+    read_binary(in, waypoint.trip_id);
+    read_binary(in, waypoint.route);
+}
+
+void write_binary(std::ostream &out, const Vehicle &vehicle) {
+    write_binary(out, vehicle.id);
+    write_binary(out, vehicle.pos);
+    write_binary(out, vehicle.capacity);
+    write_binary(out, vehicle.load);
+    write_binary(out, vehicle.waypoints);
+    write_binary(out, vehicle.dist_traveled_mm);
+    write_binary(out, vehicle.loaded_dist_traveled_mm);
+}
+
+void read_binary(std::istream &in, Vehicle &vehicle) {
+    read_binary(in, vehicle.id);
+    read_binary(in, vehicle.pos);
+    read_binary(in, vehicle.capacity);
+    read_binary(in, vehicle.load);
+    read_binary(in, vehicle.waypoints);
+    read_binary(in, vehicle.dist_traveled_mm);
+    read_binary(in, vehicle.loaded_dist_traveled_mm);
+}
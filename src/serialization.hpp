@@ -0,0 +1,54 @@
+/// \author Jian Wen
+/// \date 2021/02/22
+
+#pragma once
+
+#include "types.hpp"
+
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The binary format follows the in-memory layout of the host, e.g. size_t is written as is, so the
+// written data is only meant to be read back by the same build on the same platform.
+
+/// \brief Write a trivially copyable value to the binary stream as is.
+template <typename T> void write_binary(std::ostream &out, const T &value);
+
+/// \brief Read a trivially copyable value from the binary stream.
+template <typename T> void read_binary(std::istream &in, T &value);
+
+/// \brief Write a vector to the binary stream, prefixed by its size. The elements are written in
+/// bulk if trivially copyable, or one by one otherwise.
+template <typename T> void write_binary(std::ostream &out, const std::vector<T> &values);
+
+/// \brief Read a vector from the binary stream.
+template <typename T> void read_binary(std::istream &in, std::vector<T> &values);
+
+/// \brief Write/read a deque to/from the binary stream, in the same format as a vector with the
+/// elements written one by one.
+template <typename T> void write_binary(std::ostream &out, const std::deque<T> &values);
+template <typename T> void read_binary(std::istream &in, std::deque<T> &values);
+
+/// \brief Write/read a string to/from the binary stream, prefixed by its size.
+void write_binary(std::ostream &out, const std::string &value);
+void read_binary(std::istream &in, std::string &value);
+
+/// \brief Write/read the route types that hold vectors to/from the binary stream.
+void write_binary(std::ostream &out, const Step &step);
+void read_binary(std::istream &in, Step &step);
+void write_binary(std::ostream &out, const Leg &leg);
+void read_binary(std::istream &in, Leg &leg);
+void write_binary(std::ostream &out, const Route &route);
+void read_binary(std::istream &in, Route &route);
+
+/// \brief Write/read the vehicle types that hold vectors to/from the binary stream.
+void write_binary(std::ostream &out, const Waypoint &waypoint);
+void read_binary(std::istream &in, Waypoint &waypoint);
+void write_binary(std::ostream &out, const Vehicle &vehicle);
+void read_binary(std::istream &in, Vehicle &vehicle);
+
+// Implementation is put in a separate file for clarity and maintainability.
+#include "serialization_impl.hpp"
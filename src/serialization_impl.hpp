@@ -0,0 +1,81 @@
+/// \author Jian Wen
+/// \date 2021/02/22
+
+#pragma once
+
+#include "serialization.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+template <typename T> void write_binary(std::ostream &out, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable types can be written as is!");
+
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> void read_binary(std::istream &in, T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable types can be read as is!");
+
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+template <typename T> void write_binary(std::ostream &out, const std::vector<T> &values) {
+    write_binary(out, static_cast<uint64_t>(values.size()));
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    } else {
+        for (const auto &value : values) {
+            write_binary(out, value);
+        }
+    }
+}
+
+template <typename T> void read_binary(std::istream &in, std::vector<T> &values) {
+    uint64_t size = 0;
+    read_binary(in, size);
+
+    // Stop if the stream is truncated, instead of resizing to an arbitrary size.
+    if (!in) {
+        values.clear();
+        return;
+    }
+
+    values.resize(size);
+
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        in.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(T));
+    } else {
+        for (auto &value : values) {
+            read_binary(in, value);
+        }
+    }
+}
+
+template <typename T> void write_binary(std::ostream &out, const std::deque<T> &values) {
+    write_binary(out, static_cast<uint64_t>(values.size()));
+
+    for (const auto &value : values) {
+        write_binary(out, value);
+    }
+}
+
+template <typename T> void read_binary(std::istream &in, std::deque<T> &values) {
+    uint64_t size = 0;
+    read_binary(in, size);
+
+    // Stop if the stream is truncated, instead of resizing to an arbitrary size.
+    if (!in) {
+        values.clear();
+        return;
+    }
+
+    values.resize(size);
+
+    for (auto &value : values) {
+        read_binary(in, value);
+    }
+}
@@ -0,0 +1,233 @@
+/// \author Jian Wen
+/// \date 2021/02/21
+
+#include "config.hpp"
+#include "demand_generator.hpp"
+#include "kpi.hpp"
+#include "platform.hpp"
+#include "router.hpp"
+#include "trip_replayer.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <fmt/format.h>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// \brief A single simulation run in the sweep, i.e. one variant with one seed.
+struct SweepRun {
+    size_t fleet_size = 0;
+    size_t veh_capacity = 0;
+    double max_pickup_wait_time_s = 0.0;
+    uint64_t seed = 0;
+    SimulationReport report;
+    KpiAccumulator kpi_accumulator;
+};
+
+/// \brief Expand the grid of overrides into the runs of all variants and seeds.
+std::vector<SweepRun> expand_sweep_runs(const SweepConfig &sweep_config) {
+    std::vector<SweepRun> runs;
+
+    for (auto fleet_size : sweep_config.fleet_sizes) {
+        for (auto veh_capacity : sweep_config.veh_capacities) {
+            for (auto max_pickup_wait_time_s : sweep_config.max_pickup_wait_times_s) {
+                for (auto seed : sweep_config.seeds) {
+                    SweepRun run;
+                    run.fleet_size = fleet_size;
+                    run.veh_capacity = veh_capacity;
+                    run.max_pickup_wait_time_s = max_pickup_wait_time_s;
+                    run.seed = seed;
+
+                    runs.emplace_back(std::move(run));
+                }
+            }
+        }
+    }
+
+    return runs;
+}
+
+/// \brief Write the reports of all runs into one table in csv format.
+void write_sweep_table(std::FILE *file, const std::vector<SweepRun> &runs) {
+    fmt::print(file,
+               "fleet_size,veh_capacity,max_pickup_wait_time_s,seed,trip_count,"
+               "dispatched_trip_count,completed_trip_count,average_wait_time_s,"
+               "average_travel_time_s,p50_wait_time_s,p90_wait_time_s,p99_wait_time_s,"
+               "p50_travel_time_s,p90_travel_time_s,p99_travel_time_s,average_distance_traveled_m,"
+               "average_distance_traveled_per_hour_m,average_load,total_runtime_s,peak_route_bytes,"
+               "peak_trip_bytes,peak_datalog_bytes,peak_rss_bytes\n");
+
+    for (const auto &run : runs) {
+        fmt::print(file,
+                   "{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                   run.fleet_size,
+                   run.veh_capacity,
+                   run.max_pickup_wait_time_s,
+                   run.seed,
+                   run.report.trip_count,
+                   run.report.dispatched_trip_count,
+                   run.report.completed_trip_count,
+                   run.report.average_wait_time_s,
+                   run.report.average_travel_time_s,
+                   run.report.p50_wait_time_s,
+                   run.report.p90_wait_time_s,
+                   run.report.p99_wait_time_s,
+                   run.report.p50_travel_time_s,
+                   run.report.p90_travel_time_s,
+                   run.report.p99_travel_time_s,
+                   run.report.average_distance_traveled_m,
+                   run.report.average_distance_traveled_per_hour_m,
+                   run.report.average_load,
+                   run.report.total_runtime_s,
+                   run.report.peak_route_bytes,
+                   run.report.peak_trip_bytes,
+                   run.report.peak_datalog_bytes,
+                   run.report.peak_rss_bytes);
+    }
+}
+
+/// \brief Print the percentiles of each variant, with the KPIs of all its seeds merged into one.
+void print_merged_percentiles(const std::vector<SweepRun> &runs) {
+    for (auto i = 0; i < runs.size();) {
+        // The runs of the same variant are consecutive in the order of seeds.
+        auto kpi_accumulator = runs[i].kpi_accumulator;
+        auto j = i + 1;
+        for (; j < runs.size() && runs[j].fleet_size == runs[i].fleet_size &&
+               runs[j].veh_capacity == runs[i].veh_capacity &&
+               runs[j].max_pickup_wait_time_s == runs[i].max_pickup_wait_time_s;
+             j++) {
+            kpi_accumulator.merge(runs[j].kpi_accumulator);
+        }
+
+        const auto &wait_time_histogram = kpi_accumulator.get_wait_time_histogram();
+        const auto &travel_time_histogram = kpi_accumulator.get_travel_time_histogram();
+        fmt::print(" - fleet_size = {}, veh_capacity = {}, max_pickup_wait_time = {}s over {} "
+                   "seed(s): completed = {}, wait_time p50/p90/p99 = {}/{}/{}s, travel_time "
+                   "p50/p90/p99 = {}/{}/{}s.\n",
+                   runs[i].fleet_size,
+                   runs[i].veh_capacity,
+                   runs[i].max_pickup_wait_time_s,
+                   j - i,
+                   kpi_accumulator.get_total().completed_trip_count,
+                   wait_time_histogram.get_percentile_ms(0.5) / 1000.0,
+                   wait_time_histogram.get_percentile_ms(0.9) / 1000.0,
+                   wait_time_histogram.get_percentile_ms(0.99) / 1000.0,
+                   travel_time_histogram.get_percentile_ms(0.5) / 1000.0,
+                   travel_time_histogram.get_percentile_ms(0.9) / 1000.0,
+                   travel_time_histogram.get_percentile_ms(0.99) / 1000.0);
+
+        i = j;
+    }
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    // Check the input arugment list.
+    if (argc != 7) {
+        fmt::print(stderr,
+                   "[ERROR] We need 6 arguments aside from the program name for correct "
+                   "execution! \n"
+                   "- Usage: <prog name> <arg1> <arg2> <arg3> <arg4> <arg5> <arg6>. \n"
+                   "  <arg1> is the path to the base platform config file. \n"
+                   "  <arg2> is the path to the orsm map data. \n"
+                   "  <arg3> is the path to the demand config file, or to a binary trip file "
+                   "(*.trips) to be replayed. \n"
+                   "  <arg4> is the path to the sweep config file. \n"
+                   "  <arg5> is the number of simulations running concurrently. \n"
+                   "  <arg6> is the path to the output csv file. \n"
+                   "- Example: {} \"./config/platform_demo.yml\" \"../osrm/map/hongkong.osrm\" "
+                   "\"./config/demand_demo.yml\" \"./config/sweep_demo.yml\" 8 "
+                   "\"./sweep_demo.csv\"\n",
+                   argv[0]);
+        return -1;
+    }
+
+    // Load the base platform config. The runs do not output datalog, video or trace, which would
+    // otherwise be written to the same files.
+    auto base_platform_config = load_platform_config(argv[1]);
+    base_platform_config.output_config.datalog_config.output_datalog = false;
+    base_platform_config.output_config.video_config.render_video = false;
+    base_platform_config.output_config.trace_config.output_trace = false;
+
+    const auto sweep_config = load_sweep_config(argv[4], base_platform_config);
+    auto runs = expand_sweep_runs(sweep_config);
+
+    // Initiate the router once, to be shared by all runs.
+    const Router router{argv[2], base_platform_config.simulation_config.route_simplification_m};
+
+    // Load the demand once, to be shared by all runs. The runs with the same seed see the same
+    // requests (common random numbers), so that the variants are compared on the same demand.
+    const std::string path_to_demand = argv[3];
+    const std::string trip_file_extension = ".trips";
+    const auto replay_trips =
+        path_to_demand.size() > trip_file_extension.size() &&
+        path_to_demand.compare(path_to_demand.size() - trip_file_extension.size(),
+                               trip_file_extension.size(),
+                               trip_file_extension) == 0;
+
+    std::shared_ptr<const DemandModel> demand_model;
+    if (!replay_trips) {
+        demand_model = DemandGenerator{path_to_demand, 0}.get_demand_model();
+    }
+
+    // Each thread keeps taking the next run until all runs are done.
+    std::atomic<size_t> next_run_index{0};
+
+    auto simulate = [&]() {
+        for (auto i = next_run_index++; i < runs.size(); i = next_run_index++) {
+            auto &run = runs[i];
+
+            auto platform_config = base_platform_config;
+            platform_config.mod_system_config.fleet_config.fleet_size = run.fleet_size;
+            platform_config.mod_system_config.fleet_config.veh_capacity = run.veh_capacity;
+            platform_config.mod_system_config.request_config.max_pickup_wait_time_s =
+                run.max_pickup_wait_time_s;
+
+            if (replay_trips) {
+                Platform<std::reference_wrapper<const Router>, TripReplayer> platform{
+                    std::move(platform_config), std::cref(router), TripReplayer{path_to_demand}};
+                run.report = platform.run_simulation();
+                run.kpi_accumulator = platform.get_kpi_accumulator();
+            } else {
+                Platform<std::reference_wrapper<const Router>, DemandGenerator> platform{
+                    std::move(platform_config),
+                    std::cref(router),
+                    DemandGenerator{demand_model, run.seed}};
+                run.report = platform.run_simulation();
+                run.kpi_accumulator = platform.get_kpi_accumulator();
+            }
+        }
+    };
+
+    const auto num_threads = std::max<size_t>(1, std::stoul(argv[5]));
+
+    std::vector<std::thread> threads;
+    for (auto thread_index = 0; thread_index < num_threads; thread_index++) {
+        threads.emplace_back(simulate);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // Output the aggregated table of all runs.
+    auto output_file = std::fopen(argv[6], "w");
+    assert(output_file != nullptr && "[ERROR] Failed to create the output csv file of the sweep!");
+    write_sweep_table(output_file, runs);
+    std::fclose(output_file);
+
+    fmt::print("[INFO] Sweep completed with {} runs. Results are written to {}:\n",
+               runs.size(),
+               argv[6]);
+    write_sweep_table(stdout, runs);
+
+    fmt::print("[INFO] Percentiles of each variant over all seeds:\n");
+    print_merged_percentiles(runs);
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/// \author Jian Wen
+/// \date 2021/03/06
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t _num_threads) {
+    for (auto i = 1; i < std::max<size_t>(1, _num_threads); i++) {
+        worker_threads_.emplace_back(&ThreadPool::run_worker, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    condition_variable_.notify_all();
+
+    for (auto &worker_thread : worker_threads_) {
+        worker_thread.join();
+    }
+}
+
+void ThreadPool::run(const std::function<void()> &task) {
+    if (worker_threads_.empty()) {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        task_ = &task;
+        num_runs_++;
+        num_busy_workers_ = worker_threads_.size();
+    }
+    condition_variable_.notify_all();
+
+    task();
+
+    // The task must outlive the run, so wait until all workers are done with it.
+    std::unique_lock<std::mutex> lock{mutex_};
+    condition_variable_.wait(lock, [this] { return num_busy_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::run_worker() {
+    uint64_t num_runs_done = 0;
+
+    while (true) {
+        std::unique_lock<std::mutex> lock{mutex_};
+        condition_variable_.wait(lock, [&] { return num_runs_ > num_runs_done || stopping_; });
+        if (stopping_) {
+            break;
+        }
+
+        const auto &task = *task_;
+        num_runs_done = num_runs_;
+        lock.unlock();
+
+        task();
+
+        lock.lock();
+        if (--num_busy_workers_ == 0) {
+            condition_variable_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/// \author Jian Wen
+/// \date 2021/03/06
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \brief The pool of worker threads that are started once and reused to run tasks in parallel.
+/// \details Each run hands the same task to all threads, which then split the work among
+/// themselves, e.g. by taking the next item from an atomic counter. The calling thread joins in as
+/// one of the threads, so a pool of 1 thread runs the task serially without any worker.
+class ThreadPool {
+  public:
+    /// \brief Constructor that starts the worker threads.
+    /// \param _num_threads The number of threads running each task, including the calling thread.
+    explicit ThreadPool(size_t _num_threads);
+
+    /// \brief Destructor that stops the worker threads.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// \brief Get the number of threads running each task, including the calling thread.
+    size_t get_num_threads() const { return worker_threads_.size() + 1; }
+
+    /// \brief Run the task on all threads, and block until it returns on each of them.
+    void run(const std::function<void()> &task);
+
+  private:
+    /// \brief The main loop of the worker threads.
+    void run_worker();
+
+    /// \brief The mutex that guards the states below.
+    std::mutex mutex_;
+
+    /// \brief The condition variable to notify the changes of the states below.
+    std::condition_variable condition_variable_;
+
+    /// \brief The task of the current run.
+    const std::function<void()> *task_ = nullptr;
+
+    /// \brief The number of runs started so far, which tells the workers a new task is there.
+    uint64_t num_runs_ = 0;
+
+    /// \brief The number of worker threads yet to finish the task of the current run.
+    size_t num_busy_workers_ = 0;
+
+    /// \brief True if the pool is being destroyed.
+    bool stopping_ = false;
+
+    /// \brief The worker threads, started after all other members are initialized.
+    std::vector<std::thread> worker_threads_;
+};
@@ -0,0 +1,109 @@
+/// \author Jian Wen
+/// \date 2021/03/03
+
+#include "tracer.hpp"
+
+#include <fmt/format.h>
+
+#include <cassert>
+
+void write_chrome_trace(std::FILE *file,
+                        const std::vector<std::shared_ptr<TraceBuffer>> &buffers) {
+    fmt::print(file, "{{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    // Name the row of each thread, and then write the spans as complete events in microseconds.
+    auto first = true;
+    for (const auto &buffer : buffers) {
+        fmt::print(file,
+                   "{}{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": {}, "
+                   "\"args\": {{\"name\": \"thread {}\"}}}}",
+                   first ? "" : ",\n",
+                   buffer->thread_index,
+                   buffer->thread_index);
+        first = false;
+    }
+
+    for (const auto &buffer : buffers) {
+        for (const auto &event : buffer->events) {
+            fmt::print(file,
+                       ",\n{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": 0, \"tid\": {}, "
+                       "\"ts\": {:.3f}, \"dur\": {:.3f}",
+                       event.name,
+                       buffer->thread_index,
+                       event.start_ns / 1000.0,
+                       event.duration_ns / 1000.0);
+
+            if (event.router_ns > 0) {
+                fmt::print(file, ", \"args\": {{\"router_ms\": {:.6f}}}", event.router_ns / 1e6);
+            }
+            fmt::print(file, "}}");
+        }
+    }
+
+    fmt::print(file, "\n]}}\n");
+}
+
+/// \brief The buffer of the calling thread, which is returned to the tracer when the thread exits.
+struct ThreadTraceBuffer {
+    ThreadTraceBuffer() : buffer(Tracer::get_instance().acquire_buffer()) {}
+
+    ~ThreadTraceBuffer() { Tracer::get_instance().release_buffer(std::move(buffer)); }
+
+    std::shared_ptr<TraceBuffer> buffer;
+};
+
+Tracer &Tracer::get_instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::start() {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    for (auto &buffer : buffers_) {
+        buffer->events.clear();
+        buffer->router_ns = 0;
+    }
+    start_time_ = std::chrono::steady_clock::now();
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop() { enabled_.store(false, std::memory_order_relaxed); }
+
+TraceBuffer &Tracer::get_thread_buffer() {
+    thread_local ThreadTraceBuffer thread_buffer;
+    return *thread_buffer.buffer;
+}
+
+void Tracer::write_trace(const std::string &path_to_trace) {
+    auto file = std::fopen(path_to_trace.c_str(), "w");
+    assert(file != nullptr && "[ERROR] Failed to create the trace file!");
+
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        write_chrome_trace(file, buffers_);
+    }
+
+    std::fclose(file);
+}
+
+std::shared_ptr<TraceBuffer> Tracer::acquire_buffer() {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    if (!free_buffers_.empty()) {
+        auto buffer = std::move(free_buffers_.back());
+        free_buffers_.pop_back();
+        return buffer;
+    }
+
+    auto buffer = std::make_shared<TraceBuffer>();
+    buffer->thread_index = buffers_.size();
+    buffers_.emplace_back(buffer);
+
+    return buffer;
+}
+
+void Tracer::release_buffer(std::shared_ptr<TraceBuffer> buffer) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    free_buffers_.emplace_back(std::move(buffer));
+}
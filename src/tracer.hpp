@@ -0,0 +1,158 @@
+/// \author Jian Wen
+/// \date 2021/03/03
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// \brief The span of a traced phase, timed in nanoseconds since the tracer started.
+struct TraceEvent {
+    const char *name = "";    // the name of the phase, a string literal
+    uint64_t start_ns = 0;    // the start time of the span
+    uint64_t duration_ns = 0; // the duration of the span
+    uint64_t router_ns = 0;   // the time spent in the router within the span
+};
+
+/// \brief The buffer of the trace events recorded by one thread.
+struct TraceBuffer {
+    size_t thread_index = 0;        // the index of the thread in the trace
+    std::vector<TraceEvent> events; // the events in the order they end
+    uint64_t router_ns = 0;         // the total time spent in the router by the thread
+};
+
+/// \brief Write the events of all buffers as a Chrome trace in json, which can be opened in
+/// chrome://tracing or Perfetto.
+void write_chrome_trace(std::FILE *file, const std::vector<std::shared_ptr<TraceBuffer>> &buffers);
+
+/// \brief The tracer that records the spans of the simulation phases on all threads.
+/// \details Each thread that traces records its spans into its own buffer, created on its first
+/// span, so that tracing takes no lock. The long-lived workers of the thread pool that dispatches
+/// the zones thus each keep their own row in the trace for the whole run. The buffer of an exited
+/// thread is reused by the next new thread, so that the threads of an earlier platform, e.g. in a
+/// sweep, don't add rows. The trace is only exported once no thread is tracing, i.e. the pool is
+/// idle and the datalog writer thread has been joined.
+class Tracer {
+  public:
+    /// \brief Get the tracer shared by all threads.
+    static Tracer &get_instance();
+
+    /// \brief True if the spans are being recorded, which is cheap to check on any thread.
+    static bool is_enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /// \brief Drop the spans recorded so far and start recording.
+    void start();
+
+    /// \brief Stop recording.
+    void stop();
+
+    /// \brief Get the time in nanoseconds since the tracer started.
+    uint64_t get_time_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start_time_)
+            .count();
+    }
+
+    /// \brief Get the buffer of the calling thread, created on first use.
+    TraceBuffer &get_thread_buffer();
+
+    /// \brief Write the spans recorded on all threads into the Chrome trace file.
+    void write_trace(const std::string &path_to_trace);
+
+  private:
+    /// \brief Constructor.
+    Tracer() = default;
+
+    /// \brief Take a free buffer, or create one, for the calling thread.
+    std::shared_ptr<TraceBuffer> acquire_buffer();
+
+    /// \brief Return the buffer of an exiting thread for the next new thread.
+    void release_buffer(std::shared_ptr<TraceBuffer> buffer);
+
+    friend struct ThreadTraceBuffer;
+
+    /// \brief True if the spans are being recorded.
+    inline static std::atomic<bool> enabled_{false};
+
+    /// \brief The time the tracer started.
+    std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+
+    /// \brief The mutex that guards the lists of buffers.
+    std::mutex mutex_;
+
+    /// \brief The buffers of all threads that have traced.
+    std::vector<std::shared_ptr<TraceBuffer>> buffers_ = {};
+
+    /// \brief The buffers of the exited threads.
+    std::vector<std::shared_ptr<TraceBuffer>> free_buffers_ = {};
+};
+
+/// \brief The scoped span of a traced phase, which costs a relaxed load if tracing is off.
+class TraceSpan {
+  public:
+    /// \brief Constructor that starts the span.
+    /// \param _name The name of the phase, which must be a string literal.
+    explicit TraceSpan(const char *_name) {
+        if (Tracer::is_enabled()) {
+            auto &tracer = Tracer::get_instance();
+            buffer_ = &tracer.get_thread_buffer();
+            event_.name = _name;
+            event_.start_ns = tracer.get_time_ns();
+            event_.router_ns = buffer_->router_ns;
+        }
+    }
+
+    /// \brief Destructor that records the span.
+    ~TraceSpan() {
+        if (buffer_ != nullptr) {
+            event_.duration_ns = Tracer::get_instance().get_time_ns() - event_.start_ns;
+            event_.router_ns = buffer_->router_ns - event_.router_ns;
+            buffer_->events.emplace_back(event_);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+  private:
+    /// \brief The buffer of the thread, null if tracing is off.
+    TraceBuffer *buffer_ = nullptr;
+
+    /// \brief The span being recorded.
+    TraceEvent event_;
+};
+
+/// \brief The router func that adds the time of each query to the router time of the thread, so
+/// that the spans can tell the routing apart from the rest.
+template <typename RouterFunc> class TracedRouterFunc {
+  public:
+    /// \brief Constructor.
+    explicit TracedRouterFunc(RouterFunc &_router_func) : router_func_(_router_func) {}
+
+    /// \brief Route through the wrapped router func.
+    template <typename... Args> auto operator()(Args &&...args) const {
+        if (!Tracer::is_enabled()) {
+            return router_func_(std::forward<Args>(args)...);
+        }
+
+        auto &tracer = Tracer::get_instance();
+        auto &buffer = tracer.get_thread_buffer();
+        const auto start_ns = tracer.get_time_ns();
+        auto response = router_func_(std::forward<Args>(args)...);
+        buffer.router_ns += tracer.get_time_ns() - start_ns;
+
+        return response;
+    }
+
+  private:
+    /// \brief The wrapped router func.
+    RouterFunc &router_func_;
+};
@@ -0,0 +1,146 @@
+/// \author Jian Wen
+/// \date 2021/02/19
+
+#include "trip_replayer.hpp"
+#include "serialization.hpp"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+TripReplayer::TripReplayer(const std::string &_path_to_trip_file) {
+    const auto fd = open(_path_to_trip_file.c_str(), O_RDONLY);
+    assert(fd >= 0 && "[ERROR] Failed to open the trip file in TripReplayer!");
+
+    struct stat file_stat;
+    fstat(fd, &file_stat);
+    mapped_size_ = file_stat.st_size;
+    assert(mapped_size_ >= sizeof(TripFileHeader) &&
+           "[ERROR] The trip file is too small to contain a header in TripReplayer!");
+
+    // The mapping stays valid after the file descriptor is closed.
+    mapped_data_ = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    assert(mapped_data_ != MAP_FAILED && "[ERROR] Failed to map the trip file in TripReplayer!");
+
+    // The records are read front to back exactly once.
+    madvise(mapped_data_, mapped_size_, MADV_SEQUENTIAL);
+
+    const auto &header = *static_cast<const TripFileHeader *>(mapped_data_);
+    assert(std::memcmp(header.magic, kTripFileMagic, sizeof(kTripFileMagic)) == 0 &&
+           "[ERROR] The file is not a binary trip file in TripReplayer!");
+    assert(header.version == kTripFileVersion && header.record_size == sizeof(TripRecord) &&
+           "[ERROR] The binary trip file has an unsupported version in TripReplayer!");
+    assert(mapped_size_ == sizeof(TripFileHeader) + header.num_trips * sizeof(TripRecord) &&
+           "[ERROR] The binary trip file is truncated in TripReplayer!");
+
+    num_trips_ = header.num_trips;
+    records_ = reinterpret_cast<const TripRecord *>(static_cast<const char *>(mapped_data_) +
+                                                    sizeof(TripFileHeader));
+
+    fmt::print("[INFO] Mapped trip file {} with {} trips.\n", _path_to_trip_file, num_trips_);
+}
+
+TripReplayer::~TripReplayer() {
+    if (mapped_data_ != nullptr) {
+        munmap(mapped_data_, mapped_size_);
+    }
+}
+
+TripReplayer::TripReplayer(TripReplayer &&other) noexcept
+    : system_time_ms_(other.system_time_ms_), mapped_data_(other.mapped_data_),
+      mapped_size_(other.mapped_size_), records_(other.records_), num_trips_(other.num_trips_),
+      cursor_(other.cursor_), released_size_(other.released_size_) {
+    other.mapped_data_ = nullptr;
+    other.records_ = nullptr;
+    other.num_trips_ = 0;
+}
+
+std::vector<Request> TripReplayer::operator()(uint64_t target_system_time_ms) {
+    assert(system_time_ms_ <= target_system_time_ms &&
+           "[ERROR] The target_system_time should be no less than the current system time in "
+           "TripReplayer!");
+
+    // System time moves to the target.
+    system_time_ms_ = target_system_time_ms;
+
+    // Replay the records until the target time.
+    std::vector<Request> requests;
+
+    while (cursor_ < num_trips_ && records_[cursor_].request_time_ms <= system_time_ms_) {
+        const auto &record = records_[cursor_++];
+        requests.push_back({record.origin, record.destination, record.request_time_ms});
+    }
+
+    release_replayed_pages();
+
+    return requests;
+}
+
+void TripReplayer::save_state(std::ostream &out) const {
+    write_binary(out, num_trips_);
+    write_binary(out, system_time_ms_);
+    write_binary(out, cursor_);
+}
+
+void TripReplayer::load_state(std::istream &in) {
+    size_t num_trips = 0;
+
+    read_binary(in, num_trips);
+    read_binary(in, system_time_ms_);
+    read_binary(in, cursor_);
+
+    assert(num_trips == num_trips_ && cursor_ <= num_trips_ &&
+           "[ERROR] The saved state does not match the trip file in TripReplayer!");
+
+    release_replayed_pages();
+}
+
+void TripReplayer::release_replayed_pages() {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+
+    // Only release whole pages that have been replayed, in chunks of at least 1 MB.
+    const auto replayed_size = sizeof(TripFileHeader) + cursor_ * sizeof(TripRecord);
+    const auto releasable_size = replayed_size / page_size * page_size;
+
+    if (releasable_size < released_size_ + (1 << 20) && cursor_ < num_trips_) {
+        return;
+    }
+
+    if (releasable_size > released_size_) {
+        madvise(static_cast<char *>(mapped_data_) + released_size_,
+                releasable_size - released_size_,
+                MADV_DONTNEED);
+        released_size_ = releasable_size;
+    }
+}
+
+void write_trip_file(const std::string &path_to_trip_file, const std::vector<Request> &requests) {
+    assert(std::is_sorted(requests.begin(),
+                          requests.end(),
+                          [](const Request &a, const Request &b) {
+                              return a.request_time_ms < b.request_time_ms;
+                          }) &&
+           "[ERROR] The requests must be in increasing order of time in the trip file!");
+
+    std::ofstream out{path_to_trip_file, std::ios::binary};
+    assert(out && "[ERROR] Failed to create the trip file!");
+
+    TripFileHeader header;
+    std::memcpy(header.magic, kTripFileMagic, sizeof(kTripFileMagic));
+    header.record_size = sizeof(TripRecord);
+    header.num_trips = requests.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (const auto &request : requests) {
+        TripRecord record{request.request_time_ms, request.origin, request.destination};
+        out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+}
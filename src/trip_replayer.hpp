@@ -0,0 +1,100 @@
+/// \author Jian Wen
+/// \date 2021/02/19
+
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// \brief The magic number at the beginning of a binary trip file.
+constexpr char kTripFileMagic[8] = {'M', 'O', 'D', 'T', 'R', 'I', 'P', '\0'};
+
+/// \brief The version of the binary trip file format.
+constexpr uint32_t kTripFileVersion = 1;
+
+/// \brief The header of a binary trip file, followed by num_trips TripRecords in increasing order
+/// of request time.
+struct TripFileHeader {
+    char magic[8];
+    uint32_t version = kTripFileVersion;
+    uint32_t record_size = 0;
+    uint64_t num_trips = 0;
+};
+
+/// \brief The record of a trip in the binary trip file, 24 bytes without padding.
+struct TripRecord {
+    uint64_t request_time_ms = 0;
+    Pos origin;
+    Pos destination;
+};
+
+static_assert(sizeof(TripFileHeader) == 24, "TripFileHeader must be packed!");
+static_assert(sizeof(TripRecord) == 24, "TripRecord must be packed!");
+
+/// \brief Stateful functor that replays the recorded trips in a binary trip file.
+/// \details The file is memory mapped and read sequentially through a cursor, so that startup is
+/// instant and memory is flat regardless of the file size. The pages that have been replayed are
+/// released as the cursor moves on.
+class TripReplayer {
+  public:
+    /// \brief Constructor.
+    /// \param _path_to_trip_file The path to the binary trip file.
+    explicit TripReplayer(const std::string &_path_to_trip_file);
+
+    /// \brief Destructor that unmaps the file.
+    ~TripReplayer();
+
+    /// \brief Move constructor, which takes over the mapping.
+    TripReplayer(TripReplayer &&other) noexcept;
+
+    TripReplayer(const TripReplayer &) = delete;
+    TripReplayer &operator=(const TripReplayer &) = delete;
+    TripReplayer &operator=(TripReplayer &&) = delete;
+
+    /// \brief Main functor that replays the requests til the target system time.
+    std::vector<Request> operator()(uint64_t target_system_time_ms);
+
+    /// \brief Save the state of replay into the binary stream, to be restored by load_state.
+    void save_state(std::ostream &out) const;
+
+    /// \brief Restore the state of replay from the binary stream.
+    void load_state(std::istream &in);
+
+    /// \brief Get the total number of trips in the file.
+    size_t get_num_trips() const { return num_trips_; }
+
+  private:
+    /// \brief Release the pages of the records that have been replayed.
+    void release_replayed_pages();
+
+    /// \brief The system time starting from 0.
+    uint64_t system_time_ms_ = 0;
+
+    /// \brief The start of the mapped file.
+    void *mapped_data_ = nullptr;
+
+    /// \brief The size of the mapped file in bytes.
+    size_t mapped_size_ = 0;
+
+    /// \brief The records in the mapped file.
+    const TripRecord *records_ = nullptr;
+
+    /// \brief The number of records in the file.
+    size_t num_trips_ = 0;
+
+    /// \brief The index of the next record to be replayed.
+    size_t cursor_ = 0;
+
+    /// \brief The number of bytes at the beginning of the file that have been released.
+    size_t released_size_ = 0;
+};
+
+/// \brief Write the requests into a binary trip file that can be replayed by TripReplayer.
+/// \param requests The requests in increasing order of request time.
+void write_trip_file(const std::string &path_to_trip_file, const std::vector<Request> &requests);
@@ -5,6 +5,7 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <deque>
 #include <osrm/json_container.hpp>
 #include <string>
 
@@ -34,10 +35,19 @@ struct Leg {
 };
 
 /// \brief Route consisting of total distance, total duration as well as a vector of legs.
+/// \details Once the route is assigned to a vehicle, the legs are flattened into a single polyline
+/// with the cumulative time and distance at each pose (see build_route_track()). The progress along
+/// the route is then tracked by a cursor into the polyline instead of truncating the legs, while
+/// distance_mm and duration_ms always refer to the remaining part of the route.
 struct Route {
     int32_t distance_mm = 0;
     int32_t duration_ms = 0;
     std::vector<Leg> legs;
+    std::vector<Pos> poses = {};                  // the flattened polyline of all steps
+    std::vector<int32_t> time_offsets_ms = {};     // the time to reach each pose from the start
+    std::vector<int32_t> distance_offsets_mm = {}; // the distance to reach each pose from the start
+    size_t cursor = 0;      // the index of the pose starting the segment the vehicle is on
+    int32_t elapsed_ms = 0; // the time already traveled along the polyline
 };
 
 /// \brief The type of the routing call.
@@ -66,19 +76,22 @@ struct RoutingResponse {
 /// Trip Types
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-/// \brief A single demand OD with accumulated probability.
-/// \details The accumulated probability of a OD is a double between (0, 1]. We use these to form
-/// a list of ODs with increasing probs to be able to generate a random request based on each OD's
-/// trip intensity. For example, the first OD has a probability of 0.1 among all trips and the
-/// accumulated prob will be 0.1. The second OD has a probability of 0.1 and the accumulated prob
-/// will be 0.2 (0.1 + 0.1). The third OD has a probability of 0.05 and the accumulated prob in
-/// this case will be 0.25 (0.2 + 0.05). To generate a trip, we generate a random number between
-/// 0 and 1. If the random number falls into [0.1, 0.2), the origin/destination of the generated
-/// trip will be based on the second OD.
-struct OdWithProb {
+/// \brief A single demand OD.
+struct Od {
     Pos origin;
     Pos destination;
-    double accumulated_prob;
+};
+
+/// \brief An entry of the alias table that samples ODs based on their trip intensities.
+/// \details We use Walker's alias method (with Vose's construction) so that sampling takes O(1)
+/// time regardless of the number of ODs. The table has one entry per OD. To sample, we pick an
+/// entry i uniformly at random, then flip a biased coin: with probability prob the sampled OD is i,
+/// otherwise it is alias. For example, with two ODs of probabilities 0.25 and 0.75, entry 0 has
+/// prob 0.5 and alias 1, and entry 1 has prob 1.0. OD 0 is then sampled with probability
+/// 0.5 * 0.5 = 0.25. Each entry takes 8 bytes, so a sample touches a single cache line.
+struct AliasEntry {
+    float prob = 1.0;
+    uint32_t alias = 0;
 };
 
 /// \brief The trip request generated by the demand generator.
@@ -153,8 +166,41 @@ struct Vehicle {
     Pos pos;
     size_t capacity = 1;
     size_t load = 0;
-    std::vector<Waypoint> waypoints = {};
+    std::deque<Waypoint> waypoints = {}; // popped from the front as the vehicle reaches them
     int32_t dist_traveled_mm = 0; // accumulated distance traveled in meters
     int32_t loaded_dist_traveled_mm =
         0; // accumulated distance traveled, weighted by the load, in meters
 };
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// Report Types
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \brief The key performance indicators of a simulation, counting the trips requested during the
+/// main simulation.
+struct SimulationReport {
+    double total_runtime_s = 0.0;                      // total wall-clock runtime in seconds
+    double advance_runtime_s = 0.0;                    // runtime of advancing the vehicles
+    double demand_runtime_s = 0.0;                     // runtime of generating the trips
+    double dispatch_runtime_s = 0.0;                   // runtime of dispatching the trips
+    double datalog_runtime_s = 0.0;                    // runtime of capturing the datalog frames
+    size_t trip_count = 0;                             // number of trips requested
+    size_t dispatched_trip_count = 0;                  // number of trips dispatched
+    size_t completed_trip_count = 0;                   // number of trips dropped off
+    double average_wait_time_s = 0.0;                  // average wait time of completed trips
+    double average_travel_time_s = 0.0;                // average travel time of completed trips
+    double p50_wait_time_s = 0.0;                      // median wait time of completed trips
+    double p90_wait_time_s = 0.0;                      // 90th percentile wait time
+    double p99_wait_time_s = 0.0;                      // 99th percentile wait time
+    double p50_travel_time_s = 0.0;                    // median travel time of completed trips
+    double p90_travel_time_s = 0.0;                    // 90th percentile travel time
+    double p99_travel_time_s = 0.0;                    // 99th percentile travel time
+    double average_distance_traveled_m = 0.0;          // average distance traveled per vehicle
+    double average_distance_traveled_per_hour_m = 0.0; // the above per hour of main sim
+    double average_load = 0.0;                         // average load weighted by distance
+    size_t peak_route_bytes = 0;                       // peak bytes held in the route geometry
+    size_t peak_trip_bytes = 0;                        // peak bytes held in the trips
+    size_t peak_datalog_bytes = 0;                     // peak bytes held in the datalog buffers
+    size_t peak_rss_bytes = 0;                         // peak resident set size of the process
+    size_t peak_rss_growth_bytes = 0;                  // peak rss in the cycles over the start
+};
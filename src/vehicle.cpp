@@ -2,8 +2,11 @@
 /// \date 2021/02/08
 
 #include "vehicle.hpp"
+#include "geo.hpp"
+#include "logger.hpp"
 
-#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
 
 void truncate_step_by_time(Step &step, uint64_t time_ms) {
     assert(step.poses.size() >= 2 &&
@@ -24,8 +27,8 @@ void truncate_step_by_time(Step &step, uint64_t time_ms) {
     // Get the total distance of the step. We use Mahhantan distance for simplicity.
     auto total_dist = 0.0;
     for (auto i = 0; i < step.poses.size() - 1; i++) {
-        total_dist += abs(step.poses[i].lat - step.poses[i + 1].lat) +
-                      abs(step.poses[i].lon - step.poses[i + 1].lon);
+        total_dist += std::abs(step.poses[i].lat - step.poses[i + 1].lat) +
+                      std::abs(step.poses[i].lon - step.poses[i + 1].lon);
     }
 
     // Compute the distance to be truncated.
@@ -34,8 +37,8 @@ void truncate_step_by_time(Step &step, uint64_t time_ms) {
     // Iterate through the poses for the target distance.
     auto accumulated_dist = 0.0;
     for (auto i = 0; i < step.poses.size() - 1; i++) {
-        auto dist = abs(step.poses[i].lat - step.poses[i + 1].lat) +
-                    abs(step.poses[i].lon - step.poses[i + 1].lon);
+        auto dist = std::abs(step.poses[i].lat - step.poses[i + 1].lat) +
+                    std::abs(step.poses[i].lon - step.poses[i + 1].lon);
 
         if (accumulated_dist + dist > truncated_dist) {
             auto subratio = (truncated_dist - accumulated_dist) / dist;
@@ -161,20 +164,158 @@ void truncate_route_by_time(Route &route, uint64_t time_ms) {
            "Output route's duration in truncate_route_by_time() must be positive!");
 }
 
+void simplify_route(Route &route, double tolerance_m) {
+    for (auto &leg : route.legs) {
+        for (auto &step : leg.steps) {
+            step.poses = simplify_polyline(step.poses, tolerance_m);
+        }
+    }
+}
+
+void build_route_track(Route &route) {
+    route.poses.clear();
+    route.time_offsets_ms.clear();
+    route.distance_offsets_mm.clear();
+    route.cursor = 0;
+    route.elapsed_ms = 0;
+
+    // Accumulate the raw offsets step by step. They are scaled to the route totals later on.
+    std::vector<double> time_offsets_ms;
+    std::vector<double> distance_offsets_mm;
+    auto step_start_time_ms = 0.0;
+    auto step_start_distance_mm = 0.0;
+
+    for (const auto &leg : route.legs) {
+        for (const auto &step : leg.steps) {
+            // Get the total distance of the step. We use Mahhantan distance for simplicity.
+            auto total_dist = 0.0;
+            for (auto i = 0; i + 1 < step.poses.size(); i++) {
+                total_dist += std::abs(step.poses[i].lat - step.poses[i + 1].lat) +
+                              std::abs(step.poses[i].lon - step.poses[i + 1].lon);
+            }
+
+            auto accumulated_dist = 0.0;
+            for (auto i = 0; i < step.poses.size(); i++) {
+                if (i > 0) {
+                    accumulated_dist += std::abs(step.poses[i - 1].lat - step.poses[i].lat) +
+                                        std::abs(step.poses[i - 1].lon - step.poses[i].lon);
+                }
+
+                const auto ratio = total_dist > 0 ? accumulated_dist / total_dist : 0.0;
+                const auto time_ms = step_start_time_ms + ratio * step.duration_ms;
+                const auto distance_mm = step_start_distance_mm + ratio * step.distance_mm;
+
+                // Skip the pose if it duplicates the previous one, e.g. where two steps meet.
+                if (!route.poses.empty() && route.poses.back().lon == step.poses[i].lon &&
+                    route.poses.back().lat == step.poses[i].lat &&
+                    time_offsets_ms.back() == time_ms) {
+                    continue;
+                }
+
+                route.poses.emplace_back(step.poses[i]);
+                time_offsets_ms.emplace_back(time_ms);
+                distance_offsets_mm.emplace_back(distance_mm);
+            }
+
+            step_start_time_ms += step.duration_ms;
+            step_start_distance_mm += step.distance_mm;
+        }
+    }
+
+    // Scale the offsets so that the polyline ends exactly with the route totals.
+    const auto time_scale = step_start_time_ms > 0 ? route.duration_ms / step_start_time_ms : 0.0;
+    const auto distance_scale =
+        step_start_distance_mm > 0 ? route.distance_mm / step_start_distance_mm : 0.0;
+
+    route.time_offsets_ms.reserve(time_offsets_ms.size());
+    route.distance_offsets_mm.reserve(distance_offsets_mm.size());
+    for (auto i = 0; i < route.poses.size(); i++) {
+        route.time_offsets_ms.emplace_back(std::lround(time_offsets_ms[i] * time_scale));
+        route.distance_offsets_mm.emplace_back(
+            std::lround(distance_offsets_mm[i] * distance_scale));
+    }
+
+    route.legs.clear();
+    route.legs.shrink_to_fit();
+}
+
+void advance_route_by_time(Route &route, uint64_t time_ms) {
+    assert(time_ms < route.duration_ms &&
+           "Time in advance_route_by_time() must be less than route's duration!");
+
+    // Early return.
+    if (time_ms == 0) {
+        return;
+    }
+
+    if (route.poses.empty() && !route.legs.empty()) {
+        build_route_track(route);
+    }
+
+    // Without geometry, we could only shrink the remaining distance proportionally.
+    if (route.poses.size() < 2 || route.time_offsets_ms.back() == 0) {
+        route.distance_mm -= static_cast<int64_t>(route.distance_mm) * time_ms / route.duration_ms;
+        route.duration_ms -= time_ms;
+        route.elapsed_ms += time_ms;
+        return;
+    }
+
+    route.elapsed_ms += time_ms;
+    route.duration_ms = route.time_offsets_ms.back() - route.elapsed_ms;
+
+    // Find the segment [cursor, cursor + 1) that contains the elapsed time. The cursor only moves
+    // forward, so we search from the current one.
+    auto it = std::upper_bound(route.time_offsets_ms.begin() + route.cursor,
+                               route.time_offsets_ms.end(),
+                               route.elapsed_ms);
+    route.cursor = std::distance(route.time_offsets_ms.begin(), it) - 1;
+
+    const auto i = route.cursor;
+    const auto ratio = static_cast<double>(route.elapsed_ms - route.time_offsets_ms[i]) /
+                       (route.time_offsets_ms[i + 1] - route.time_offsets_ms[i]);
+    const auto distance_traveled_mm =
+        route.distance_offsets_mm[i] +
+        ratio * (route.distance_offsets_mm[i + 1] - route.distance_offsets_mm[i]);
+    route.distance_mm = route.distance_offsets_mm.back() - std::lround(distance_traveled_mm);
+
+    assert(route.duration_ms > 0 &&
+           "Output route's duration in advance_route_by_time() must be positive!");
+}
+
+Pos get_current_pos_on_route(const Route &route) {
+    assert(!route.poses.empty() && "Route in get_current_pos_on_route() must have a polyline!");
+
+    const auto i = route.cursor;
+    if (i + 1 >= route.poses.size() || route.time_offsets_ms[i + 1] == route.time_offsets_ms[i]) {
+        return route.poses[i];
+    }
+
+    const auto ratio = static_cast<double>(route.elapsed_ms - route.time_offsets_ms[i]) /
+                       (route.time_offsets_ms[i + 1] - route.time_offsets_ms[i]);
+
+    return {static_cast<float>(route.poses[i].lon +
+                               ratio * (route.poses[i + 1].lon - route.poses[i].lon)),
+            static_cast<float>(route.poses[i].lat +
+                               ratio * (route.poses[i + 1].lat - route.poses[i].lat))};
+}
+
 void advance_vehicle(Vehicle &vehicle,
                      std::vector<Trip> &trips,
                      uint64_t system_time_ms,
                      uint64_t time_ms,
-                     bool update_vehicle_stats) {
-    // Early return.
-    if (time_ms == 0) {
+                     bool update_vehicle_stats,
+                     KpiAccumulator *kpi_accumulator) {
+    // Early return, unless the first waypoint takes no time to reach (e.g. a pickup right where the
+    // vehicle is), which is still completed.
+    if (time_ms == 0 &&
+        (vehicle.waypoints.empty() || vehicle.waypoints.front().route.duration_ms > 0)) {
         return;
     }
 
-    for (auto i = 0; i < vehicle.waypoints.size(); i++) {
-        auto &wp = vehicle.waypoints[i];
+    while (!vehicle.waypoints.empty()) {
+        auto &wp = vehicle.waypoints.front();
 
-        // If we can finish this waypoint within the time.
+        // If we can finish this waypoint within the time, pop it from the front in O(1).
         if (wp.route.duration_ms <= time_ms) {
             system_time_ms += wp.route.duration_ms;
             time_ms -= wp.route.duration_ms;
@@ -184,6 +325,12 @@ void advance_vehicle(Vehicle &vehicle,
             if (update_vehicle_stats) {
                 vehicle.dist_traveled_mm += wp.route.distance_mm;
                 vehicle.loaded_dist_traveled_mm += wp.route.distance_mm * vehicle.load;
+
+                if (kpi_accumulator != nullptr) {
+                    kpi_accumulator->record_distance(system_time_ms,
+                                                     wp.route.distance_mm,
+                                                     wp.route.distance_mm * vehicle.load);
+                }
             }
 
             if (wp.op == WaypointOp::PICKUP) {
@@ -194,10 +341,8 @@ void advance_vehicle(Vehicle &vehicle,
                 trips[wp.trip_id].status = TripStatus::PICKED_UP;
                 vehicle.load++;
 
-                fmt::print("[DEBUG] T = {}s: Vehicle #{} picked up Trip #{}\n",
-                           system_time_ms / 1000.0,
-                           vehicle.id,
-                           wp.trip_id);
+                log_event<LogLevel::DEBUG>(
+                    LogEvent::TRIP_PICKED_UP, system_time_ms, vehicle.id, wp.trip_id);
             } else if (wp.op == WaypointOp::DROPOFF) {
                 assert(vehicle.load > 0 && "Vehicle's load should not be zero before a dropoff!");
 
@@ -205,33 +350,40 @@ void advance_vehicle(Vehicle &vehicle,
                 trips[wp.trip_id].status = TripStatus::DROPPED_OFF;
                 vehicle.load--;
 
-                fmt::print("[DEBUG] T = {}s: Vehicle #{} droped off Trip #{}\n",
-                           system_time_ms / 1000.0,
-                           vehicle.id,
-                           wp.trip_id);
+                if (kpi_accumulator != nullptr) {
+                    kpi_accumulator->record_dropoff(trips[wp.trip_id]);
+                }
+
+                log_event<LogLevel::DEBUG>(
+                    LogEvent::TRIP_DROPPED_OFF, system_time_ms, vehicle.id, wp.trip_id);
             }
 
+            vehicle.waypoints.pop_front();
+
             continue;
         }
 
-        // If we can not finish this waypoint, truncate the route.
+        // If we can not finish this waypoint, move the cursor along the route.
         const auto original_distance_mm = wp.route.distance_mm;
 
-        truncate_route_by_time(wp.route, time_ms);
-        vehicle.pos = wp.route.legs.front().steps.front().poses.front();
+        advance_route_by_time(wp.route, time_ms);
+        if (!wp.route.poses.empty()) {
+            vehicle.pos = get_current_pos_on_route(wp.route);
+        }
 
         if (update_vehicle_stats) {
             const auto dist_traveled_mm = original_distance_mm - wp.route.distance_mm;
             vehicle.dist_traveled_mm += dist_traveled_mm;
             vehicle.loaded_dist_traveled_mm += dist_traveled_mm * vehicle.load;
-        }
 
-        vehicle.waypoints.erase(vehicle.waypoints.begin(), vehicle.waypoints.begin() + i);
+            if (kpi_accumulator != nullptr) {
+                kpi_accumulator->record_distance(
+                    system_time_ms, dist_traveled_mm, dist_traveled_mm * vehicle.load);
+            }
+        }
 
-        return;
+        break;
     }
 
-    // We've finished all waypoints.
-    vehicle.waypoints.clear();
     return;
 }
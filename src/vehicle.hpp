@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "kpi.hpp"
 #include "types.hpp"
 
 /// \brief Trucate Step so that the first x milliseconds worth of route is completed.
@@ -14,6 +15,27 @@ void truncate_leg_by_time(Leg &leg, uint64_t time_ms);
 /// \brief Trucate Route so that the first x milliseconds worth of route is completed.
 void truncate_route_by_time(Route &route, uint64_t time_ms);
 
+/// \brief Simplify the geometry of each step of the route (see simplify_polyline()).
+/// \details The steps keep their end poses, distances and durations, so that the time and distance
+/// are still distributed along the remaining poses of each step. Applied before the legs are
+/// flattened, it shortens the polyline stored with the waypoint and written to the datalog.
+/// \param tolerance_m The max distance in meters between a dropped pos and the simplified step.
+void simplify_route(Route &route, double tolerance_m);
+
+/// \brief Flatten the legs of the route into a polyline with cumulative time/distance offsets.
+/// \details Within each step, time and distance are distributed along the poses proportionally to
+/// the (Mahhantan) length of each segment. The offsets are scaled to match the total duration and
+/// distance of the route. The legs are released afterwards as the polyline supersedes them.
+void build_route_track(Route &route);
+
+/// \brief Advance along the route by x milliseconds, which must be less than its duration.
+/// \details The polyline is built on first use. The cursor is located by binary search over the
+/// cumulative time offsets, so no memory is moved or allocated as the route is consumed.
+void advance_route_by_time(Route &route, uint64_t time_ms);
+
+/// \brief Get the current pos along the route, interpolated within the segment at the cursor.
+Pos get_current_pos_on_route(const Route &route);
+
 /// \brief Advance the vehicle by x milliseconds .
 /// \param vehicle the vehicle that contains waypoints to be processed.
 /// \param trips the reference to the trips.
@@ -21,8 +43,11 @@ void truncate_route_by_time(Route &route, uint64_t time_ms);
 /// \param time_ms the time in seconds that we need to advance the system.
 /// \param update_vehicle_stats true if we update the vehicle statistics including distance
 /// traveled and loaded distance traveled.
+/// \param kpi_accumulator the accumulator that records the dropoffs and the distance traveled, if
+/// not nullptr. The distance is only recorded if update_vehicle_stats is true.
 void advance_vehicle(Vehicle &vehicle,
                      std::vector<Trip> &trips,
                      uint64_t system_time_ms,
                      uint64_t time_ms,
-                     bool update_vehicle_stats = true);
+                     bool update_vehicle_stats = true,
+                     KpiAccumulator *kpi_accumulator = nullptr);
@@ -0,0 +1,230 @@
+/// \author Jian Wen
+/// \date 2021/02/28
+
+#include "video_renderer.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+/// \brief The number of waypoints rendered for each vehicle, in solid, dashed and dotted lines.
+constexpr size_t kNumRenderedWaypoints = 3;
+
+/// \brief The opacity of the vehicles, the routes and the trips.
+constexpr float kOpacity = 0.6;
+
+/// \brief Get the color of the vehicle. We only color the first five vehicles.
+Color get_vehicle_color(size_t vehicle_id) {
+    switch (vehicle_id) {
+    case 0:
+        return {0xdc, 0x24, 0x1f, kOpacity};
+    case 1:
+        return {0x9b, 0x00, 0x58, kOpacity};
+    case 2:
+        return {0x00, 0x19, 0xa8, kOpacity};
+    case 3:
+        return {0x00, 0x98, 0xd8, kOpacity};
+    case 4:
+        return {0xb2, 0x63, 0x00, kOpacity};
+    default:
+        return {0x80, 0x80, 0x80, kOpacity};
+    }
+}
+
+} // namespace
+
+RenderConfig get_render_config(const PlatformConfig &platform_config,
+                               size_t image_width,
+                               size_t image_height) {
+    const auto cycle_ms = static_cast<uint64_t>(platform_config.simulation_config.cycle_s * 1000);
+
+    RenderConfig render_config;
+    render_config.area_config = platform_config.area_config;
+    render_config.image_width = image_width;
+    render_config.image_height = image_height;
+    render_config.main_sim_start_time_ms =
+        static_cast<uint64_t>(platform_config.simulation_config.warmup_duration_s * 1000);
+    render_config.frame_interval_ms =
+        cycle_ms / platform_config.output_config.video_config.frames_per_cycle;
+
+    return render_config;
+}
+
+RenderFrameDecoder::RenderFrameDecoder(const BinaryDatalogReader &_datalog_reader,
+                                       RenderConfig _render_config)
+    : datalog_reader_(_datalog_reader), render_config_(std::move(_render_config)) {
+    if (datalog_reader_.get_header().num_chunks > 0) {
+        chunk_ = datalog_reader_.get_chunk(0);
+    }
+}
+
+bool RenderFrameDecoder::decode_next_frame(RenderFrame &frame) {
+    // Move on to the next chunk once all frames in the current chunk are decoded.
+    if (frame_index_ == chunk_.header.num_frames) {
+        if (chunk_index_ + 1 >= datalog_reader_.get_header().num_chunks) {
+            return false;
+        }
+
+        chunk_ = datalog_reader_.get_chunk(++chunk_index_);
+        frame_index_ = 0;
+        waypoint_begin_ = 0;
+        new_trip_begin_ = 0;
+        trip_transition_begin_ = 0;
+    }
+
+    frame.system_time_ms = chunk_.system_time_ms[frame_index_];
+    frame.vehicle_points.clear();
+    frame.waypoint_ends.clear();
+    frame.waypoint_point_ends.clear();
+    frame.waypoint_points.clear();
+
+    // The vehicles and the first few waypoints of each.
+    const auto num_vehicles = chunk_.header.num_vehicles;
+    for (auto vehicle_index = 0; vehicle_index < num_vehicles; vehicle_index++) {
+        const auto i = frame_index_ * num_vehicles + vehicle_index;
+        frame.vehicle_points.push_back(project(chunk_.vehicle_lon[i], chunk_.vehicle_lat[i]));
+
+        const auto waypoint_end = chunk_.vehicle_waypoint_ends[i];
+        const auto rendered_waypoint_end =
+            std::min<size_t>(waypoint_end, waypoint_begin_ + kNumRenderedWaypoints);
+        for (auto w = waypoint_begin_; w < rendered_waypoint_end; w++) {
+            const auto pose_begin = w > 0 ? chunk_.waypoint_pose_ends[w - 1] : 0;
+            for (auto p = pose_begin; p < chunk_.waypoint_pose_ends[w]; p++) {
+                frame.waypoint_points.push_back(
+                    project(chunk_.waypoint_pose_lon[p], chunk_.waypoint_pose_lat[p]));
+            }
+            frame.waypoint_point_ends.push_back(frame.waypoint_points.size());
+        }
+        frame.waypoint_ends.push_back(frame.waypoint_point_ends.size());
+        waypoint_begin_ = waypoint_end;
+    }
+
+    // The trips first seen in this frame.
+    for (; new_trip_begin_ < chunk_.frame_new_trip_ends[frame_index_]; new_trip_begin_++) {
+        const auto trip_id = chunk_.new_trip_id[new_trip_begin_];
+        if (trip_id >= trip_statuses_.size()) {
+            trip_origin_points_.resize(trip_id + 1);
+            trip_request_time_ms_.resize(trip_id + 1, 0);
+            trip_statuses_.resize(trip_id + 1, TripStatus::UNDEFINED);
+        }
+
+        trip_origin_points_[trip_id] = project(chunk_.new_trip_origin_lon[new_trip_begin_],
+                                               chunk_.new_trip_origin_lat[new_trip_begin_]);
+        trip_request_time_ms_[trip_id] = chunk_.new_trip_request_time_ms[new_trip_begin_];
+
+        // The trip is counted as UNDEFINED until its first transition, in the same frame.
+        if (trip_request_time_ms_[trip_id] >= render_config_.main_sim_start_time_ms) {
+            num_trips_by_status_[static_cast<size_t>(TripStatus::UNDEFINED)]++;
+        }
+    }
+
+    // The trips whose status changed in this frame, counted if requested in the main simulation.
+    for (; trip_transition_begin_ < chunk_.frame_trip_transition_ends[frame_index_];
+         trip_transition_begin_++) {
+        const auto trip_id = chunk_.trip_transition_id[trip_transition_begin_];
+        const auto status =
+            static_cast<TripStatus>(chunk_.trip_transition_status[trip_transition_begin_]);
+
+        if (trip_request_time_ms_[trip_id] >= render_config_.main_sim_start_time_ms) {
+            num_trips_by_status_[static_cast<size_t>(trip_statuses_[trip_id])]--;
+            num_trips_by_status_[static_cast<size_t>(status)]++;
+        }
+        trip_statuses_[trip_id] = status;
+    }
+
+    frame.dispatched_trip_points.clear();
+    frame.walked_away_trip_points.clear();
+    for (auto trip_id = 0; trip_id < trip_statuses_.size(); trip_id++) {
+        if (trip_statuses_[trip_id] == TripStatus::DISPATCHED) {
+            frame.dispatched_trip_points.push_back(trip_origin_points_[trip_id]);
+        } else if (trip_statuses_[trip_id] == TripStatus::WALKAWAY &&
+                   trip_request_time_ms_[trip_id] + render_config_.frame_interval_ms >=
+                       frame.system_time_ms) {
+            frame.walked_away_trip_points.push_back(trip_origin_points_[trip_id]);
+        }
+    }
+
+    size_t num_requested_trips = 0;
+    for (auto count : num_trips_by_status_) {
+        num_requested_trips += count;
+    }
+    frame.num_requested_trips = num_requested_trips;
+    frame.num_accepted_trips =
+        num_requested_trips - num_trips_by_status_[static_cast<size_t>(TripStatus::WALKAWAY)];
+    frame.num_completed_trips = num_trips_by_status_[static_cast<size_t>(TripStatus::DROPPED_OFF)];
+
+    frame_index_++;
+
+    return true;
+}
+
+Point RenderFrameDecoder::project(float lon, float lat) const {
+    const auto &area_config = render_config_.area_config;
+
+    return {(lon - area_config.lon_min) / (area_config.lon_max - area_config.lon_min) *
+                render_config_.image_width,
+            (area_config.lat_max - lat) / (area_config.lat_max - area_config.lat_min) *
+                render_config_.image_height};
+}
+
+void render_frame(Rasterizer &rasterizer,
+                  const Image &background,
+                  const RenderFrame &frame,
+                  const RenderConfig &render_config) {
+    const auto marker_size = 8 * render_config.pixels_per_point;
+    const auto line_width = 2 * render_config.pixels_per_point;
+
+    rasterizer.draw_background(background);
+
+    // Render trips.
+    for (const auto &point : frame.dispatched_trip_points) {
+        rasterizer.draw_marker(point, marker_size, MarkerShape::PLUS, {0x00, 0x64, 0x00, kOpacity});
+    }
+    for (const auto &point : frame.walked_away_trip_points) {
+        rasterizer.draw_marker(
+            point, marker_size, MarkerShape::CROSS, {0x8b, 0x00, 0x00, kOpacity});
+    }
+
+    // Render vehicles, with the immediate next waypoint, the following waypoint, and the one after.
+    const LineStyle line_styles[kNumRenderedWaypoints] = {
+        LineStyle::SOLID, LineStyle::DASHED, LineStyle::DOTTED};
+    auto waypoint_index = 0;
+    for (auto vehicle_id = 0; vehicle_id < frame.vehicle_points.size(); vehicle_id++) {
+        const auto color = get_vehicle_color(vehicle_id);
+        rasterizer.draw_disc(frame.vehicle_points[vehicle_id], marker_size / 2, color);
+
+        for (auto i = 0; waypoint_index < frame.waypoint_ends[vehicle_id]; waypoint_index++, i++) {
+            const auto point_begin =
+                waypoint_index > 0 ? frame.waypoint_point_ends[waypoint_index - 1] : 0;
+            rasterizer.draw_polyline(&frame.waypoint_points[point_begin],
+                                     frame.waypoint_point_ends[waypoint_index] - point_begin,
+                                     line_width,
+                                     line_styles[i],
+                                     color);
+        }
+    }
+
+    // Render text.
+    const auto text = fmt::format("T = {:.1f}s\n{} requested trips ({} accepted, {} completed)",
+                                  frame.system_time_ms / 1000.0,
+                                  frame.num_requested_trips,
+                                  frame.num_accepted_trips,
+                                  frame.num_completed_trips);
+    const auto text_scale =
+        std::max<size_t>(1, std::lround(12 * render_config.pixels_per_point / 10));
+    const auto text_size = Rasterizer::get_text_size(text, text_scale);
+    const auto padding = 3.0f * text_scale;
+    const Point text_top_left{0.02f * render_config.image_width,
+                              0.95f * render_config.image_height - text_size.y};
+
+    rasterizer.draw_rectangle({text_top_left.x - padding, text_top_left.y - padding},
+                              {text_top_left.x + text_size.x + padding,
+                               text_top_left.y + text_size.y + padding},
+                              {0xff, 0xff, 0xff, 0.3});
+    rasterizer.draw_text(text_top_left, text, text_scale, {0x00, 0x00, 0x00, 1.0});
+}
@@ -0,0 +1,93 @@
+/// \author Jian Wen
+/// \date 2021/02/28
+
+#pragma once
+
+#include "binary_datalog.hpp"
+#include "config.hpp"
+#include "rasterizer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// \brief The parameters of rendering the video frames.
+struct RenderConfig {
+    AreaConfig area_config;              // the area mapped onto the whole image
+    size_t image_width = 0;              // the width of the image in pixels
+    size_t image_height = 0;             // the height of the image in pixels
+    uint64_t main_sim_start_time_ms = 0; // the trips requested before are not counted
+    uint64_t frame_interval_ms = 0;      // the walked away trips are shown for one frame interval
+    float pixels_per_point = 200.0 / 72; // the scale of the markers, lines and text
+};
+
+/// \brief Get the render config from the platform config, for the background image of the size.
+RenderConfig get_render_config(const PlatformConfig &platform_config,
+                               size_t image_width,
+                               size_t image_height);
+
+/// \brief A video frame decoded from the datalog, in pixels.
+struct RenderFrame {
+    uint64_t system_time_ms = 0;
+    std::vector<Point> vehicle_points = {};          // the pos of each vehicle
+    std::vector<size_t> waypoint_ends = {};          // the end of the waypoints of each vehicle
+    std::vector<size_t> waypoint_point_ends = {};    // the end of the points of each waypoint
+    std::vector<Point> waypoint_points = {};         // the remaining polylines of the waypoints
+    std::vector<Point> dispatched_trip_points = {};  // the origins of the dispatched trips
+    std::vector<Point> walked_away_trip_points = {}; // the origins of the recent walked away trips
+    size_t num_requested_trips = 0;                  // the trips requested in the main simulation
+    size_t num_accepted_trips = 0;                   // the requested trips not walked away
+    size_t num_completed_trips = 0;                  // the requested trips dropped off
+};
+
+/// \brief The decoder of the frames in the binary datalog, one after another.
+/// \details The decoder keeps the latest status of all trips, which only change between frames.
+/// Only the first three waypoints of each vehicle are decoded, as the rest are not rendered.
+class RenderFrameDecoder {
+  public:
+    /// \brief Constructor.
+    /// \param _datalog_reader The reader of the datalog, which must outlive the decoder.
+    RenderFrameDecoder(const BinaryDatalogReader &_datalog_reader, RenderConfig _render_config);
+
+    /// \brief Decode the next frame, false if there are no frames left.
+    bool decode_next_frame(RenderFrame &frame);
+
+  private:
+    /// \brief Project the lon/lat onto the image.
+    Point project(float lon, float lat) const;
+
+    /// \brief The reader of the datalog.
+    const BinaryDatalogReader &datalog_reader_;
+
+    /// \brief The render config.
+    const RenderConfig render_config_;
+
+    /// \brief The chunk of the next frame.
+    BinaryDatalogChunk chunk_;
+
+    /// \brief The index of the chunk of the next frame.
+    size_t chunk_index_ = 0;
+
+    /// \brief The index of the next frame within the chunk.
+    size_t frame_index_ = 0;
+
+    // The beginning of the waypoints, the new trips and the trip transitions of the next frame.
+    size_t waypoint_begin_ = 0;
+    size_t new_trip_begin_ = 0;
+    size_t trip_transition_begin_ = 0;
+
+    // The origin, the request time and the latest status of each trip.
+    std::vector<Point> trip_origin_points_ = {};
+    std::vector<uint64_t> trip_request_time_ms_ = {};
+    std::vector<TripStatus> trip_statuses_ = {};
+
+    /// \brief The number of trips requested in the main simulation, by status.
+    std::array<size_t, 6> num_trips_by_status_ = {};
+};
+
+/// \brief Render the frame onto the background, in the same style as render_video.py.
+void render_frame(Rasterizer &rasterizer,
+                  const Image &background,
+                  const RenderFrame &frame,
+                  const RenderConfig &render_config);
@@ -0,0 +1,62 @@
+/// \author Jian Wen
+/// \date 2021/02/24
+
+#include "zone.hpp"
+#include "geo.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// \brief Get the index of the cell along one axis, clamped to [0, num_cells).
+size_t get_cell_index(float value, float min, float max, size_t num_cells) {
+    const auto cell = static_cast<int64_t>(std::floor((value - min) / (max - min) * num_cells));
+
+    return static_cast<size_t>(std::clamp<int64_t>(cell, 0, num_cells - 1));
+}
+
+} // namespace
+
+size_t get_zone_index(const ZoneGrid &zone_grid, const Pos &pos) {
+    const auto &area = zone_grid.area_config;
+
+    const auto col = get_cell_index(pos.lon, area.lon_min, area.lon_max, zone_grid.num_cols);
+    const auto row = get_cell_index(pos.lat, area.lat_min, area.lat_max, zone_grid.num_rows);
+
+    return row * zone_grid.num_cols + col;
+}
+
+double get_distance_to_zone_border_m(const ZoneGrid &zone_grid, const Pos &pos) {
+    const auto &area = zone_grid.area_config;
+    const auto lon_span = (area.lon_max - area.lon_min) / zone_grid.num_cols;
+    const auto lat_span = (area.lat_max - area.lat_min) / zone_grid.num_rows;
+
+    const auto col = get_cell_index(pos.lon, area.lon_min, area.lon_max, zone_grid.num_cols);
+    const auto row = get_cell_index(pos.lat, area.lat_min, area.lat_max, zone_grid.num_rows);
+
+    auto distance_m = std::numeric_limits<double>::infinity();
+
+    // The west and east borders, unless on the boundary of the area.
+    if (col > 0) {
+        const Pos border{area.lon_min + lon_span * col, pos.lat};
+        distance_m = std::min(distance_m, get_haversine_distance_m(pos, border));
+    }
+    if (col + 1 < zone_grid.num_cols) {
+        const Pos border{area.lon_min + lon_span * (col + 1), pos.lat};
+        distance_m = std::min(distance_m, get_haversine_distance_m(pos, border));
+    }
+
+    // The south and north borders, unless on the boundary of the area.
+    if (row > 0) {
+        const Pos border{pos.lon, area.lat_min + lat_span * row};
+        distance_m = std::min(distance_m, get_haversine_distance_m(pos, border));
+    }
+    if (row + 1 < zone_grid.num_rows) {
+        const Pos border{pos.lon, area.lat_min + lat_span * (row + 1)};
+        distance_m = std::min(distance_m, get_haversine_distance_m(pos, border));
+    }
+
+    return distance_m;
+}
@@ -0,0 +1,26 @@
+/// \author Jian Wen
+/// \date 2021/02/24
+
+#pragma once
+
+#include "config.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+
+/// \brief The grid that partitions the simulated area into zones of equal spans in lon/lat.
+/// \details The zones are indexed row by row, from the south-west corner of the area.
+struct ZoneGrid {
+    AreaConfig area_config;
+    size_t num_cols = 1; // the number of zones along the longitude
+    size_t num_rows = 1; // the number of zones along the latitude
+};
+
+/// \brief Get the index of the zone that contains the pos. Poses out of the area are clamped to
+/// the zones on the boundary.
+size_t get_zone_index(const ZoneGrid &zone_grid, const Pos &pos);
+
+/// \brief Compute the distance in meters from the pos to the nearest border between its zone and
+/// a neighboring zone. The edges on the boundary of the area are not borders.
+/// \return The distance, infinity if there is a single zone.
+double get_distance_to_zone_border_m(const ZoneGrid &zone_grid, const Pos &pos);
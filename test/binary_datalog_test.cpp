@@ -0,0 +1,81 @@
+/// \author Jian Wen
+/// \date 2021/02/27
+
+#include "../src/binary_datalog.hpp"
+#include "datalog_fixtures.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+
+TEST(BinaryDatalog, read_back_columns_in_chunks) {
+    const std::string path = "binary_datalog_test.bin";
+    const size_t num_frames = kBinaryDatalogFramesPerChunk + 10;
+
+    auto vehicles = create_vehicles();
+    std::vector<Trip> trips;
+
+    {
+        BinaryDatalogWriter datalog_writer{path};
+        DatalogFrame frame;
+
+        for (size_t i = 0; i < num_frames; i++) {
+            // A new trip every frame, and the previous trip is picked up.
+            trips.push_back({trips.size(), Pos{1.0f * i, 0}, Pos{0, 1.0f * i}});
+            trips.back().status = TripStatus::REQUESTED;
+            trips.back().request_time_ms = 1000 * i;
+            if (i > 0) {
+                trips[i - 1].status = TripStatus::PICKED_UP;
+                trips[i - 1].pickup_time_ms = 1000 * i - 500;
+            }
+            vehicles[1].pos.lon += 0.125;
+
+            capture_datalog_frame(frame, 1000 * i, vehicles, trips);
+            datalog_writer.write_frame(frame);
+        }
+    }
+
+    {
+        BinaryDatalogReader datalog_reader{path};
+
+        const auto &header = datalog_reader.get_header();
+        EXPECT_EQ(std::memcmp(header.magic, kBinaryDatalogMagic, sizeof(header.magic)), 0);
+        EXPECT_EQ(header.num_vehicles, 2);
+        EXPECT_EQ(header.num_frames, num_frames);
+        ASSERT_EQ(header.num_chunks, 2);
+        EXPECT_EQ(datalog_reader.get_index_entry(1).first_frame_index,
+                  kBinaryDatalogFramesPerChunk);
+        EXPECT_EQ(datalog_reader.get_index_entry(1).first_system_time_ms,
+                  1000 * kBinaryDatalogFramesPerChunk);
+
+        const auto chunk = datalog_reader.get_chunk(1);
+        ASSERT_EQ(chunk.header.num_frames, 10);
+        EXPECT_EQ(chunk.system_time_ms[9], 1000 * (num_frames - 1));
+
+        // The vehicle columns, indexed by frame and then by vehicle.
+        EXPECT_FLOAT_EQ(chunk.vehicle_lon[9 * 2 + 1], 2.0f + 0.125f * num_frames);
+        EXPECT_EQ(chunk.vehicle_load[9 * 2], 1);
+        EXPECT_EQ(chunk.vehicle_waypoint_ends[9 * 2], 10);
+        EXPECT_EQ(chunk.vehicle_waypoint_ends[9 * 2 + 1], 10);
+        ASSERT_EQ(chunk.header.num_waypoint_poses, 30);
+        EXPECT_EQ(chunk.waypoint_pose_ends[9], 30);
+        EXPECT_FLOAT_EQ(chunk.waypoint_pose_lon[29], 1.0f);
+
+        // Each frame has one new trip and the previous one picked up.
+        ASSERT_EQ(chunk.header.num_new_trips, 10);
+        EXPECT_EQ(chunk.frame_new_trip_ends[9], 10);
+        EXPECT_EQ(chunk.new_trip_id[9], num_frames - 1);
+        EXPECT_EQ(chunk.new_trip_request_time_ms[9], 1000 * (num_frames - 1));
+        EXPECT_FLOAT_EQ(chunk.new_trip_origin_lon[9], 1.0f * (num_frames - 1));
+        ASSERT_EQ(chunk.header.num_trip_transitions, 20);
+        EXPECT_EQ(chunk.frame_trip_transition_ends[9], 20);
+        EXPECT_EQ(chunk.trip_transition_id[18], num_frames - 2);
+        EXPECT_EQ(chunk.trip_transition_status[18], static_cast<uint8_t>(TripStatus::PICKED_UP));
+        EXPECT_EQ(chunk.trip_transition_time_ms[18], 1000 * (num_frames - 1) - 500);
+        EXPECT_EQ(chunk.trip_transition_id[19], num_frames - 1);
+        EXPECT_EQ(chunk.trip_transition_status[19], static_cast<uint8_t>(TripStatus::REQUESTED));
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,24 @@
+/// \author Jian Wen
+/// \date 2021/03/06
+
+#pragma once
+
+#include "../src/types.hpp"
+
+#include <vector>
+
+/// \brief Create the vehicles shared by the datalog tests: vehicle 0 carries a traveler to its
+/// dropoff along a 3-pose route, and vehicle 1 is idle.
+inline std::vector<Vehicle> create_vehicles() {
+    Route route;
+    route.distance_mm = 2000;
+    route.duration_ms = 2000;
+    route.poses = {Pos{0, 0}, Pos{0, 1}, Pos{1, 1}};
+    route.time_offsets_ms = {0, 1000, 2000};
+    route.distance_offsets_mm = {0, 1000, 2000};
+
+    Vehicle vehicle{0, Pos{0, 0}, 2, 1};
+    vehicle.waypoints.push_back({Pos{1, 1}, WaypointOp::DROPOFF, 0, route});
+
+    return {vehicle, Vehicle{1, Pos{2, 2}, 2, 0}};
+}
@@ -0,0 +1,148 @@
+/// \author Jian Wen
+/// \date 2021/02/23
+
+#include "../src/datalog.hpp"
+#include "datalog_fixtures.hpp"
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST(DatalogFrame, capture_remaining_polylines) {
+    auto vehicles = create_vehicles();
+    vehicles[0].waypoints[0].route.cursor = 1;
+    vehicles[0].waypoints[0].route.elapsed_ms = 1500;
+
+    DatalogFrame frame;
+    capture_datalog_frame(frame, 1000, vehicles, {});
+
+    EXPECT_EQ(frame.system_time_ms, 1000);
+    ASSERT_EQ(frame.vehicle_poses.size(), 2);
+    ASSERT_EQ(frame.waypoint_ends.size(), 2);
+    EXPECT_EQ(frame.waypoint_ends[0], 1);
+    EXPECT_EQ(frame.waypoint_ends[1], 1);
+    ASSERT_EQ(frame.waypoint_pose_ends.size(), 1);
+    EXPECT_EQ(frame.waypoint_pose_ends[0], 2);
+
+    // The polyline starts from the current pos, halfway through the second segment.
+    ASSERT_EQ(frame.waypoint_poses.size(), 2);
+    EXPECT_FLOAT_EQ(frame.waypoint_poses[0].lon, 0.5);
+    EXPECT_FLOAT_EQ(frame.waypoint_poses[0].lat, 1.0);
+    EXPECT_FLOAT_EQ(frame.waypoint_poses[1].lon, 1.0);
+}
+
+TEST(DatalogWriter, output_identical_to_synchronous_writes) {
+    const std::string path = "datalog_test.yml";
+
+    auto vehicles = create_vehicles();
+    std::vector<Trip> trips;
+    std::ostringstream expected_out;
+
+    {
+        DatalogWriter datalog_writer{path};
+        DatalogFrame frame;
+
+        for (auto i = 0; i < 50; i++) {
+            trips.push_back({trips.size(), Pos{1.0f * i, 0}, Pos{0, 1.0f * i}});
+            vehicles[1].pos.lon += 0.1;
+
+            capture_datalog_frame(frame, 1000 * i, vehicles, trips);
+            write_datalog_frame(expected_out, frame);
+
+            capture_datalog_frame(datalog_writer.get_back_frame(), 1000 * i, vehicles, trips);
+            datalog_writer.submit_back_frame();
+        }
+    }
+
+    std::ifstream in{path};
+    std::stringstream out;
+    out << in.rdbuf();
+
+    EXPECT_EQ(out.str(), expected_out.str());
+
+    std::remove(path.c_str());
+}
+
+TEST(DatalogWriter, output_decompressed_identical_to_uncompressed_writes) {
+    const std::string path = "datalog_test.yml.gz";
+
+    auto vehicles = create_vehicles();
+    std::vector<Trip> trips;
+    std::ostringstream expected_out;
+
+    {
+        DatalogWriter datalog_writer{path, false, DatalogCompression::GZIP, 9};
+        DatalogFrame frame;
+
+        for (auto i = 0; i < 50; i++) {
+            trips.push_back({trips.size(), Pos{1.0f * i, 0}, Pos{0, 1.0f * i}});
+
+            capture_datalog_frame(frame, 1000 * i, vehicles, trips);
+            write_datalog_frame(expected_out, frame);
+
+            capture_datalog_frame(datalog_writer.get_back_frame(), 1000 * i, vehicles, trips);
+            datalog_writer.submit_back_frame();
+        }
+    }
+
+    std::ifstream in{path, std::ios::binary};
+    boost::iostreams::filtering_istream decompressed_in;
+    decompressed_in.push(boost::iostreams::gzip_decompressor{});
+    decompressed_in.push(in);
+    std::stringstream out;
+    boost::iostreams::copy(decompressed_in, out);
+
+    EXPECT_EQ(out.str(), expected_out.str());
+
+    // The repeated frames compress well.
+    const auto compressed_size = std::ifstream{path, std::ios::binary | std::ios::ate}.tellg();
+    EXPECT_GT(compressed_size, 0);
+    EXPECT_LT(compressed_size, expected_out.str().size() / 10);
+
+    std::remove(path.c_str());
+}
+
+TEST(DatalogDeltaEncoder, capture_only_changes_since_previous_frame) {
+    auto vehicles = create_vehicles();
+    std::vector<Trip> trips{{0, Pos{0, 0}, Pos{1, 1}, TripStatus::DISPATCHED}};
+
+    DatalogDeltaEncoder encoder;
+    DatalogFrame frame;
+
+    // The first frame holds the route and the trip.
+    encoder.capture(frame, 0, vehicles, trips);
+    EXPECT_TRUE(frame.delta_encoded);
+    ASSERT_EQ(frame.new_route_ids.size(), 1);
+    EXPECT_EQ(frame.new_route_pose_ends[0], 3);
+    EXPECT_EQ(frame.new_route_time_offsets_ms[2], 2000);
+    ASSERT_EQ(frame.waypoint_route_ids.size(), 1);
+    EXPECT_EQ(frame.waypoint_route_ids[0], frame.new_route_ids[0]);
+    EXPECT_EQ(frame.trips.size(), 1);
+
+    // The route is not repeated as the vehicle moves along, and the trip is unchanged.
+    const auto route_id = frame.new_route_ids[0];
+    vehicles[0].waypoints[0].route.cursor = 1;
+    vehicles[0].waypoints[0].route.elapsed_ms = 1500;
+
+    encoder.capture(frame, 1000, vehicles, trips);
+    EXPECT_TRUE(frame.new_route_ids.empty());
+    ASSERT_EQ(frame.waypoint_route_ids.size(), 1);
+    EXPECT_EQ(frame.waypoint_route_ids[0], route_id);
+    EXPECT_EQ(frame.waypoint_cursors[0], 1);
+    EXPECT_EQ(frame.waypoint_elapsed_ms[0], 1500);
+    EXPECT_TRUE(frame.trips.empty());
+
+    // A replanned route gets a new id, and the changed trip is included.
+    vehicles[0].waypoints[0].route.poses[0].lon = 0.5;
+    trips[0].status = TripStatus::PICKED_UP;
+
+    encoder.capture(frame, 2000, vehicles, trips);
+    ASSERT_EQ(frame.new_route_ids.size(), 1);
+    EXPECT_NE(frame.new_route_ids[0], route_id);
+    ASSERT_EQ(frame.trips.size(), 1);
+    EXPECT_EQ(frame.trips[0].status, TripStatus::PICKED_UP);
+}
@@ -0,0 +1,187 @@
+/// \author Jian Wen
+/// \date 2021/02/17
+
+#include "../src/demand_generator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+
+/// \brief Recover the probability of each item from the alias table.
+std::vector<double> get_probs_from_alias_table(const std::vector<AliasEntry> &alias_table) {
+    std::vector<double> probs(alias_table.size(), 0.0);
+
+    for (auto i = 0; i < alias_table.size(); i++) {
+        probs[i] += alias_table[i].prob / alias_table.size();
+        probs[alias_table[i].alias] += (1.0 - alias_table[i].prob) / alias_table.size();
+    }
+
+    return probs;
+}
+
+} // namespace
+
+TEST(BuildAliasTable, return_correct_answer_scenario_1) {
+    auto alias_table = build_alias_table({1.0, 3.0});
+
+    EXPECT_EQ(alias_table.size(), 2);
+    EXPECT_FLOAT_EQ(alias_table[0].prob, 0.5);
+    EXPECT_EQ(alias_table[0].alias, 1);
+    EXPECT_FLOAT_EQ(alias_table[1].prob, 1.0);
+}
+
+TEST(BuildAliasTable, return_correct_answer_scenario_2) {
+    std::vector<double> weights = {3, 0, 5, 1, 1, 10, 0.5, 2};
+    auto alias_table = build_alias_table(weights);
+
+    auto probs = get_probs_from_alias_table(alias_table);
+
+    EXPECT_EQ(probs.size(), weights.size());
+    for (auto i = 0; i < weights.size(); i++) {
+        EXPECT_NEAR(probs[i], weights[i] / 22.5, 1e-6);
+    }
+}
+
+TEST(DemandGenerator, reproduce_requests_regardless_of_number_of_threads) {
+    std::vector<Od> ods = {Od{Pos{0, 0}, Pos{1, 1}}, Od{Pos{2, 2}, Pos{3, 3}}};
+    std::vector<double> trips_per_hour = {600, 1800};
+
+    DemandGenerator demand_generator1{ods, trips_per_hour, 42, 0, 1};
+    DemandGenerator demand_generator2{ods, trips_per_hour, 42, 0, 4};
+
+    for (auto time_ms : {0, 30000, 600000, 605000, 3600000}) {
+        auto requests1 = demand_generator1(time_ms);
+        auto requests2 = demand_generator2(time_ms);
+
+        ASSERT_EQ(requests1.size(), requests2.size());
+        for (auto i = 0; i < requests1.size(); i++) {
+            EXPECT_EQ(requests1[i].request_time_ms, requests2[i].request_time_ms);
+            EXPECT_LE(requests1[i].request_time_ms, time_ms);
+            EXPECT_EQ(requests1[i].origin.lon, requests2[i].origin.lon);
+        }
+    }
+
+    // Different replications draw from different streams.
+    DemandGenerator demand_generator3{ods, trips_per_hour, 42, 1, 1};
+    DemandGenerator demand_generator4{ods, trips_per_hour, 42, 0, 1};
+    EXPECT_NE(demand_generator3(3600000).size(), demand_generator4(3600000).size());
+}
+
+TEST(DemandGenerator, follow_time_varying_trip_intensities) {
+    std::vector<Od> ods = {Od{Pos{0, 0}, Pos{1, 1}}, Od{Pos{2, 2}, Pos{3, 3}}};
+
+    // OD 0 is only requested in the first hour, OD 1 only in the third, and the second hour has no
+    // trips at all. The profile repeats every 3 hours.
+    std::vector<std::vector<double>> trips_per_hour_by_period = {
+        {3600, 0}, {0, 0}, {0, 7200}};
+    DemandGenerator demand_generator{ods, trips_per_hour_by_period, 3600 * 1000, 42};
+
+    std::vector<size_t> num_requests_by_od_and_period(2 * 6, 0);
+    for (const auto &request : demand_generator(6 * 3600 * 1000 - 1)) {
+        const auto od = request.origin.lon == 0 ? 0 : 1;
+        const auto period = request.request_time_ms / (3600 * 1000);
+        num_requests_by_od_and_period[od * 6 + period]++;
+    }
+
+    for (auto period : {0, 3}) {
+        EXPECT_NEAR(num_requests_by_od_and_period[period], 3600, 300);
+        EXPECT_EQ(num_requests_by_od_and_period[6 + period], 0);
+    }
+    for (auto period : {1, 4}) {
+        EXPECT_EQ(num_requests_by_od_and_period[period], 0);
+        EXPECT_EQ(num_requests_by_od_and_period[6 + period], 0);
+    }
+    for (auto period : {2, 5}) {
+        EXPECT_EQ(num_requests_by_od_and_period[period], 0);
+        EXPECT_NEAR(num_requests_by_od_and_period[6 + period], 7200, 500);
+    }
+}
+
+TEST(DemandGenerator, reproduce_requests_from_compiled_demand) {
+    const std::string path = "demand_generator_test.demand";
+
+    std::vector<Od> ods = {Od{Pos{0, 0}, Pos{1, 1}}, Od{Pos{2, 2}, Pos{3, 3}}};
+    std::vector<std::vector<double>> trips_per_hour_by_period = {{600, 1800}, {0, 0}, {50, 0}};
+
+    DemandGenerator demand_generator{ods, trips_per_hour_by_period, 3600 * 1000, 42};
+    demand_generator.write_compiled_demand(path);
+
+    DemandGenerator compiled_demand_generator{path, 42};
+
+    const auto requests = demand_generator(3 * 3600 * 1000);
+    const auto compiled_requests = compiled_demand_generator(3 * 3600 * 1000);
+
+    ASSERT_EQ(requests.size(), compiled_requests.size());
+    for (auto i = 0; i < requests.size(); i++) {
+        EXPECT_EQ(requests[i].request_time_ms, compiled_requests[i].request_time_ms);
+        EXPECT_EQ(requests[i].origin.lon, compiled_requests[i].origin.lon);
+        EXPECT_EQ(requests[i].destination.lat, compiled_requests[i].destination.lat);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(DemandGenerator, load_profile_with_one_value_per_period) {
+    const std::string path = "demand_generator_test.yml";
+    {
+        std::ofstream demand_file{path};
+        demand_file << "period_minutes: 60\n"
+                       "profile: [1, 2]\n"
+                       "ods:\n"
+                       "- origin: {lon: 0, lat: 0}\n"
+                       "  destination: {lon: 1, lat: 1}\n"
+                       "  trips_per_hour: [10, 20]\n"
+                       "- origin: {lon: 2, lat: 2}\n"
+                       "  destination: {lon: 3, lat: 3}\n"
+                       "  trips_per_hour: 5\n";
+    }
+
+    DemandGenerator demand_generator{path, 42};
+    EXPECT_EQ(demand_generator.get_demand_model()->trips_per_hour_by_period,
+              (std::vector<double>{15, 50}));
+
+    // An OD with more periods than the global profile would read past the end of the profile.
+    {
+        std::ofstream demand_file{path};
+        demand_file << "period_minutes: 60\n"
+                       "profile: [1, 2]\n"
+                       "ods:\n"
+                       "- origin: {lon: 0, lat: 0}\n"
+                       "  destination: {lon: 1, lat: 1}\n"
+                       "  trips_per_hour: [10, 20, 30]\n";
+    }
+#ifndef NDEBUG
+    EXPECT_DEATH((DemandGenerator{path, 42}), "one value per period");
+#endif
+
+    std::remove(path.c_str());
+}
+
+TEST(ParseDemandCsvLine, parse_od_with_one_value_per_period) {
+    Od od;
+    std::vector<double> trips_per_hour;
+
+    ASSERT_TRUE(parse_demand_csv_line("114.1,22.3,114.2,22.4,10,20.5\r", od, trips_per_hour));
+    EXPECT_FLOAT_EQ(od.origin.lon, 114.1);
+    EXPECT_FLOAT_EQ(od.origin.lat, 22.3);
+    EXPECT_FLOAT_EQ(od.destination.lon, 114.2);
+    EXPECT_FLOAT_EQ(od.destination.lat, 22.4);
+    EXPECT_EQ(trips_per_hour, (std::vector<double>{10, 20.5}));
+}
+
+TEST(ParseDemandCsvLine, reject_truncated_and_non_numeric_lines) {
+    Od od;
+    std::vector<double> trips_per_hour;
+
+    EXPECT_FALSE(parse_demand_csv_line("114.1,22.3", od, trips_per_hour));
+    EXPECT_FALSE(parse_demand_csv_line("114.1,22.3,114.2,22.4", od, trips_per_hour));
+    EXPECT_FALSE(parse_demand_csv_line("114.1,22.3,114.2,22.4,", od, trips_per_hour));
+    EXPECT_FALSE(parse_demand_csv_line("114.1,abc,114.2,22.4,10", od, trips_per_hour));
+    EXPECT_FALSE(parse_demand_csv_line("114.1,22.3,114.2,22.4,ten", od, trips_per_hour));
+    EXPECT_FALSE(parse_demand_csv_line("114.1;22.3;114.2;22.4;10", od, trips_per_hour));
+    EXPECT_FALSE(parse_demand_csv_line("114.1,22.3,114.2,22.4,10 trips", od, trips_per_hour));
+}
@@ -0,0 +1,185 @@
+/// \author Jian Wen
+/// \date 2021/03/06
+
+#include "../benchmark/straight_line_router.hpp"
+#include "../src/dispatch.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// \brief Create the trip requested at the origin, to be picked up within an hour.
+Trip create_trip(size_t id, Pos origin) {
+    Trip trip{id, origin, Pos{origin.lon, origin.lat + 0.05f}};
+    trip.status = TripStatus::REQUESTED;
+    trip.max_pickup_time_ms = 3600 * 1000;
+
+    return trip;
+}
+
+/// \brief Dispatch all the trips to the vehicles zone by zone.
+void dispatch_zones(std::vector<Trip> &trips,
+                    std::vector<Vehicle> &vehicles,
+                    const ZoneGrid &zone_grid,
+                    size_t num_threads) {
+    std::vector<size_t> pending_trip_ids;
+    for (const auto &trip : trips) {
+        pending_trip_ids.emplace_back(trip.id);
+    }
+
+    FleetState fleet_state;
+    sync_fleet_state(fleet_state, vehicles, 0);
+
+    StraightLineRouter router;
+    ThreadPool thread_pool{num_threads};
+    assign_trips_through_zoned_insertion_heuristics(
+        pending_trip_ids, trips, vehicles, fleet_state, 0, router, zone_grid, 500, thread_pool);
+}
+
+/// \brief Dispatch all the trips to the vehicles through the global insertion heuristics.
+void dispatch_globally(std::vector<Trip> &trips, std::vector<Vehicle> &vehicles) {
+    std::vector<size_t> pending_trip_ids;
+    for (const auto &trip : trips) {
+        pending_trip_ids.emplace_back(trip.id);
+    }
+
+    FleetState fleet_state;
+    sync_fleet_state(fleet_state, vehicles, 0);
+
+    StraightLineRouter router;
+    assign_trips_through_insertion_heuristics(
+        pending_trip_ids, trips, vehicles, fleet_state, 0, router);
+}
+
+/// \brief Count the trips that are dispatched.
+size_t count_dispatched_trips(const std::vector<Trip> &trips) {
+    size_t num_dispatched_trips = 0;
+    for (const auto &trip : trips) {
+        num_dispatched_trips += trip.status == TripStatus::DISPATCHED;
+    }
+
+    return num_dispatched_trips;
+}
+
+} // namespace
+
+TEST(AssignTripsThroughZonedInsertionHeuristics, dispatch_against_local_vehicles_first) {
+    // Two zones split at lon 114.2, with vehicle 2 in the west zone right next to the border.
+    const ZoneGrid zone_grid{{114.0, 114.4, 22.0, 22.2}, 2, 1};
+    std::vector<Vehicle> vehicles = {Vehicle{0, Pos{114.05, 22.1}, 1, 0},
+                                     Vehicle{1, Pos{114.35, 22.1}, 1, 0},
+                                     Vehicle{2, Pos{114.19, 22.1}, 1, 0}};
+
+    // Trip 0 is in the interior of the east zone, about 1km from the border, and goes to the local
+    // vehicle 1 even though vehicle 2 is closer. Trip 1 is on the border and is reconciled against
+    // all vehicles, where vehicle 2 is the closest. Trip 2 is in the interior of the west zone.
+    std::vector<Trip> trips = {create_trip(0, Pos{114.21, 22.1}),
+                               create_trip(1, Pos{114.2, 22.11}),
+                               create_trip(2, Pos{114.06, 22.1})};
+
+    dispatch_zones(trips, vehicles, zone_grid, 2);
+
+    for (const auto &trip : trips) {
+        EXPECT_EQ(trip.status, TripStatus::DISPATCHED);
+    }
+    for (auto i : {0, 1, 2}) {
+        ASSERT_EQ(vehicles[i].waypoints.size(), 2);
+    }
+    EXPECT_EQ(vehicles[0].waypoints[0].trip_id, 2);
+    EXPECT_EQ(vehicles[1].waypoints[0].trip_id, 0);
+    EXPECT_EQ(vehicles[2].waypoints[0].trip_id, 1);
+}
+
+TEST(AssignTripsThroughZonedInsertionHeuristics, reproduce_assignments_regardless_of_threads) {
+    const AreaConfig area_config{114.10, 114.30, 22.20, 22.35};
+    const ZoneGrid zone_grid{area_config, 4, 4};
+
+    // Scatter more trips than the vehicles can serve over the area.
+    std::mt19937 rng{0};
+    std::uniform_real_distribution<float> lon(area_config.lon_min, area_config.lon_max);
+    std::uniform_real_distribution<float> lat(area_config.lat_min, area_config.lat_max);
+
+    std::vector<Vehicle> initial_vehicles;
+    for (auto i = 0; i < 100; i++) {
+        initial_vehicles.emplace_back(Vehicle{static_cast<size_t>(i), Pos{lon(rng), lat(rng)}, 2});
+    }
+    std::vector<Trip> initial_trips;
+    for (auto i = 0; i < 300; i++) {
+        initial_trips.emplace_back(create_trip(i, Pos{lon(rng), lat(rng)}));
+        initial_trips.back().max_pickup_time_ms = 300 * 1000;
+    }
+
+    auto trips = initial_trips;
+    auto vehicles = initial_vehicles;
+    dispatch_zones(trips, vehicles, zone_grid, 1);
+
+    const auto num_dispatched_trips = count_dispatched_trips(trips);
+    EXPECT_GT(num_dispatched_trips, 0);
+    EXPECT_LT(num_dispatched_trips, trips.size());
+
+    for (auto num_threads : {2, 4, 8}) {
+        auto other_trips = initial_trips;
+        auto other_vehicles = initial_vehicles;
+        dispatch_zones(other_trips, other_vehicles, zone_grid, num_threads);
+
+        for (auto i = 0; i < trips.size(); i++) {
+            EXPECT_EQ(trips[i].status, other_trips[i].status);
+        }
+        for (auto i = 0; i < vehicles.size(); i++) {
+            ASSERT_EQ(vehicles[i].waypoints.size(), other_vehicles[i].waypoints.size());
+            for (auto j = 0; j < vehicles[i].waypoints.size(); j++) {
+                EXPECT_EQ(vehicles[i].waypoints[j].trip_id, other_vehicles[i].waypoints[j].trip_id);
+                EXPECT_EQ(vehicles[i].waypoints[j].op, other_vehicles[i].waypoints[j].op);
+            }
+        }
+    }
+}
+
+TEST(AssignTripsThroughZonedInsertionHeuristics, serve_nearly_as_many_trips_as_global_dispatch) {
+    const AreaConfig area_config{114.10, 114.30, 22.20, 22.35};
+    const ZoneGrid zone_grid{area_config, 4, 4};
+
+    // Scatter more trips than the vehicles can serve over the area, so that the service rate tells
+    // how well each dispatch matches the trips to the vehicles.
+    std::mt19937 rng{1};
+    std::uniform_real_distribution<float> lon(area_config.lon_min, area_config.lon_max);
+    std::uniform_real_distribution<float> lat(area_config.lat_min, area_config.lat_max);
+
+    std::vector<Vehicle> initial_vehicles;
+    for (auto i = 0; i < 200; i++) {
+        initial_vehicles.emplace_back(Vehicle{static_cast<size_t>(i), Pos{lon(rng), lat(rng)}, 2});
+    }
+    std::vector<Trip> initial_trips;
+    for (auto i = 0; i < 600; i++) {
+        initial_trips.emplace_back(create_trip(i, Pos{lon(rng), lat(rng)}));
+        initial_trips.back().max_pickup_time_ms = 300 * 1000;
+    }
+
+    auto global_trips = initial_trips;
+    auto global_vehicles = initial_vehicles;
+    dispatch_globally(global_trips, global_vehicles);
+    const auto num_globally_dispatched_trips = count_dispatched_trips(global_trips);
+
+    auto zoned_trips = initial_trips;
+    auto zoned_vehicles = initial_vehicles;
+    dispatch_zones(zoned_trips, zoned_vehicles, zone_grid, 4);
+    const auto num_zoned_dispatched_trips = count_dispatched_trips(zoned_trips);
+
+    // The interior trips of a zone only see the local vehicles, which costs the zoned dispatch
+    // some of the trips that a vehicle across the border could serve. Record the service rates,
+    // and bound the cost to a few percent of the trips.
+    const auto global_service_rate =
+        static_cast<double>(num_globally_dispatched_trips) / initial_trips.size();
+    const auto zoned_service_rate =
+        static_cast<double>(num_zoned_dispatched_trips) / initial_trips.size();
+    RecordProperty("global_service_rate", std::to_string(global_service_rate));
+    RecordProperty("zoned_service_rate", std::to_string(zoned_service_rate));
+
+    EXPECT_GT(num_globally_dispatched_trips, 0);
+    EXPECT_LT(num_globally_dispatched_trips, initial_trips.size());
+    EXPECT_NEAR(zoned_service_rate, global_service_rate, 0.05);
+}
@@ -0,0 +1,97 @@
+/// \author Jian Wen
+/// \date 2021/02/15
+
+#include "../src/dispatch.hpp"
+#include "../src/features.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/// \brief A router that returns straight routes traveled at 10 m/s, 1 degree being 100 km.
+RoutingResponse route_straight(const Pos &origin, const Pos &destination, RoutingType type) {
+    const int32_t distance_mm =
+        (abs(origin.lon - destination.lon) + abs(origin.lat - destination.lat)) * 1e8;
+
+    RoutingResponse response;
+    response.status = RoutingStatus::OK;
+    response.route.distance_mm = distance_mm + 1;
+    response.route.duration_ms = distance_mm / 10 + 1;
+
+    if (type == RoutingType::FULL_ROUTE) {
+        Step step{response.route.distance_mm, response.route.duration_ms, {origin, destination}};
+        response.route.legs.emplace_back(
+            Leg{response.route.distance_mm, response.route.duration_ms, {step}});
+    }
+
+    return response;
+}
+
+} // namespace
+
+TEST(ExtractFeatures, fill_columns_with_vehicles_varying_fastest) {
+    std::vector<Trip> trips(1);
+    trips[0].id = 0;
+    trips[0].origin = Pos{0.01, 0.0};
+    trips[0].destination = Pos{0.02, 0.0};
+    trips[0].max_pickup_time_ms = 1600000;
+
+    Waypoint waypoint{Pos{0.0, 0.03}, WaypointOp::DROPOFF, 0, Route{30000, 3000, {}}};
+    std::vector<Vehicle> vehicles = {Vehicle{0, Pos{0.0, 0.0}, 2, 0, {}, 0, 0},
+                                     Vehicle{1, Pos{0.0, 0.01}, 2, 1, {waypoint}, 0, 0}};
+
+    std::vector<float> data(static_cast<size_t>(Feature::COUNT) * 4);
+    FeatureBuffer buffer{data.data(), 4};
+
+    auto num_rows = extract_features({0}, trips, {0, 1}, vehicles, 1000000, buffer);
+
+    EXPECT_EQ(num_rows, 2);
+
+    EXPECT_FLOAT_EQ(buffer.column(Feature::TRIP_ORIGIN_LON)[0], 0.01);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::TRIP_ORIGIN_LON)[1], 0.01);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::VEHICLE_LAT)[0], 0.0);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::VEHICLE_LAT)[1], 0.01);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::VEHICLE_LOAD)[1], 1.0);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::PLAN_LENGTH)[0], 0.0);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::PLAN_LENGTH)[1], 1.0);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::NEXT_STOP_ETA_S)[1], 3.0);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::PLAN_END_LAT)[0], 0.0);
+    EXPECT_FLOAT_EQ(buffer.column(Feature::PLAN_END_LAT)[1], 0.03);
+
+    // 0.01 degree of longitude at the equator is ~1112m, traveled at the max speed of 35 m/s.
+    EXPECT_NEAR(buffer.column(Feature::PICKUP_LOWER_BOUND_S)[0], 31.77, 0.01);
+    EXPECT_NEAR(buffer.column(Feature::PICKUP_SLACK_S)[0], 600 - 31.77, 0.01);
+    EXPECT_GT(buffer.column(Feature::PICKUP_LOWER_BOUND_S)[1],
+              buffer.column(Feature::PICKUP_LOWER_BOUND_S)[0]);
+}
+
+TEST(AssignTripsThroughBatchScoring, assign_to_the_best_scored_vehicle) {
+    std::vector<Trip> trips(2);
+    for (auto i = 0; i < trips.size(); i++) {
+        trips[i].id = i;
+        trips[i].status = TripStatus::REQUESTED;
+        trips[i].max_pickup_time_ms = 600000;
+    }
+    trips[0].origin = Pos{0.0, 0.01};
+    trips[0].destination = Pos{0.0, 0.02};
+    trips[1].origin = Pos{1.0, 1.0}; // too far for any vehicle
+    trips[1].destination = Pos{1.0, 1.01};
+
+    std::vector<Vehicle> vehicles = {Vehicle{0, Pos{0.0, 0.0}, 2, 0, {}, 0, 0},
+                                     Vehicle{1, Pos{0.0, 0.009}, 2, 0, {}, 0, 0}};
+
+    std::vector<float> data(static_cast<size_t>(Feature::COUNT) * 4);
+    std::vector<float> scores(4);
+    FeatureBuffer buffer{data.data(), 4};
+
+    auto router_func = route_straight;
+    auto scorer_func = score_by_pickup_lower_bound;
+    assign_trips_through_batch_scoring(
+        {0, 1}, trips, vehicles, 0, router_func, scorer_func, buffer, scores.data());
+
+    EXPECT_EQ(trips[0].status, TripStatus::DISPATCHED);
+    EXPECT_EQ(trips[1].status, TripStatus::WALKAWAY);
+
+    EXPECT_TRUE(vehicles[0].waypoints.empty());
+    EXPECT_EQ(vehicles[1].waypoints.size(), 2);
+}
@@ -0,0 +1,47 @@
+/// \author Jian Wen
+/// \date 2021/02/16
+
+#include "../src/fleet.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(SyncFleetState, mirror_hot_states_of_vehicles) {
+    Waypoint waypoint1{Pos{1, 1}, WaypointOp::PICKUP, 0, Route{10000, 1000, {}}};
+    Waypoint waypoint2{Pos{2, 2}, WaypointOp::DROPOFF, 0, Route{20000, 2000, {}}};
+    std::vector<Vehicle> vehicles = {Vehicle{0, Pos{0, 0}, 2, 0, {}, 0, 0},
+                                     Vehicle{1, Pos{0.5, 0.5}, 4, 1, {waypoint1, waypoint2}, 0, 0}};
+
+    FleetState fleet_state;
+    sync_fleet_state(fleet_state, vehicles, 100000);
+
+    EXPECT_EQ(fleet_state.lon.size(), 2);
+    EXPECT_FLOAT_EQ(fleet_state.lon[1], 0.5);
+    EXPECT_EQ(fleet_state.load[1], 1);
+    EXPECT_EQ(fleet_state.capacity[1], 4);
+    EXPECT_EQ(fleet_state.next_stop_time_ms[0], 100000);
+    EXPECT_EQ(fleet_state.next_stop_time_ms[1], 101000);
+    EXPECT_FLOAT_EQ(fleet_state.plan_end_lon[0], 0.0);
+    EXPECT_FLOAT_EQ(fleet_state.plan_end_lon[1], 2.0);
+    EXPECT_EQ(fleet_state.plan_end_time_ms[1], 103000);
+}
+
+TEST(FilterVehiclesByPickupDeadline, rule_out_vehicles_too_far_away) {
+    std::vector<Vehicle> vehicles = {Vehicle{0, Pos{114.00, 22.30}, 2, 0, {}, 0, 0},
+                                     Vehicle{1, Pos{114.10, 22.30}, 2, 0, {}, 0, 0},
+                                     Vehicle{2, Pos{114.20, 22.35}, 2, 0, {}, 0, 0}};
+
+    FleetState fleet_state;
+    sync_fleet_state(fleet_state, vehicles, 0);
+
+    // The pickup is ~10km from Vehicle #1, which takes at least ~295s at 35 m/s.
+    std::vector<size_t> vehicle_ids;
+    filter_vehicles_by_pickup_deadline(fleet_state, Pos{114.20, 22.30}, 0, 300000, vehicle_ids);
+    EXPECT_EQ(vehicle_ids, (std::vector<size_t>{1, 2}));
+
+    filter_vehicles_by_pickup_deadline(fleet_state, Pos{114.20, 22.30}, 0, 250000, vehicle_ids);
+    EXPECT_EQ(vehicle_ids, (std::vector<size_t>{2}));
+
+    filter_vehicles_by_pickup_deadline(
+        fleet_state, Pos{114.20, 22.30}, 300001, 300000, vehicle_ids);
+    EXPECT_TRUE(vehicle_ids.empty());
+}
@@ -0,0 +1,139 @@
+/// \author Jian Wen
+/// \date 2021/02/25
+
+#include "../src/kpi.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+TEST(LatencyHistogram, percentiles_within_one_percent) {
+    std::mt19937 rng{0};
+    std::exponential_distribution<double> distribution{1.0 / 300000};
+
+    LatencyHistogram histogram;
+    std::vector<uint64_t> values;
+    for (auto i = 0; i < 100000; i++) {
+        values.push_back(static_cast<uint64_t>(distribution(rng)));
+        histogram.record(values.back());
+    }
+    std::sort(values.begin(), values.end());
+
+    EXPECT_EQ(histogram.get_count(), values.size());
+    for (auto quantile : {0.5, 0.9, 0.99}) {
+        const auto exact_value = values[std::ceil(quantile * values.size()) - 1];
+        EXPECT_NEAR(histogram.get_percentile_ms(quantile), exact_value, exact_value * 0.01);
+    }
+}
+
+TEST(LatencyHistogram, small_values_are_exact) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.get_percentile_ms(0.5), 0.0);
+
+    for (auto value : {3, 1, 2, 100}) {
+        histogram.record(value);
+    }
+
+    EXPECT_EQ(histogram.get_percentile_ms(0.0), 1.0);
+    EXPECT_EQ(histogram.get_percentile_ms(0.5), 2.0);
+    EXPECT_EQ(histogram.get_percentile_ms(0.75), 3.0);
+    EXPECT_EQ(histogram.get_percentile_ms(1.0), 100.0);
+}
+
+TEST(LatencyHistogram, merge_equals_recording_all) {
+    LatencyHistogram all;
+    LatencyHistogram odd;
+    LatencyHistogram even;
+    for (auto i = 0; i < 1000; i++) {
+        all.record(i * 1000);
+        (i % 2 ? odd : even).record(i * 1000);
+    }
+    odd.merge(even);
+
+    EXPECT_EQ(odd.get_count(), all.get_count());
+    for (auto quantile : {0.1, 0.5, 0.9, 0.99}) {
+        EXPECT_EQ(odd.get_percentile_ms(quantile), all.get_percentile_ms(quantile));
+    }
+}
+
+TEST(KpiAccumulator, trips_counted_in_window_of_request) {
+    KpiAccumulator kpi_accumulator{1000, 31000, 2, 10000};
+    ASSERT_EQ(kpi_accumulator.get_windows().size(), 3);
+
+    // A trip requested in the warm-up is not counted.
+    Trip warmup_trip;
+    warmup_trip.request_time_ms = 500;
+    kpi_accumulator.record_request(warmup_trip);
+
+    Trip trip;
+    trip.request_time_ms = 12000;
+    trip.status = TripStatus::DISPATCHED;
+    kpi_accumulator.record_request(trip);
+    kpi_accumulator.record_dispatch(trip);
+
+    trip.status = TripStatus::DROPPED_OFF;
+    trip.pickup_time_ms = 15000;
+    trip.dropoff_time_ms = 35000;
+    kpi_accumulator.record_dropoff(trip);
+
+    Trip walkaway_trip;
+    walkaway_trip.request_time_ms = 25000;
+    walkaway_trip.status = TripStatus::WALKAWAY;
+    kpi_accumulator.record_request(walkaway_trip);
+    kpi_accumulator.record_dispatch(walkaway_trip);
+
+    // The distance traveled at the end of the main simulation goes to the last window.
+    kpi_accumulator.record_distance(5000, 100, 0);
+    kpi_accumulator.record_distance(31000, 200, 200);
+
+    const auto &total = kpi_accumulator.get_total();
+    EXPECT_EQ(total.trip_count, 2);
+    EXPECT_EQ(total.dispatched_trip_count, 1);
+    EXPECT_EQ(total.completed_trip_count, 1);
+    EXPECT_EQ(total.total_wait_time_ms, 3000);
+    EXPECT_EQ(total.total_travel_time_ms, 20000);
+    EXPECT_EQ(total.dist_traveled_mm, 300);
+    EXPECT_EQ(total.loaded_dist_traveled_mm, 200);
+
+    const auto &windows = kpi_accumulator.get_windows();
+    EXPECT_EQ(windows[0].trip_count, 0);
+    EXPECT_EQ(windows[0].dist_traveled_mm, 100);
+    EXPECT_EQ(windows[1].trip_count, 1);
+    EXPECT_EQ(windows[1].completed_trip_count, 1);
+    EXPECT_EQ(windows[2].trip_count, 1);
+    EXPECT_EQ(windows[2].dispatched_trip_count, 0);
+    EXPECT_EQ(windows[2].dist_traveled_mm, 200);
+}
+
+TEST(KpiAccumulator, merge_and_save_state) {
+    KpiAccumulator kpi_accumulator{0, 60000, 10};
+    KpiAccumulator other{0, 60000, 20};
+
+    Trip trip;
+    trip.request_time_ms = 1000;
+    trip.pickup_time_ms = 61000;
+    trip.dropoff_time_ms = 121000;
+    kpi_accumulator.record_dropoff(trip);
+    other.record_dropoff(trip);
+    kpi_accumulator.merge(other);
+
+    EXPECT_EQ(kpi_accumulator.get_num_vehicles(), 30);
+    EXPECT_EQ(kpi_accumulator.get_total().completed_trip_count, 2);
+    EXPECT_NEAR(kpi_accumulator.get_wait_time_histogram().get_percentile_ms(0.5), 60000, 600);
+
+    std::stringstream stream;
+    kpi_accumulator.save_state(stream);
+
+    KpiAccumulator restored;
+    restored.load_state(stream);
+
+    EXPECT_EQ(restored.get_num_vehicles(), 30);
+    EXPECT_EQ(restored.get_windows().size(), 1);
+    EXPECT_EQ(restored.get_total().total_wait_time_ms, 120000);
+    EXPECT_EQ(restored.get_travel_time_histogram().get_percentile_ms(0.99),
+              kpi_accumulator.get_travel_time_histogram().get_percentile_ms(0.99));
+}
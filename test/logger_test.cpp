@@ -0,0 +1,91 @@
+/// \author Jian Wen
+/// \date 2021/02/26
+
+#include "../src/logger.hpp"
+#include "../src/ring_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+TEST(SpscRingBuffer, push_and_pop_in_order) {
+    SpscRingBuffer<int, 4> ring_buffer;
+    EXPECT_TRUE(ring_buffer.empty());
+
+    for (auto i = 0; i < 4; i++) {
+        EXPECT_TRUE(ring_buffer.try_push(i));
+    }
+    EXPECT_FALSE(ring_buffer.try_push(4));
+
+    int item = -1;
+    for (auto i = 0; i < 4; i++) {
+        EXPECT_TRUE(ring_buffer.try_pop(item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_FALSE(ring_buffer.try_pop(item));
+    EXPECT_TRUE(ring_buffer.empty());
+}
+
+TEST(SpscRingBuffer, transfer_between_threads) {
+    SpscRingBuffer<size_t, 64> ring_buffer;
+    const size_t num_items = 100000;
+
+    std::thread producer{[&]() {
+        for (size_t i = 0; i < num_items; i++) {
+            while (!ring_buffer.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    // Every item arrives exactly once and in order.
+    size_t expected_item = 0;
+    size_t item = 0;
+    while (expected_item < num_items) {
+        if (ring_buffer.try_pop(item)) {
+            ASSERT_EQ(item, expected_item);
+            expected_item++;
+        }
+    }
+    producer.join();
+}
+
+TEST(Logger, write_log_record_from_fields) {
+    auto file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+
+    write_log_record(
+        file, LogRecord{LogLevel::DEBUG, LogEvent::TRIP_PICKED_UP, {uint64_t{61500}, 3ul, 7ul}});
+    write_log_record(file,
+                     LogRecord{LogLevel::DEBUG,
+                               LogEvent::TRIP_ASSIGNED_BY_SCORE,
+                               {uint64_t{7}, uint64_t{3}, uint64_t{0}, 0.5f}});
+
+    std::string output(256, '\0');
+    std::rewind(file);
+    output.resize(std::fread(&output[0], 1, output.size(), file));
+    std::fclose(file);
+
+    EXPECT_EQ(output,
+              "[DEBUG] T = 61.5s: Vehicle #3 picked up Trip #7\n"
+              "[DEBUG] Assigned Trip #7 to Vehicle #3 (ranked #0 by score 0.5).\n");
+}
+
+TEST(Logger, wake_up_sink_for_records_after_idle_period) {
+    auto &logger = Logger::get_instance();
+
+    // The sink goes to sleep between the records, and each record from any thread must wake it up
+    // again, or the flush would never return.
+    for (auto i = 0; i < 3; i++) {
+        std::thread producer{[&logger, i]() {
+            logger.push(LogRecord{LogLevel::DEBUG, LogEvent::TRIP_UNASSIGNED, {uint64_t(i)}});
+        }};
+        producer.join();
+        logger.flush();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
@@ -0,0 +1,65 @@
+/// \author Jian Wen
+/// \date 2021/03/04
+
+#include "../src/datalog.hpp"
+#include "../src/memory.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+TEST(Memory, count_heap_bytes_of_routes) {
+    Route route;
+    route.legs.reserve(2);
+    route.legs.push_back({0, 0, {{0, 0, std::vector<Pos>(10)}, {0, 0, std::vector<Pos>(5)}}});
+    route.poses.resize(14);
+    route.time_offsets_ms.resize(14);
+    route.distance_offsets_mm.resize(14);
+
+    // The reserved capacity counts as well.
+    const auto route_bytes = 2 * sizeof(Leg) + 2 * sizeof(Step) + 15 * sizeof(Pos) +
+                             14 * sizeof(Pos) + 2 * 14 * sizeof(int32_t);
+    EXPECT_EQ(get_heap_bytes(route), route_bytes);
+
+    std::vector<Vehicle> vehicles(2);
+    vehicles[0].waypoints.push_back({Pos{}, WaypointOp::PICKUP, 0, route});
+    vehicles[0].waypoints.push_back({Pos{}, WaypointOp::DROPOFF, 0, Route{}});
+    EXPECT_GE(get_heap_bytes(vehicles[0].waypoints), 2 * sizeof(Waypoint));
+    EXPECT_EQ(get_route_heap_bytes(vehicles),
+              get_heap_bytes(vehicles[0].waypoints) + get_heap_bytes(vehicles[1].waypoints) +
+                  get_heap_bytes(vehicles[0].waypoints[0].route));
+}
+
+TEST(Memory, count_heap_bytes_of_datalog_frames) {
+    DatalogFrame frame;
+    EXPECT_EQ(get_heap_bytes(frame), 0);
+
+    frame.vehicle_poses.resize(3);
+    frame.trips.resize(2);
+    EXPECT_EQ(get_heap_bytes(frame), 3 * sizeof(Pos) + 2 * sizeof(Trip));
+}
+
+TEST(Memory, update_peak_by_field) {
+    MemoryUsage peak_usage;
+    update_peak_memory_usage(peak_usage, {100, 1, 50, 0, 1000});
+    update_peak_memory_usage(peak_usage, {80, 2, 100, 10, 900});
+
+    EXPECT_EQ(peak_usage.route_bytes, 100);
+    EXPECT_EQ(peak_usage.trip_count, 2);
+    EXPECT_EQ(peak_usage.trip_bytes, 100);
+    EXPECT_EQ(peak_usage.datalog_bytes, 10);
+    EXPECT_EQ(peak_usage.rss_bytes, 1000);
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+TEST(Memory, sample_resident_bytes) {
+    const auto resident_bytes = get_resident_bytes();
+    EXPECT_GT(resident_bytes, 0);
+
+    // Touching a large buffer raises the resident set size.
+    std::vector<char> buffer(64 << 20, 1);
+    EXPECT_GT(get_resident_bytes(), resident_bytes + (32 << 20));
+    EXPECT_GT(get_peak_resident_bytes(), 32 << 20);
+    EXPECT_EQ(buffer.back(), 1);
+}
+#endif
@@ -0,0 +1,122 @@
+/// \author Jian Wen
+/// \date 2021/03/06
+
+#include "../benchmark/straight_line_router.hpp"
+#include "../src/demand_generator.hpp"
+#include "../src/platform.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// \brief Create a small platform config, with the output off.
+PlatformConfig create_platform_config() {
+    PlatformConfig platform_config;
+    platform_config.area_config = {114.0, 114.4, 22.1, 22.5};
+    platform_config.mod_system_config.fleet_config = {10, 2, 114.2, 22.3};
+    platform_config.mod_system_config.request_config.max_pickup_wait_time_s = 600;
+    platform_config.simulation_config = {60, 1200, 600, 600};
+
+    return platform_config;
+}
+
+/// \brief Create the demand generator, with one of the ODs starting right where the vehicles start,
+/// so that some pickups take no time to reach.
+DemandGenerator create_demand_generator(uint64_t seed) {
+    const std::vector<Od> ods = {{Pos{114.2, 22.3}, Pos{114.25, 22.32}},
+                                 {Pos{114.15, 22.25}, Pos{114.25, 22.30}},
+                                 {Pos{114.22, 22.32}, Pos{114.16, 22.26}}};
+    const std::vector<double> trips_per_hour = {30, 40, 30};
+
+    return DemandGenerator{ods, trips_per_hour, seed};
+}
+
+/// \brief Run the platform with the config through the whole simulation.
+SimulationReport run_platform(const PlatformConfig &platform_config,
+                              uint64_t seed,
+                              const std::string &path_to_checkpoint = "") {
+    Platform<StraightLineRouter, DemandGenerator> platform{
+        platform_config, StraightLineRouter{}, create_demand_generator(seed)};
+
+    return platform.run_simulation(path_to_checkpoint);
+}
+
+/// \brief Resume the simulation from the checkpoint in a fresh platform.
+SimulationReport resume_platform(const PlatformConfig &platform_config,
+                                 uint64_t seed,
+                                 const std::string &path_to_checkpoint) {
+    Platform<StraightLineRouter, DemandGenerator> platform{
+        platform_config, StraightLineRouter{}, create_demand_generator(seed)};
+    platform.load_checkpoint(path_to_checkpoint);
+
+    return platform.run_simulation();
+}
+
+/// \brief Expect the KPIs of the reports to be identical.
+void expect_identical_kpis(const SimulationReport &report, const SimulationReport &other_report) {
+    EXPECT_EQ(report.trip_count, other_report.trip_count);
+    EXPECT_EQ(report.dispatched_trip_count, other_report.dispatched_trip_count);
+    EXPECT_EQ(report.completed_trip_count, other_report.completed_trip_count);
+    EXPECT_DOUBLE_EQ(report.average_wait_time_s, other_report.average_wait_time_s);
+    EXPECT_DOUBLE_EQ(report.average_travel_time_s, other_report.average_travel_time_s);
+    EXPECT_DOUBLE_EQ(report.p50_wait_time_s, other_report.p50_wait_time_s);
+    EXPECT_DOUBLE_EQ(report.p90_wait_time_s, other_report.p90_wait_time_s);
+    EXPECT_DOUBLE_EQ(report.p99_wait_time_s, other_report.p99_wait_time_s);
+    EXPECT_DOUBLE_EQ(report.p50_travel_time_s, other_report.p50_travel_time_s);
+    EXPECT_DOUBLE_EQ(report.p90_travel_time_s, other_report.p90_travel_time_s);
+    EXPECT_DOUBLE_EQ(report.p99_travel_time_s, other_report.p99_travel_time_s);
+    EXPECT_DOUBLE_EQ(report.average_distance_traveled_m, other_report.average_distance_traveled_m);
+    EXPECT_DOUBLE_EQ(report.average_distance_traveled_per_hour_m,
+                     other_report.average_distance_traveled_per_hour_m);
+    EXPECT_DOUBLE_EQ(report.average_load, other_report.average_load);
+}
+
+} // namespace
+
+TEST(Platform, reproduce_kpis_in_event_driven_mode) {
+    auto platform_config = create_platform_config();
+    const auto frame_stepped_report = run_platform(platform_config, 1);
+
+    platform_config.simulation_config.event_driven = true;
+    const auto event_driven_report = run_platform(platform_config, 1);
+
+    EXPECT_GT(frame_stepped_report.completed_trip_count, 0);
+    expect_identical_kpis(frame_stepped_report, event_driven_report);
+}
+
+TEST(Platform, resume_from_checkpoint_as_if_uninterrupted) {
+    const std::string path = "platform_test.ckpt";
+    auto platform_config = create_platform_config();
+
+    for (auto event_driven : {false, true}) {
+        platform_config.simulation_config.event_driven = event_driven;
+        const auto uninterrupted_report = run_platform(platform_config, 1);
+
+        // The checkpoint is saved once the warm-up is done, with trips already on the way. Saving
+        // it must not change the run, and the resumed run must end up where the uninterrupted one
+        // does, even though the demand generator is created with a different seed.
+        const auto checkpointed_report = run_platform(platform_config, 1, path);
+        const auto resumed_report = resume_platform(platform_config, 2, path);
+        std::remove(path.c_str());
+
+        EXPECT_GT(uninterrupted_report.completed_trip_count, 0);
+        expect_identical_kpis(uninterrupted_report, checkpointed_report);
+        expect_identical_kpis(uninterrupted_report, resumed_report);
+    }
+}
+
+TEST(Platform, report_rss_growth_of_own_simulation_only) {
+    // Hold on to memory taken before the platform, as an earlier scenario in the process would.
+    const size_t num_earlier_bytes = 256 * 1024 * 1024;
+    std::vector<char> earlier_memory(num_earlier_bytes, 1);
+
+    const auto report = run_platform(create_platform_config(), 0);
+
+    EXPECT_GE(report.peak_rss_bytes, num_earlier_bytes);
+    EXPECT_LT(report.peak_rss_growth_bytes, num_earlier_bytes / 4);
+    EXPECT_EQ(earlier_memory.back(), 1);
+}
@@ -0,0 +1,58 @@
+/// \author Jian Wen
+/// \date 2021/02/18
+
+#include "../src/random.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(Philox4x32, match_known_answers) {
+    // Known answer tests from the reference implementation (Random123).
+    auto block = philox4x32({0, 0, 0, 0}, {0, 0});
+    EXPECT_EQ(block, (std::array<uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+
+    block = philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff});
+    EXPECT_EQ(block, (std::array<uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+}
+
+TEST(RandomStream, fill_uniform_is_identical_to_next_uniform) {
+    RandomStream stream1{42, make_stream_id(1, 7)};
+    RandomStream stream2{42, make_stream_id(1, 7)};
+
+    // Start from an odd position to exercise the partially consumed block.
+    EXPECT_EQ(stream1.next_uint32(), stream2.next_uint32());
+
+    std::vector<double> uniforms(9);
+    stream1.fill_uniform(uniforms.data(), uniforms.size());
+
+    for (auto u : uniforms) {
+        EXPECT_EQ(u, stream2.next_uniform());
+        EXPECT_GE(u, 0.0);
+        EXPECT_LT(u, 1.0);
+    }
+    EXPECT_EQ(stream1.get_position(), 19);
+    EXPECT_EQ(stream2.get_position(), 19);
+}
+
+TEST(RandomStream, restore_from_position) {
+    RandomStream stream1{42, 3};
+    for (auto i = 0; i < 5; i++) {
+        stream1.next_uint32();
+    }
+
+    RandomStream stream2{42, 3};
+    stream2.set_position(stream1.get_position());
+
+    for (auto i = 0; i < 10; i++) {
+        EXPECT_EQ(stream1.next_uint32(), stream2.next_uint32());
+    }
+}
+
+TEST(RandomStream, differ_across_streams_and_seeds) {
+    RandomStream stream1{42, 0};
+    RandomStream stream2{42, 1};
+    RandomStream stream3{43, 0};
+
+    const auto x1 = stream1.next_uint32();
+    EXPECT_NE(x1, stream2.next_uint32());
+    EXPECT_NE(x1, stream3.next_uint32());
+}
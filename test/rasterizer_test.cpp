@@ -0,0 +1,106 @@
+/// \author Jian Wen
+/// \date 2021/02/28
+
+#include "../src/rasterizer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+namespace {
+
+Image create_white_image(size_t width, size_t height) {
+    return Image{width, height, std::vector<uint8_t>(width * height * 3, 255)};
+}
+
+uint8_t get_red(const Image &image, size_t x, size_t y) {
+    return image.pixels[(y * image.width + x) * 3];
+}
+
+} // namespace
+
+TEST(Rasterizer, draw_rectangle_with_partial_coverage) {
+    auto image = create_white_image(10, 10);
+    Rasterizer rasterizer{image};
+
+    rasterizer.draw_rectangle({2, 2}, {4.5, 4}, {0, 0, 0, 1.0});
+
+    EXPECT_EQ(get_red(image, 1, 2), 255);
+    EXPECT_EQ(get_red(image, 2, 2), 0);
+    EXPECT_EQ(get_red(image, 3, 3), 0);
+    EXPECT_EQ(get_red(image, 4, 3), 127);
+    EXPECT_EQ(get_red(image, 5, 3), 255);
+    EXPECT_EQ(get_red(image, 3, 4), 255);
+}
+
+TEST(Rasterizer, draw_translucent_polyline_uniformly) {
+    auto image = create_white_image(20, 10);
+    Rasterizer rasterizer{image};
+
+    // The joints of the segments are not blended more than once.
+    const std::vector<Point> points{{2, 5}, {5, 5}, {8, 5}, {11, 5}, {14, 5}};
+    rasterizer.draw_polyline(points.data(), points.size(), 4, LineStyle::SOLID, {0, 0, 0, 0.5});
+
+    for (auto x = 3; x <= 13; x++) {
+        EXPECT_EQ(get_red(image, x, 4), 127);
+        EXPECT_EQ(get_red(image, x, 5), 127);
+    }
+    EXPECT_EQ(get_red(image, 17, 5), 255);
+    EXPECT_EQ(get_red(image, 10, 0), 255);
+}
+
+TEST(Rasterizer, draw_dashed_polyline_with_gaps) {
+    auto image = create_white_image(100, 10);
+    Rasterizer rasterizer{image};
+
+    const std::vector<Point> points{{0, 5}, {50, 5}, {100, 5}};
+    rasterizer.draw_polyline(points.data(), points.size(), 2, LineStyle::DASHED, {0, 0, 0, 1.0});
+
+    // Dashes of 3.7 and gaps of 1.6 times the line width.
+    auto num_lit_pixels = 0;
+    for (auto x = 0; x < 100; x++) {
+        num_lit_pixels += get_red(image, x, 5) < 128;
+    }
+    EXPECT_GT(num_lit_pixels, 60);
+    EXPECT_LT(num_lit_pixels, 80);
+    EXPECT_EQ(get_red(image, 3, 5), 0);
+    EXPECT_EQ(get_red(image, 8, 5), 255);
+}
+
+TEST(Rasterizer, draw_text_in_pixel_font) {
+    auto image = create_white_image(20, 10);
+    Rasterizer rasterizer{image};
+
+    rasterizer.draw_text({1, 1}, "T1", 1, {0, 0, 0, 1.0});
+
+    // The top bar and the stem of "T".
+    for (auto x = 1; x <= 5; x++) {
+        EXPECT_EQ(get_red(image, x, 1), 0);
+    }
+    EXPECT_EQ(get_red(image, 3, 7), 0);
+    EXPECT_EQ(get_red(image, 2, 7), 255);
+
+    // The bottom bar of "1", one glyph to the right.
+    EXPECT_EQ(get_red(image, 8, 7), 0);
+    EXPECT_EQ(get_red(image, 10, 7), 0);
+
+    const auto text_size = Rasterizer::get_text_size("T1\nT", 2);
+    EXPECT_FLOAT_EQ(text_size.x, 22);
+    EXPECT_FLOAT_EQ(text_size.y, 32);
+}
+
+TEST(Image, save_and_load_png) {
+    const std::string path = "rasterizer_test.png";
+
+    auto image = create_white_image(7, 5);
+    Rasterizer rasterizer{image};
+    rasterizer.draw_disc({3, 2}, 2, {200, 100, 50, 1.0});
+    save_png_image(path, image);
+
+    const auto loaded_image = load_png_image(path);
+    EXPECT_EQ(loaded_image.width, 7);
+    EXPECT_EQ(loaded_image.height, 5);
+    EXPECT_EQ(loaded_image.pixels, image.pixels);
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,210 @@
+/// \author Jian Wen
+/// \date 2021/03/05
+
+#include "../benchmark/straight_line_router.hpp"
+#include "../src/regression.hpp"
+
+#include <gtest/gtest.h>
+#include <yaml-cpp/yaml.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+TEST(Regression, count_router_calls) {
+    StraightLineRouter router;
+    std::atomic<size_t> num_calls{0};
+    CountingRouterFunc<StraightLineRouter> router_func{router, num_calls};
+
+    const auto response = router_func(Pos{114.1, 22.2}, Pos{114.2, 22.3}, RoutingType::TIME_ONLY);
+    router_func(Pos{114.1, 22.2}, Pos{114.2, 22.3}, RoutingType::FULL_ROUTE);
+
+    EXPECT_EQ(response.status, RoutingStatus::OK);
+    EXPECT_EQ(num_calls.load(), 2);
+}
+
+TEST(Regression, merge_repeated_runs) {
+    const std::vector<RegressionMetric> run = {{"trip_count", MetricCheck::EXACT, 10},
+                                               {"average_load", MetricCheck::EXACT, std::nan("")},
+                                               {"total_runtime_s", MetricCheck::RUNTIME, 2.0},
+                                               {"peak_rss_growth_bytes", MetricCheck::MEMORY, 100}};
+    auto faster_run = run;
+    faster_run[2].value = 1.5;
+
+    // NaN matches itself, and the lowest of the other metrics is taken.
+    auto metrics = merge_repeated_metrics({run, faster_run});
+    ASSERT_EQ(metrics.size(), 5);
+    EXPECT_EQ(metrics[0].value, 10);
+    EXPECT_EQ(metrics[2].value, 1.5);
+    EXPECT_EQ(metrics[3].value, 100);
+    EXPECT_EQ(metrics[4].name, "deterministic");
+    EXPECT_EQ(metrics[4].value, 1.0);
+
+    auto changed_run = run;
+    changed_run[0].value = 11;
+    metrics = merge_repeated_metrics({run, changed_run});
+    EXPECT_EQ(metrics[0].value, 10);
+    EXPECT_EQ(metrics[4].value, 0.0);
+}
+
+TEST(Regression, compare_against_baseline) {
+    const std::vector<RegressionMetric> metrics = {
+        {"trip_count", MetricCheck::EXACT, 10},
+        {"average_wait_time_s", MetricCheck::EXACT, 0.1 + 0.2},
+        {"total_runtime_s", MetricCheck::RUNTIME, 1.3},
+        {"router_calls", MetricCheck::ROUTER_CALLS, 90},
+        {"peak_rss_growth_bytes", MetricCheck::MEMORY, 105},
+        {"peak_trip_bytes", MetricCheck::MEMORY, 10}};
+    const RegressionBaseline baseline = {{"demo",
+                                          {{"trip_count", 10},
+                                           {"average_wait_time_s", 0.3},
+                                           {"total_runtime_s", 1.0},
+                                           {"router_calls", 100},
+                                           {"peak_rss_growth_bytes", 100}}}};
+    const RegressionTolerances tolerances{0.25, 0.05, 0.1};
+
+    const auto diffs = compare_regression_metrics("demo", metrics, baseline, tolerances);
+    ASSERT_EQ(diffs.size(), 6);
+
+    // The exact metrics must match bit by bit, and only the increases beyond the tolerances fail.
+    EXPECT_EQ(diffs[0].status, MetricStatus::OK);
+    EXPECT_EQ(diffs[1].status, MetricStatus::CHANGED);
+    EXPECT_EQ(diffs[2].status, MetricStatus::REGRESSED);
+    EXPECT_EQ(diffs[2].tolerance, 0.25);
+    EXPECT_EQ(diffs[3].status, MetricStatus::IMPROVED);
+    EXPECT_EQ(diffs[4].status, MetricStatus::OK);
+    EXPECT_EQ(diffs[5].status, MetricStatus::MISSING);
+    EXPECT_TRUE(std::isnan(diffs[5].baseline));
+
+    EXPECT_FALSE(is_failed(diffs[0]));
+    EXPECT_TRUE(is_failed(diffs[1]));
+    EXPECT_TRUE(is_failed(diffs[2]));
+    EXPECT_FALSE(is_failed(diffs[3]));
+    EXPECT_TRUE(is_failed(diffs[5]));
+
+    const auto other_diffs = compare_regression_metrics("other", metrics, baseline, tolerances);
+    for (const auto &diff : other_diffs) {
+        EXPECT_EQ(diff.status, MetricStatus::MISSING);
+    }
+}
+
+TEST(Regression, allow_memory_to_grow_by_slack) {
+    const std::vector<RegressionMetric> metrics = {
+        {"peak_rss_growth_bytes", MetricCheck::MEMORY, 4096},
+        {"peak_trip_bytes", MetricCheck::MEMORY, 3000}};
+    const RegressionBaseline baseline = {
+        {"demo", {{"peak_rss_growth_bytes", 0}, {"peak_trip_bytes", 1000}}}};
+
+    // A few pages over a baseline of 0 are within the slack, but not beyond it.
+    RegressionTolerances tolerances;
+    tolerances.peak_memory_slack_bytes = 8192;
+    auto diffs = compare_regression_metrics("demo", metrics, baseline, tolerances);
+    EXPECT_EQ(diffs[0].status, MetricStatus::OK);
+    EXPECT_EQ(diffs[1].status, MetricStatus::OK);
+
+    tolerances.peak_memory_slack_bytes = 1024;
+    diffs = compare_regression_metrics("demo", metrics, baseline, tolerances);
+    EXPECT_EQ(diffs[0].status, MetricStatus::REGRESSED);
+    EXPECT_EQ(diffs[1].status, MetricStatus::REGRESSED);
+}
+
+TEST(Regression, save_and_load_baseline_exactly) {
+    const RegressionBaseline baseline = {
+        {"demo", {{"average_wait_time_s", 0.1 + 0.2}, {"average_load", std::nan("")}}},
+        {"case_study", {{"peak_rss_growth_bytes", 123456789012.0}, {"average_load", 1.0 / 3}}}};
+
+    const std::string path = "regression_test.yml";
+    save_regression_baseline(path, baseline);
+    const auto loaded_baseline = load_regression_baseline(path);
+
+    // The doubles are written with all 17 significant digits, whatever the default of fmt is.
+    std::ifstream baseline_file{path};
+    const std::string baseline_text{std::istreambuf_iterator<char>{baseline_file},
+                                    std::istreambuf_iterator<char>{}};
+    EXPECT_NE(baseline_text.find("average_wait_time_s: 0.30000000000000004"), std::string::npos);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(loaded_baseline.size(), 2);
+    EXPECT_EQ(loaded_baseline.at("demo").at("average_wait_time_s"), 0.1 + 0.2);
+    EXPECT_TRUE(std::isnan(loaded_baseline.at("demo").at("average_load")));
+    EXPECT_EQ(loaded_baseline.at("case_study").at("peak_rss_growth_bytes"), 123456789012.0);
+    EXPECT_EQ(loaded_baseline.at("case_study").at("average_load"), 1.0 / 3);
+}
+
+TEST(Regression, write_diff_as_json) {
+    std::vector<MetricDiff> diffs(2);
+    diffs[0] = {"demo", "trip_count", MetricCheck::EXACT, 10, 10, 0, MetricStatus::OK};
+    diffs[1] = {"demo",
+                "total_runtime_s",
+                MetricCheck::RUNTIME,
+                std::numeric_limits<double>::quiet_NaN(),
+                1.5,
+                0.25,
+                MetricStatus::MISSING};
+
+    const std::string path = "regression_test.json";
+    auto file = std::fopen(path.c_str(), "w");
+    write_regression_diff(file, diffs);
+    std::fclose(file);
+
+    // The json is parsed as yaml, of which it is a subset.
+    const auto diff_json = YAML::LoadFile(path);
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(diff_json["passed"].as<bool>());
+    EXPECT_EQ(diff_json["num_metrics"].as<size_t>(), 2);
+    EXPECT_EQ(diff_json["num_failures"].as<size_t>(), 1);
+    ASSERT_EQ(diff_json["diffs"].size(), 2);
+    EXPECT_EQ(diff_json["diffs"][0]["status"].as<std::string>(), "ok");
+    EXPECT_EQ(diff_json["diffs"][1]["metric"].as<std::string>(), "total_runtime_s");
+    EXPECT_EQ(diff_json["diffs"][1]["check"].as<std::string>(), "runtime");
+    EXPECT_TRUE(diff_json["diffs"][1]["baseline"].IsNull());
+    EXPECT_EQ(diff_json["diffs"][1]["current"].as<double>(), 1.5);
+    EXPECT_EQ(diff_json["diffs"][1]["status"].as<std::string>(), "missing");
+}
+
+TEST(Regression, run_scenario_deterministically) {
+    const std::string path_to_demand = "regression_test_demand.yml";
+    {
+        std::ofstream demand_file{path_to_demand};
+        demand_file << "- origin: {lon: 114.15, lat: 22.25}\n"
+                       "  destination: {lon: 114.25, lat: 22.30}\n"
+                       "  trips_per_hour: 60\n"
+                       "- origin: {lon: 114.22, lat: 22.32}\n"
+                       "  destination: {lon: 114.16, lat: 22.26}\n"
+                       "  trips_per_hour: 40\n";
+    }
+
+    RegressionScenario scenario;
+    scenario.name = "test";
+    scenario.platform_config.area_config = {114.0, 114.4, 22.1, 22.5};
+    scenario.platform_config.mod_system_config.fleet_config = {10, 2, 114.2, 22.3};
+    scenario.platform_config.simulation_config = {60, 1200, 600, 600};
+    scenario.path_to_demand_config = path_to_demand;
+    scenario.seed = 1;
+
+    const auto metrics = run_regression_scenario(scenario, StraightLineRouter{}, 2);
+    std::remove(path_to_demand.c_str());
+
+    RegressionBaseline baseline;
+    for (const auto &metric : metrics) {
+        baseline["test"][metric.name] = metric.value;
+    }
+
+    EXPECT_GT(baseline["test"]["trip_count"], 0);
+    EXPECT_GT(baseline["test"]["router_calls"], 0);
+    EXPECT_GT(baseline["test"]["total_runtime_s"], 0);
+    EXPECT_EQ(baseline["test"]["walkaway_trip_count"],
+              baseline["test"]["trip_count"] - baseline["test"]["dispatched_trip_count"]);
+    EXPECT_EQ(baseline["test"]["deterministic"], 1.0);
+
+    // The scenario checks against its own metrics.
+    const auto diffs = compare_regression_metrics("test", metrics, baseline, {});
+    for (const auto &diff : diffs) {
+        EXPECT_EQ(diff.status, MetricStatus::OK) << diff.metric;
+    }
+}
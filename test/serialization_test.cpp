@@ -0,0 +1,87 @@
+/// \author Jian Wen
+/// \date 2021/02/22
+
+#include "../src/serialization.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+TEST(Serialization, round_trip_trips) {
+    std::vector<Trip> trips{{0, Pos{1.0, 2.0}, Pos{3.0, 4.0}, TripStatus::REQUESTED, 100, 400},
+                            {1, Pos{5.0, 6.0}, Pos{7.0, 8.0}, TripStatus::DISPATCHED, 200, 500}};
+
+    std::stringstream stream;
+    write_binary(stream, trips);
+
+    std::vector<Trip> loaded_trips;
+    read_binary(stream, loaded_trips);
+
+    ASSERT_EQ(loaded_trips.size(), 2);
+    EXPECT_EQ(loaded_trips[1].id, 1);
+    EXPECT_DOUBLE_EQ(loaded_trips[1].destination.lat, 8.0);
+    EXPECT_EQ(loaded_trips[1].status, TripStatus::DISPATCHED);
+    EXPECT_EQ(loaded_trips[1].max_pickup_time_ms, 500);
+}
+
+TEST(Serialization, round_trip_vehicles) {
+    Route route;
+    route.distance_mm = 10000;
+    route.duration_ms = 2000;
+    route.legs.push_back({10000, 2000, {{10000, 2000, {Pos{0, 0}, Pos{0, 5}, Pos{5, 5}}}}});
+    route.poses = {Pos{0, 0}, Pos{0, 5}, Pos{5, 5}};
+    route.time_offsets_ms = {0, 1000, 2000};
+    route.distance_offsets_mm = {0, 5000, 10000};
+    route.cursor = 1;
+    route.elapsed_ms = 1500;
+
+    Vehicle vehicle{3, Pos{0, 0}, 4, 1};
+    vehicle.waypoints.push_back({Pos{5, 5}, WaypointOp::DROPOFF, 7, route});
+    vehicle.dist_traveled_mm = 1234;
+    vehicle.loaded_dist_traveled_mm = 567;
+
+    std::stringstream stream;
+    write_binary(stream, std::vector<Vehicle>{vehicle, vehicle});
+
+    std::vector<Vehicle> loaded_vehicles;
+    read_binary(stream, loaded_vehicles);
+
+    ASSERT_EQ(loaded_vehicles.size(), 2);
+    const auto &loaded_vehicle = loaded_vehicles[1];
+    EXPECT_EQ(loaded_vehicle.id, 3);
+    EXPECT_EQ(loaded_vehicle.capacity, 4);
+    EXPECT_EQ(loaded_vehicle.load, 1);
+    EXPECT_EQ(loaded_vehicle.dist_traveled_mm, 1234);
+    EXPECT_EQ(loaded_vehicle.loaded_dist_traveled_mm, 567);
+
+    ASSERT_EQ(loaded_vehicle.waypoints.size(), 1);
+    const auto &loaded_waypoint = loaded_vehicle.waypoints[0];
+    EXPECT_EQ(loaded_waypoint.op, WaypointOp::DROPOFF);
+    EXPECT_EQ(loaded_waypoint.trip_id, 7);
+
+    const auto &loaded_route = loaded_waypoint.route;
+    EXPECT_EQ(loaded_route.distance_mm, 10000);
+    ASSERT_EQ(loaded_route.legs.size(), 1);
+    ASSERT_EQ(loaded_route.legs[0].steps.size(), 1);
+    ASSERT_EQ(loaded_route.legs[0].steps[0].poses.size(), 3);
+    EXPECT_DOUBLE_EQ(loaded_route.legs[0].steps[0].poses[2].lon, 5.0);
+    EXPECT_EQ(loaded_route.poses.size(), 3);
+    EXPECT_EQ(loaded_route.time_offsets_ms[1], 1000);
+    EXPECT_EQ(loaded_route.distance_offsets_mm[2], 10000);
+    EXPECT_EQ(loaded_route.cursor, 1);
+    EXPECT_EQ(loaded_route.elapsed_ms, 1500);
+}
+
+TEST(Serialization, stop_reading_truncated_stream) {
+    std::stringstream stream;
+    write_binary(stream, std::string{"checkpoint"});
+
+    auto data = stream.str();
+    data.resize(data.size() - 4);
+    std::stringstream truncated_stream{data};
+
+    std::string loaded_string;
+    read_binary(truncated_stream, loaded_string);
+
+    EXPECT_FALSE(truncated_stream);
+}
@@ -0,0 +1,44 @@
+/// \author Jian Wen
+/// \date 2021/03/06
+
+#include "../src/thread_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+TEST(ThreadPool, run_task_on_all_threads) {
+    ThreadPool thread_pool{4};
+    EXPECT_EQ(thread_pool.get_num_threads(), 4);
+
+    std::atomic<size_t> num_calls{0};
+    std::mutex mutex;
+    std::set<std::thread::id> thread_ids;
+
+    // The same threads run the task again and again.
+    for (auto i = 0; i < 10; i++) {
+        thread_pool.run([&]() {
+            num_calls++;
+
+            std::lock_guard<std::mutex> lock{mutex};
+            thread_ids.insert(std::this_thread::get_id());
+        });
+    }
+
+    EXPECT_EQ(num_calls.load(), 40);
+    EXPECT_EQ(thread_ids.size(), 4);
+    EXPECT_EQ(thread_ids.count(std::this_thread::get_id()), 1);
+}
+
+TEST(ThreadPool, run_task_serially_with_one_thread) {
+    ThreadPool thread_pool{1};
+    EXPECT_EQ(thread_pool.get_num_threads(), 1);
+
+    std::thread::id thread_id;
+    thread_pool.run([&]() { thread_id = std::this_thread::get_id(); });
+
+    EXPECT_EQ(thread_id, std::this_thread::get_id());
+}
@@ -0,0 +1,118 @@
+/// \author Jian Wen
+/// \date 2021/03/03
+
+#include "../src/tracer.hpp"
+
+#include <gtest/gtest.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// \brief The router func that takes a while to route.
+struct SlowRouterFunc {
+    int operator()(int value) const {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return value * 2;
+    }
+};
+
+} // namespace
+
+TEST(Tracer, record_nothing_if_stopped) {
+    auto &tracer = Tracer::get_instance();
+    tracer.start();
+    tracer.stop();
+
+    { TraceSpan span{"untraced"}; }
+
+    EXPECT_TRUE(tracer.get_thread_buffer().events.empty());
+}
+
+TEST(Tracer, record_nested_spans_with_router_time) {
+    auto &tracer = Tracer::get_instance();
+    tracer.start();
+
+    SlowRouterFunc router_func;
+    TracedRouterFunc<SlowRouterFunc> traced_router_func{router_func};
+    {
+        TraceSpan outer_span{"outer"};
+        {
+            TraceSpan inner_span{"inner"};
+            EXPECT_EQ(traced_router_func(21), 42);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    tracer.stop();
+
+    // The inner span ends first, and both spans account for the same router time.
+    const auto &events = tracer.get_thread_buffer().events;
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_STREQ(events[0].name, "inner");
+    EXPECT_STREQ(events[1].name, "outer");
+    EXPECT_GE(events[0].start_ns, events[1].start_ns);
+    EXPECT_LE(events[0].start_ns + events[0].duration_ns,
+              events[1].start_ns + events[1].duration_ns);
+    EXPECT_GE(events[0].router_ns, 2000000);
+    EXPECT_EQ(events[1].router_ns, events[0].router_ns);
+    EXPECT_GE(events[1].duration_ns, events[1].router_ns + 2000000);
+}
+
+TEST(Tracer, write_spans_of_all_threads_as_chrome_trace) {
+    auto &tracer = Tracer::get_instance();
+    tracer.start();
+
+    { TraceSpan span{"main"}; }
+    const auto main_thread_index = tracer.get_thread_buffer().thread_index;
+
+    // The worker threads run one after another, so they share the same buffer.
+    for (auto i = 0; i < 2; i++) {
+        std::thread worker{[]() { TraceSpan span{"worker"}; }};
+        worker.join();
+    }
+    tracer.stop();
+
+    const std::string path = "tracer_test.json";
+    tracer.write_trace(path);
+
+    // The json is parsed as yaml, of which it is a subset.
+    const auto trace = YAML::LoadFile(path);
+    std::remove(path.c_str());
+
+    std::vector<size_t> worker_thread_indices;
+    std::vector<size_t> named_thread_indices;
+    auto num_main_spans = 0;
+    for (const auto &trace_event : trace["traceEvents"]) {
+        const auto phase = trace_event["ph"].as<std::string>();
+        const auto name = trace_event["name"].as<std::string>();
+        const auto thread_index = trace_event["tid"].as<size_t>();
+
+        if (phase == "M") {
+            EXPECT_EQ(name, "thread_name");
+            named_thread_indices.emplace_back(thread_index);
+        } else if (name == "main") {
+            EXPECT_EQ(phase, "X");
+            EXPECT_EQ(thread_index, main_thread_index);
+            EXPECT_GE(trace_event["dur"].as<double>(), 0.0);
+            EXPECT_FALSE(trace_event["args"]);
+            num_main_spans++;
+        } else if (name == "worker") {
+            worker_thread_indices.emplace_back(thread_index);
+        }
+    }
+
+    EXPECT_EQ(num_main_spans, 1);
+    ASSERT_EQ(worker_thread_indices.size(), 2);
+    EXPECT_EQ(worker_thread_indices[0], worker_thread_indices[1]);
+    EXPECT_NE(worker_thread_indices[0], main_thread_index);
+    EXPECT_NE(std::find(named_thread_indices.begin(),
+                        named_thread_indices.end(),
+                        worker_thread_indices[0]),
+              named_thread_indices.end());
+}
@@ -0,0 +1,43 @@
+/// \author Jian Wen
+/// \date 2021/02/19
+
+#include "../src/trip_replayer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+TEST(TripReplayer, replay_requests_til_target_time) {
+    const std::string path = "trip_replayer_test.trips";
+
+    std::vector<Request> requests;
+    for (auto i = 0; i < 100000; i++) {
+        requests.push_back({Pos{1.0f * i, 2.0f}, Pos{3.0f, 1.0f * i}, 100ul * i});
+    }
+    write_trip_file(path, requests);
+
+    {
+        TripReplayer trip_replayer{path};
+        EXPECT_EQ(trip_replayer.get_num_trips(), 100000);
+
+        auto replayed_requests = trip_replayer(0);
+        EXPECT_EQ(replayed_requests.size(), 1);
+
+        replayed_requests = trip_replayer(250);
+        ASSERT_EQ(replayed_requests.size(), 2);
+        EXPECT_EQ(replayed_requests[1].request_time_ms, 200);
+        EXPECT_EQ(replayed_requests[1].origin.lon, 2.0f);
+        EXPECT_EQ(replayed_requests[1].destination.lat, 2.0f);
+
+        // The replayer can be moved into the platform after some requests have been replayed.
+        auto moved_trip_replayer = std::move(trip_replayer);
+        EXPECT_EQ(moved_trip_replayer(250).size(), 0);
+
+        replayed_requests = moved_trip_replayer(100ul * 100000);
+        ASSERT_EQ(replayed_requests.size(), 100000 - 3);
+        EXPECT_EQ(replayed_requests.back().request_time_ms, 100ul * 99999);
+        EXPECT_EQ(replayed_requests.back().origin.lon, 99999.0f);
+    }
+
+    std::remove(path.c_str());
+}
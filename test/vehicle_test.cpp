@@ -1,6 +1,7 @@
 /// \author Jian Wen
 /// \date 2021/02/10
 
+#include "../src/geo.hpp"
 #include "../src/vehicle.hpp"
 
 #include <gtest/gtest.h>
@@ -69,6 +70,21 @@ TEST(AdvanceStepByTime, return_correct_answer_scenario_3) {
     EXPECT_DOUBLE_EQ(step.poses[1].lat, 5.0);
 }
 
+TEST(AdvanceStepByTime, return_correct_answer_with_fractional_degrees) {
+    // Real poses differ by a fraction of a degree, which must not be truncated to integers.
+    Step step{10000, 2000, {Pos{114.1, 22.2}, Pos{114.1, 22.3}, Pos{114.2, 22.3}}};
+
+    truncate_step_by_time(step, 500);
+
+    EXPECT_EQ(step.distance_mm, 7500);
+    EXPECT_EQ(step.duration_ms, 1500);
+
+    EXPECT_EQ(step.poses.size(), 3);
+    EXPECT_NEAR(step.poses[0].lon, 114.1, 1e-4);
+    EXPECT_NEAR(step.poses[0].lat, 22.25, 1e-4);
+    EXPECT_NEAR(step.poses[1].lat, 22.3, 1e-4);
+}
+
 TEST(AdvanceLegByTime, return_early_if_time_is_zero) {
     Step step1{10000, 2000, {Pos{0, 0}, Pos{0, 5}, Pos{5, 5}}};
     Step step2{10000, 2000, {Pos{5, 5}, Pos{10, 5}, Pos{10, 10}}};
@@ -335,3 +351,123 @@ TEST(AdvanceVehicleByTime, not_complete_the_second_waypoint) {
 
     EXPECT_EQ(trips[0].dropoff_time_ms, 1008000);
 }
+
+TEST(AdvanceVehicleByTime, complete_the_waypoints_taking_no_time) {
+    Step step{10000, 2000, {Pos{0, 0}, Pos{0, 5}, Pos{5, 5}}};
+    Route route{10000, 2000, {Leg{10000, 2000, {step}}}};
+
+    Waypoint waypoint1{Pos{0, 0}, WaypointOp::PICKUP, 0, Route{0, 0, {}}};
+    Waypoint waypoint2{Pos{5, 5}, WaypointOp::DROPOFF, 0, route};
+
+    Vehicle vehicle{0, Pos{0, 0}, 2, 0, {waypoint1, waypoint2}, 0, 0};
+
+    std::vector<Trip> trips = {Trip{}};
+
+    // The pickup right where the vehicle is completes even if no time passes.
+    advance_vehicle(vehicle, trips, 1000000, 0);
+
+    EXPECT_EQ(vehicle.load, 1);
+    EXPECT_EQ(trips[0].pickup_time_ms, 1000000);
+
+    EXPECT_EQ(vehicle.waypoints.size(), 1);
+    EXPECT_EQ(vehicle.waypoints[0].route.duration_ms, 2000);
+}
+
+TEST(BuildRouteTrack, flatten_legs_with_cumulative_offsets) {
+    Step step1{10000, 2000, {Pos{0, 0}, Pos{0, 5}, Pos{5, 5}}};
+    Step step2{10000, 2000, {Pos{5, 5}, Pos{10, 5}, Pos{10, 10}}};
+    Leg leg{20000, 4000, {step1, step2}};
+    Route route{20000, 4000, {leg}};
+
+    build_route_track(route);
+
+    EXPECT_TRUE(route.legs.empty());
+
+    EXPECT_EQ(route.poses.size(), 5);
+    EXPECT_DOUBLE_EQ(route.poses[2].lon, 5.0);
+    EXPECT_DOUBLE_EQ(route.poses[2].lat, 5.0);
+
+    EXPECT_EQ(route.time_offsets_ms, (std::vector<int32_t>{0, 1000, 2000, 3000, 4000}));
+    EXPECT_EQ(route.distance_offsets_mm, (std::vector<int32_t>{0, 5000, 10000, 15000, 20000}));
+}
+
+TEST(BuildRouteTrack, interpolate_offsets_with_fractional_degrees) {
+    Step step{10000, 2000, {Pos{114.1, 22.2}, Pos{114.1, 22.3}, Pos{114.2, 22.3}}};
+    Route route{10000, 2000, {Leg{10000, 2000, {step}}}};
+
+    build_route_track(route);
+
+    ASSERT_EQ(route.poses.size(), 3);
+    EXPECT_NEAR(route.time_offsets_ms[1], 1000, 1);
+    EXPECT_EQ(route.time_offsets_ms[2], 2000);
+    EXPECT_NEAR(route.distance_offsets_mm[1], 5000, 5);
+    EXPECT_EQ(route.distance_offsets_mm[2], 10000);
+}
+
+TEST(AdvanceRouteByTime, move_cursor_without_truncating_the_polyline) {
+    Step step1{10000, 2000, {Pos{0, 0}, Pos{0, 5}, Pos{5, 5}}};
+    Step step2{10000, 2000, {Pos{5, 5}, Pos{10, 5}, Pos{10, 10}}};
+    Leg leg{20000, 4000, {step1, step2}};
+    Route route{20000, 4000, {leg}};
+
+    advance_route_by_time(route, 500);
+
+    EXPECT_EQ(route.poses.size(), 5);
+    EXPECT_EQ(route.cursor, 0);
+    EXPECT_EQ(route.distance_mm, 17500);
+    EXPECT_EQ(route.duration_ms, 3500);
+    EXPECT_DOUBLE_EQ(get_current_pos_on_route(route).lon, 0.0);
+    EXPECT_DOUBLE_EQ(get_current_pos_on_route(route).lat, 2.5);
+
+    advance_route_by_time(route, 2000);
+
+    EXPECT_EQ(route.poses.size(), 5);
+    EXPECT_EQ(route.cursor, 2);
+    EXPECT_EQ(route.distance_mm, 7500);
+    EXPECT_EQ(route.duration_ms, 1500);
+    EXPECT_DOUBLE_EQ(get_current_pos_on_route(route).lon, 7.5);
+    EXPECT_DOUBLE_EQ(get_current_pos_on_route(route).lat, 5.0);
+}
+
+TEST(SimplifyPolyline, keep_poses_beyond_the_tolerance) {
+    // The middle pos is ~11m off the straight line, and the others ~5.5m off the simplified one.
+    const std::vector<Pos> poses{Pos{114.000, 22.3},
+                                 Pos{114.001, 22.3},
+                                 Pos{114.002, 22.3001},
+                                 Pos{114.003, 22.3},
+                                 Pos{114.004, 22.3}};
+
+    EXPECT_EQ(simplify_polyline(poses, 1).size(), 5);
+    EXPECT_EQ(simplify_polyline(poses, 20).size(), 2);
+
+    const auto simplified_poses = simplify_polyline(poses, 10);
+    ASSERT_EQ(simplified_poses.size(), 3);
+    EXPECT_FLOAT_EQ(simplified_poses[1].lon, 114.002);
+    EXPECT_FLOAT_EQ(simplified_poses[1].lat, 22.3001);
+    EXPECT_FLOAT_EQ(simplified_poses[2].lon, 114.004);
+}
+
+TEST(SimplifyRoute, keep_the_ends_and_totals_of_steps) {
+    Step step1{10000, 2000, {Pos{114, 22.300}, Pos{114, 22.301}, Pos{114, 22.302}}};
+    Step step2{10000, 2000, {Pos{114, 22.302}, Pos{114.001, 22.302}, Pos{114.002, 22.302}}};
+    Leg leg{20000, 4000, {step1, step2}};
+    Route route{20000, 4000, {leg}};
+
+    simplify_route(route, 1);
+
+    const auto &steps = route.legs[0].steps;
+    EXPECT_EQ(steps[0].poses.size(), 2);
+    EXPECT_EQ(steps[0].distance_mm, 10000);
+    EXPECT_EQ(steps[0].duration_ms, 2000);
+    EXPECT_EQ(steps[1].poses.size(), 2);
+    EXPECT_FLOAT_EQ(steps[1].poses[0].lat, 22.302);
+    EXPECT_FLOAT_EQ(steps[1].poses[1].lon, 114.002);
+
+    // The vehicle moves along the simplified route as along the original one.
+    advance_route_by_time(route, 1000);
+
+    EXPECT_EQ(route.poses.size(), 3);
+    EXPECT_EQ(route.distance_mm, 15000);
+    EXPECT_FLOAT_EQ(get_current_pos_on_route(route).lon, 114);
+    EXPECT_FLOAT_EQ(get_current_pos_on_route(route).lat, 22.301);
+}
@@ -0,0 +1,105 @@
+/// \author Jian Wen
+/// \date 2021/02/28
+
+#include "../src/video_renderer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+namespace {
+
+RenderConfig create_render_config() {
+    RenderConfig render_config;
+    render_config.area_config = {0, 10, 0, 10};
+    render_config.image_width = 100;
+    render_config.image_height = 100;
+    render_config.main_sim_start_time_ms = 1000;
+    render_config.frame_interval_ms = 1000;
+    render_config.pixels_per_point = 1;
+
+    return render_config;
+}
+
+} // namespace
+
+TEST(RenderFrameDecoder, decode_vehicles_and_trips) {
+    const std::string path = "video_renderer_test.bin";
+
+    Route route;
+    route.poses = {Pos{1, 1}, Pos{1, 9}, Pos{9, 9}};
+    route.time_offsets_ms = {0, 1000, 2000};
+    route.distance_offsets_mm = {0, 1000, 2000};
+
+    Vehicle vehicle{0, Pos{1, 1}, 2, 0};
+    for (size_t i = 0; i < 4; i++) {
+        vehicle.waypoints.push_back({Pos{9, 9}, WaypointOp::PICKUP, i, route});
+    }
+
+    // One trip requested in the warm-up and two after, one of which walked away.
+    std::vector<Trip> trips{{0, Pos{2, 2}, Pos{8, 8}, TripStatus::DROPPED_OFF, 0},
+                            {1, Pos{5, 5}, Pos{8, 8}, TripStatus::DISPATCHED, 1000},
+                            {2, Pos{6, 4}, Pos{8, 8}, TripStatus::WALKAWAY, 2000}};
+
+    {
+        BinaryDatalogWriter datalog_writer{path};
+        DatalogFrame frame;
+
+        capture_datalog_frame(frame, 2000, {vehicle}, trips);
+        datalog_writer.write_frame(frame);
+
+        trips[1].status = TripStatus::DROPPED_OFF;
+        capture_datalog_frame(frame, 4000, {vehicle}, trips);
+        datalog_writer.write_frame(frame);
+    }
+
+    {
+        BinaryDatalogReader datalog_reader{path};
+        RenderFrameDecoder frame_decoder{datalog_reader, create_render_config()};
+        RenderFrame frame;
+
+        ASSERT_TRUE(frame_decoder.decode_next_frame(frame));
+        EXPECT_EQ(frame.system_time_ms, 2000);
+        ASSERT_EQ(frame.vehicle_points.size(), 1);
+        EXPECT_FLOAT_EQ(frame.vehicle_points[0].x, 10);
+        EXPECT_FLOAT_EQ(frame.vehicle_points[0].y, 90);
+
+        // Only the first three of the four waypoints.
+        ASSERT_EQ(frame.waypoint_ends.size(), 1);
+        EXPECT_EQ(frame.waypoint_ends[0], 3);
+        EXPECT_EQ(frame.waypoint_point_ends[2], 9);
+        EXPECT_FLOAT_EQ(frame.waypoint_points[1].y, 10);
+
+        ASSERT_EQ(frame.dispatched_trip_points.size(), 1);
+        EXPECT_FLOAT_EQ(frame.dispatched_trip_points[0].x, 50);
+        ASSERT_EQ(frame.walked_away_trip_points.size(), 1);
+        EXPECT_FLOAT_EQ(frame.walked_away_trip_points[0].x, 60);
+        EXPECT_EQ(frame.num_requested_trips, 2);
+        EXPECT_EQ(frame.num_accepted_trips, 1);
+        EXPECT_EQ(frame.num_completed_trips, 0);
+
+        // The walked away trip is no longer shown, and the dispatched trip is completed.
+        ASSERT_TRUE(frame_decoder.decode_next_frame(frame));
+        EXPECT_EQ(frame.system_time_ms, 4000);
+        EXPECT_TRUE(frame.dispatched_trip_points.empty());
+        EXPECT_TRUE(frame.walked_away_trip_points.empty());
+        EXPECT_EQ(frame.num_requested_trips, 2);
+        EXPECT_EQ(frame.num_accepted_trips, 1);
+        EXPECT_EQ(frame.num_completed_trips, 1);
+
+        EXPECT_FALSE(frame_decoder.decode_next_frame(frame));
+
+        // The first vehicle is rendered in red over the background.
+        const Image background{100, 100, std::vector<uint8_t>(100 * 100 * 3, 255)};
+        Image image = background;
+        Rasterizer rasterizer{image};
+        render_frame(rasterizer, background, frame, create_render_config());
+
+        const auto pixel = &image.pixels[(90 * 100 + 10) * 3];
+        EXPECT_GT(pixel[0], pixel[1]);
+        EXPECT_GT(pixel[0], pixel[2]);
+        EXPECT_LT(pixel[1], 255);
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,42 @@
+/// \author Jian Wen
+/// \date 2021/02/24
+
+#include "../src/geo.hpp"
+#include "../src/zone.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+TEST(ZoneGrid, get_zone_index_row_by_row) {
+    const ZoneGrid zone_grid{{114.0, 114.4, 22.0, 22.2}, 4, 2};
+
+    EXPECT_EQ(get_zone_index(zone_grid, Pos{114.05, 22.05}), 0);
+    EXPECT_EQ(get_zone_index(zone_grid, Pos{114.35, 22.05}), 3);
+    EXPECT_EQ(get_zone_index(zone_grid, Pos{114.05, 22.15}), 4);
+    EXPECT_EQ(get_zone_index(zone_grid, Pos{114.25, 22.15}), 6);
+
+    // Poses on or out of the boundary are clamped to the zones on the boundary.
+    EXPECT_EQ(get_zone_index(zone_grid, Pos{114.4, 22.2}), 7);
+    EXPECT_EQ(get_zone_index(zone_grid, Pos{113.9, 22.3}), 4);
+}
+
+TEST(ZoneGrid, get_distance_to_inner_borders_only) {
+    // A single zone has no border.
+    EXPECT_TRUE(std::isinf(
+        get_distance_to_zone_border_m(ZoneGrid{{114.0, 114.4, 22.0, 22.2}, 1, 1}, {114.2, 22.1})));
+
+    const ZoneGrid zone_grid{{114.0, 114.4, 22.0, 22.2}, 2, 1};
+
+    // Close to the area boundary in the west, but farther from the border in the east.
+    const Pos pos{114.01, 22.1};
+    EXPECT_NEAR(get_distance_to_zone_border_m(zone_grid, pos),
+                get_haversine_distance_m(pos, Pos{114.2, 22.1}),
+                1.0);
+
+    // Close to the border in the west.
+    const Pos pos_east{114.21, 22.19};
+    EXPECT_NEAR(get_distance_to_zone_border_m(zone_grid, pos_east),
+                get_haversine_distance_m(pos_east, Pos{114.2, 22.19}),
+                1.0);
+}
@@ -0,0 +1,128 @@
+/// \author Jian Wen
+/// \date 2021/02/20
+
+#include "../src/demand_generator.hpp"
+#include "../src/types.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// \brief Load the demand from a csv file with a header line followed by lines of
+/// "origin_lon,origin_lat,destination_lon,destination_lat,trips_per_hour[,...]", where each of the
+/// trips_per_hour columns is the trip intensity in one period. An OD with a single column has the
+/// same trip intensity in all periods.
+DemandGenerator load_demand_csv(const std::string &path_to_csv, uint64_t period_ms) {
+    std::ifstream in{path_to_csv};
+    if (!in) {
+        fmt::print(stderr, "[ERROR] Failed to open the csv file {}!\n", path_to_csv);
+        std::exit(-1);
+    }
+
+    std::vector<Od> ods;
+    std::vector<std::vector<double>> trips_per_hour_by_od;
+    std::vector<size_t> line_numbers;
+    size_t num_periods = 1;
+    std::string line;
+    std::getline(in, line);
+    auto line_number = 1;
+
+    while (std::getline(in, line)) {
+        line_number++;
+
+        if (line.empty()) {
+            continue;
+        }
+
+        Od od;
+        std::vector<double> trips_per_hour;
+        if (!parse_demand_csv_line(line, od, trips_per_hour)) {
+            fmt::print(stderr,
+                       "[ERROR] Failed to parse line {} of the csv file {}: \"{}\"!\n",
+                       line_number,
+                       path_to_csv,
+                       line);
+            std::exit(-1);
+        }
+        ods.emplace_back(std::move(od));
+
+        num_periods = std::max(num_periods, trips_per_hour.size());
+        trips_per_hour_by_od.emplace_back(std::move(trips_per_hour));
+        line_numbers.emplace_back(line_number);
+    }
+
+    // As in the demand config, the trips per hour of each OD is either a constant or has one value
+    // per period. Padding the shorter ODs would hide broken input.
+    std::vector<std::vector<double>> trips_per_hour_by_period(num_periods,
+                                                              std::vector<double>(ods.size()));
+
+    for (auto i = 0; i < ods.size(); i++) {
+        const auto &trips_per_hour = trips_per_hour_by_od[i];
+
+        if (trips_per_hour.size() != 1 && trips_per_hour.size() != num_periods) {
+            fmt::print(stderr,
+                       "[ERROR] The OD on line {} of the csv file has {} periods instead of 1 or "
+                       "{}!\n",
+                       line_numbers[i],
+                       trips_per_hour.size(),
+                       num_periods);
+            std::exit(-1);
+        }
+
+        for (auto period = 0; period < num_periods; period++) {
+            trips_per_hour_by_period[period][i] =
+                trips_per_hour.size() == 1 ? trips_per_hour[0] : trips_per_hour[period];
+        }
+    }
+
+    return DemandGenerator{std::move(ods), trips_per_hour_by_period, period_ms, 0};
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    // Check the input arugment list.
+    if (argc < 3 || argc > 4) {
+        fmt::print(stderr,
+                   "[ERROR] We need 2 or 3 arguments aside from the program name for correct "
+                   "execution! \n"
+                   "- Usage: <prog name> <arg1> <arg2> <arg3>. \n"
+                   "  <arg1> is the path to the demand config file (*.yml), or to a csv file "
+                   "(*.csv) with a header line followed by lines of \"origin_lon,origin_lat,"
+                   "destination_lon,destination_lat,trips_per_hour[,...]\", one trips_per_hour "
+                   "column per period (or a single one for all periods). \n"
+                   "  <arg2> is the path to the output compiled demand file (*.demand). \n"
+                   "  <arg3> is the length of each period in minutes for the csv file. If not "
+                   "provided, 60 minutes will be used.\n"
+                   "- Example: {} \"./config/demand_demo.yml\" \"./config/demand_demo.demand\"\n",
+                   argv[0]);
+        return -1;
+    }
+
+    const std::string path_to_input = argv[1];
+    const auto period_ms = (argc == 4 ? std::stoull(argv[3]) : 60) * 60 * 1000;
+
+    const auto start_time = std::chrono::system_clock::now();
+
+    const auto demand_generator =
+        path_to_input.size() > 4 && path_to_input.compare(path_to_input.size() - 4, 4, ".csv") == 0
+            ? load_demand_csv(path_to_input, period_ms)
+            : DemandGenerator{path_to_input, 0};
+
+    demand_generator.write_compiled_demand(argv[2]);
+
+    const auto runtime_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now() - start_time)
+                                .count();
+
+    fmt::print("[INFO] Compiled demand from {} into {} in {} ms.\n", argv[1], argv[2], runtime_ms);
+
+    return 0;
+}
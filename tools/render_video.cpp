@@ -0,0 +1,179 @@
+/// \author Jian Wen
+/// \date 2021/02/28
+
+#include "../src/binary_datalog.hpp"
+#include "../src/config.hpp"
+#include "../src/rasterizer.hpp"
+#include "../src/video_renderer.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, const char *argv[]) {
+    // Separate the optional flags from the positional arguments.
+    std::vector<std::string> args;
+    std::string path_to_png_dir;
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (auto i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+
+        if (arg == "--png-dir" && i + 1 < argc) {
+            path_to_png_dir = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else {
+            args.emplace_back(arg);
+        }
+    }
+
+    // Check the input arugment list.
+    if (args.size() != 2) {
+        fmt::print(stderr,
+                   "[ERROR] We need 2 arguments aside from the program name and the flags for "
+                   "correct execution! \n"
+                   "- Usage: <prog name> <arg1> <arg2> [flags]. \n"
+                   "  <arg1> is the path to the platform config file, whose datalog must be "
+                   "binary. \n"
+                   "  <arg2> is the path to the background map image (in png). \n"
+                   "- Flags: \n"
+                   "  --png-dir <path> writes the frames as png files into the directory, instead "
+                   "of encoding the video with ffmpeg. \n"
+                   "  --threads <num> renders the frames with the number of threads, all cores by "
+                   "default. \n"
+                   "- Example: {} \"./config/platform_demo.yml\" \"./media/hongkong.png\"\n",
+                   argv[0]);
+        return -1;
+    }
+
+    const auto platform_config = load_platform_config(args[0]);
+    const auto &datalog_config = platform_config.output_config.datalog_config;
+    const auto &video_config = platform_config.output_config.video_config;
+    if (!datalog_config.output_datalog || !datalog_config.binary || !video_config.render_video) {
+        fmt::print(stderr,
+                   "[ERROR] The simulation must be run with output_datalog, binary and "
+                   "render_video on in order to be able to render video!\n");
+        return -1;
+    }
+
+    const auto background = load_png_image(args[1]);
+    fmt::print("[INFO] Loaded background map image from {}: width={}, height={}.\n",
+               args[1],
+               background.width,
+               background.height);
+
+    const auto render_config =
+        get_render_config(platform_config, background.width, background.height);
+    const auto num_frames =
+        static_cast<size_t>(platform_config.simulation_config.simulation_duration_s /
+                            platform_config.simulation_config.cycle_s) *
+        video_config.frames_per_cycle;
+    const auto fps = 1000.0 / render_config.frame_interval_ms * video_config.replay_speed;
+
+    BinaryDatalogReader datalog_reader{datalog_config.path_to_output_datalog};
+    RenderFrameDecoder frame_decoder{datalog_reader, render_config};
+    fmt::print("[INFO] Rendering video of total {} frames using datalog from {} with {} threads.\n",
+               num_frames,
+               datalog_config.path_to_output_datalog,
+               num_threads);
+
+    // Pipe the raw frames to ffmpeg for encoding, unless the frames are written as png files.
+    std::FILE *ffmpeg_pipe = nullptr;
+    if (path_to_png_dir.empty()) {
+        const auto ffmpeg_command = fmt::format(
+            "ffmpeg -y -loglevel error -f rawvideo -pix_fmt rgb24 -s {}x{} -r {} -i - "
+            "-vf \"pad=ceil(iw/2)*2:ceil(ih/2)*2\" -c:v libx264 -pix_fmt yuv420p \"{}\"",
+            background.width,
+            background.height,
+            fps,
+            video_config.path_to_output_video);
+        ffmpeg_pipe = popen(ffmpeg_command.c_str(), "w");
+        if (ffmpeg_pipe == nullptr) {
+            fmt::print(stderr, "[ERROR] Failed to start ffmpeg with \"{}\"!\n", ffmpeg_command);
+            return -1;
+        }
+    }
+
+    // The frames are decoded in batches in order, rendered in parallel, and then output in order.
+    const auto batch_size = num_threads * 2;
+    std::vector<RenderFrame> frames(batch_size);
+    std::vector<Image> images(batch_size, background);
+    std::vector<std::unique_ptr<Rasterizer>> rasterizers;
+    for (auto &image : images) {
+        rasterizers.emplace_back(std::make_unique<Rasterizer>(image));
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    size_t num_rendered_frames = 0;
+
+    while (num_rendered_frames < num_frames) {
+        size_t num_batch_frames = 0;
+        while (num_batch_frames < batch_size &&
+               num_rendered_frames + num_batch_frames < num_frames &&
+               frame_decoder.decode_next_frame(frames[num_batch_frames])) {
+            num_batch_frames++;
+        }
+        if (num_batch_frames == 0) {
+            fmt::print(stderr, "[ERROR] Reached the end of datalog file before expected!\n");
+            break;
+        }
+
+        // Each thread keeps taking the next frame until all frames in the batch are rendered.
+        std::atomic<size_t> next_frame_index{0};
+        auto render_frames = [&]() {
+            for (auto i = next_frame_index++; i < num_batch_frames; i = next_frame_index++) {
+                render_frame(*rasterizers[i], background, frames[i], render_config);
+
+                if (!path_to_png_dir.empty()) {
+                    const auto frame_number = num_rendered_frames + i;
+                    save_png_image(
+                        fmt::format("{}/frame_{:05d}.png", path_to_png_dir, frame_number),
+                        images[i]);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (auto thread_index = 0; thread_index < std::min(num_threads, num_batch_frames);
+             thread_index++) {
+            threads.emplace_back(render_frames);
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        if (ffmpeg_pipe != nullptr) {
+            for (auto i = 0; i < num_batch_frames; i++) {
+                std::fwrite(images[i].pixels.data(), 1, images[i].pixels.size(), ffmpeg_pipe);
+            }
+        }
+
+        num_rendered_frames += num_batch_frames;
+        fmt::print("[INFO] Rendered Frame {} / {} of video.\n", num_rendered_frames, num_frames);
+    }
+
+    if (ffmpeg_pipe != nullptr && pclose(ffmpeg_pipe) != 0) {
+        fmt::print(stderr, "[ERROR] Failed to encode the video with ffmpeg!\n");
+        return -1;
+    }
+
+    const auto runtime_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    fmt::print("[INFO] Video saved at {}. FPS={}, rendered {} frames in {}s ({} frames per "
+               "second).\n",
+               path_to_png_dir.empty() ? video_config.path_to_output_video : path_to_png_dir,
+               fps,
+               num_rendered_frames,
+               runtime_s,
+               num_rendered_frames / runtime_s);
+
+    return num_rendered_frames == num_frames ? 0 : -1;
+}
@@ -0,0 +1,110 @@
+/// \author Jian Wen
+/// \date 2021/02/19
+
+#include "../src/trip_replayer.hpp"
+#include "../src/types.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// \brief Parse a request from a csv line.
+/// \return False if any of the fields is missing or is not a number.
+bool parse_request(const std::string &line, Request &request) {
+    const char *ptr = line.c_str();
+    char *end = nullptr;
+
+    // The request time is a non-negative integer, which strtoull would not check.
+    if (!std::isdigit(static_cast<unsigned char>(*ptr))) {
+        return false;
+    }
+    request.request_time_ms = std::strtoull(ptr, &end, 10);
+
+    // Each of the coordinates follows a comma.
+    for (auto coordinate : {&request.origin.lon,
+                            &request.origin.lat,
+                            &request.destination.lon,
+                            &request.destination.lat}) {
+        if (*end != ',') {
+            return false;
+        }
+        ptr = end + 1;
+        *coordinate = std::strtod(ptr, &end);
+        if (end == ptr) {
+            return false;
+        }
+    }
+
+    // Nothing but the line ending may follow the last field.
+    return *end == '\0' || (*end == '\r' && *(end + 1) == '\0');
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    // Check the input arugment list.
+    if (argc != 3) {
+        fmt::print(stderr,
+                   "[ERROR] We need 2 arguments aside from the program name for correct "
+                   "execution! \n"
+                   "- Usage: <prog name> <arg1> <arg2>. \n"
+                   "  <arg1> is the path to the input csv file, with a header line followed by "
+                   "lines of \"request_time_ms,origin_lon,origin_lat,destination_lon,"
+                   "destination_lat\". \n"
+                   "  <arg2> is the path to the output binary trip file. \n"
+                   "- Example: {} \"./data/trips.csv\" \"./data/trips.trips\"\n",
+                   argv[0]);
+        return -1;
+    }
+
+    std::ifstream in{argv[1]};
+    if (!in) {
+        fmt::print(stderr, "[ERROR] Failed to open the csv file {}!\n", argv[1]);
+        return -1;
+    }
+
+    // Parse the csv file line by line, skipping the header. A malformed line fails the conversion,
+    // rather than turning into a trip at the origin of the coordinates.
+    std::vector<Request> requests;
+    std::string line;
+    std::getline(in, line);
+    auto line_number = 1;
+
+    while (std::getline(in, line)) {
+        line_number++;
+
+        if (line.empty()) {
+            continue;
+        }
+
+        Request request;
+        if (!parse_request(line, request)) {
+            fmt::print(stderr,
+                       "[ERROR] Failed to parse line {} of the csv file {}: \"{}\"!\n",
+                       line_number,
+                       argv[1],
+                       line);
+            return -1;
+        }
+
+        requests.emplace_back(std::move(request));
+    }
+
+    // The recorded trips are not necessarily in order.
+    std::stable_sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) {
+        return a.request_time_ms < b.request_time_ms;
+    });
+
+    write_trip_file(argv[2], requests);
+
+    fmt::print("[INFO] Converted {} trips from {} into {}.\n", requests.size(), argv[1], argv[2]);
+
+    return 0;
+}